@@ -98,6 +98,7 @@ int main(int argc, char* argv[])
 	float elapsed = 0;
 	while (!glfwWindowShouldClose(window))
 	{
+		beginTiming(TIMING_UPDATE);
 		glfwPollEvents();
 
 		float now = (float)glfwGetTime();
@@ -105,7 +106,9 @@ int main(int argc, char* argv[])
 		previous = now;
 
 		elapsed += delta;
+		endTiming(TIMING_UPDATE);
 
+		beginTiming(TIMING_SIMULATE);
 		// Deal with the current frame
 		if (elapsed > timeStep)
 		{
@@ -113,9 +116,12 @@ int main(int argc, char* argv[])
 
 			elapsed = 0;
 		}
+		endTiming(TIMING_SIMULATE);
 
+		beginTiming(TIMING_RENDER);
 		render(window); // Draw one frame
-		glfwSwapBuffers(window); // swap buffers
+		endTiming(TIMING_RENDER);
+		swapBuffers(window); // swap buffers
 	}
 
 	// Terminate the glfw system
@@ -1,10 +1,13 @@
 
 #include "glSetup.h"
+#include "glSphere.h"
 
 #include <Eigen/Dense>
 using namespace Eigen;
 
+#include <string.h>
 #include <iostream>
+#include <vector>
 using namespace std;
 
 void init();
@@ -18,6 +21,7 @@ void render(GLFWwindow* window);
 void setupLight();
 void setupMaterial();
 void drawSphere(float radius, const Vector3f& color, int N);
+void benchmarkSphereRendering(GLFWwindow* window);
 
 // Play configuration
 bool	pause = true;
@@ -37,11 +41,22 @@ GLfloat bgColor[4] = { 1, 1, 1, 1 };
 // Sphere
 GLUquadricObj* sphere = NULL;
 
-// Particles
-const int	nParticles = 100;
-Vector3f	x[nParticles];	// Particle position
-Vector3f	v[nParticles];	// Particle velocity
-Vector3f	c[nParticles];	// Particle color
+// Sphere rendering: one draw call for all the particles except for the quadrics
+enum SphereRendering
+{
+	QUADRIC_SPHERES = 0,
+	INSTANCED_MESH,
+	IMPOSTORS,			// Ray-cast billboards of 4 vertices
+};
+SphereRendering sphereRendering = INSTANCED_MESH;	// Toggled with r
+const char*	sphereRenderingName[3] = { "quadric", "instanced mesh", "impostor" };
+InstancedSpheres	spheres;
+
+// Particles: the number can be given in the command line as -n 100000
+int					nParticles = 100;
+vector<Vector3f>	x;	// Particle position
+vector<Vector3f>	v;	// Particle velocity
+vector<Vector3f>	c;	// Particle color
 
 // Geometry and mass
 float	radius = 0.02f;			// 2cm
@@ -70,6 +85,10 @@ enum IntegrationMethod
 int
 main(int argc, char* argv[])
 {
+	// Number of particles
+	for (int i = 1; i < argc - 1; i++)
+		if (strcmp(argv[i], "-n") == 0) nParticles = max(atoi(argv[i + 1]), 1);
+
 	// Vertical sync on
 	vsync = 1;
 
@@ -106,6 +125,7 @@ main(int argc, char* argv[])
 	float	elapsed = 0;
 	while (!glfwWindowShouldClose(window))
 	{
+		beginTiming(TIMING_UPDATE);
 		glfwPollEvents();				// Events
 
 		// Time passed during a single loop
@@ -115,7 +135,9 @@ main(int argc, char* argv[])
 
 		// Time passed after the previous frame
 		elapsed += delta;
+		endTiming(TIMING_UPDATE);
 
+		beginTiming(TIMING_SIMULATE);
 		// Deal with the currnet frame
 		if (elapsed > timeStep)
 		{
@@ -123,9 +145,12 @@ main(int argc, char* argv[])
 
 			elapsed = 0;	// Reset the elapsed time
 		}
+		endTiming(TIMING_SIMULATE);
 
+		beginTiming(TIMING_RENDER);
 		render(window);				// Draw one frame
-		glfwSwapBuffers(window); 	// Swap buffers
+		endTiming(TIMING_RENDER);
+		swapBuffers(window); 	// Swap buffers
 	}
 
 	// Finalization
@@ -144,6 +169,10 @@ initializeParticleSystem()
 	// To generate the same random values at each execution
 	srand(0);
 
+	x.resize(nParticles);
+	v.resize(nParticles);
+	c.resize(nParticles);
+
 	// Initialize particles with random positions and velocities
 	for (int i = 0; i < nParticles; i++)
 	{
@@ -174,6 +203,13 @@ initializeParticleSystem()
 
 	// Collision handling
 	collisionHandling();
+
+	// Radii and colors do not change during the simulation
+	if (spheres.program)
+	{
+		vector<float>	radii(nParticles, radius);
+		uploadInstances(spheres, nParticles, x[0].data(), radii.data(), c[0].data());
+	}
 }
 
 //  Լ 
@@ -266,6 +302,16 @@ init()
 	gluQuadricOrientation(sphere, GLU_OUTSIDE);
 	gluQuadricTexture(sphere, GL_FALSE);
 
+	// Instanced spheres and impostors falling back to the quadrics when unsupported
+	if (!createInstancedSpheres(spheres, 20, "sv10_instanced_sphere.glsl",
+		"sf10_instanced_sphere.glsl") ||
+		!createSphereImpostors(spheres, "sv10_sphere_impostor.glsl", "sf10_sphere_impostor.glsl"))
+	{
+		cerr << "Instanced spheres are not available" << endl;
+		deleteInstancedSpheres(spheres);
+		sphereRendering = QUADRIC_SPHERES;
+	}
+
 	// Keyboard and mouse
 	cout << "Keyboard input: space for play/pause" << endl;
 	cout << "Keyboard Input: g for gravity on/off" << endl;
@@ -273,6 +319,8 @@ init()
 	cout << "Keyboard Input: e for the Euler integration" << endl;
 	cout << "Keyboard Input: m for the modified Euler integration" << endl;
 	cout << "Keyboard Input: [1:9] for the # of sub-time steps" << endl;
+	cout << "Keyboard Input: r for quadric/instanced mesh/impostor spheres" << endl;
+	cout << "Keyboard Input: b for the sphere rendering benchmark" << endl;
 }
 
 void
@@ -280,6 +328,9 @@ quit()
 {
 	// Delete quadric shapes
 	gluDeleteQuadric(sphere);
+
+	// Delete the instanced spheres
+	deleteInstancedSpheres(spheres);
 }
 
 // Light
@@ -349,13 +400,55 @@ render(GLFWwindow* window)
 	setupMaterial();
 
 	// Particles
-	for (int i = 0; i < nParticles; i++)
+	if (sphereRendering == QUADRIC_SPHERES)
 	{
-		glPushMatrix();
-		glTranslatef(x[i][0], x[i][1], x[i][2]);
-		drawSphere(radius, c[i], 20);
-		glPopMatrix();
+		for (int i = 0; i < nParticles; i++)
+		{
+			glPushMatrix();
+			glTranslatef(x[i][0], x[i][1], x[i][2]);
+			drawSphere(radius, c[i], 20);
+			glPopMatrix();
+		}
 	}
+	else
+	{
+		// Only the positions change every frame
+		uploadInstances(spheres, nParticles, x[0].data(), NULL, NULL);
+
+		if (sphereRendering == INSTANCED_MESH)	drawInstancedSpheres(spheres);
+		else									drawSphereImpostors(spheres);
+	}
+}
+
+// Spheres per millisecond of each sphere rendering mode including the upload of the
+// positions. Run with LIBGL_ALWAYS_SOFTWARE=1 to measure it on Mesa llvmpipe.
+void
+benchmarkSphereRendering(GLFWwindow* window)
+{
+	const int	nFrames = 20;
+
+	cout << "Benchmark: " << nParticles << " spheres on " << glGetString(GL_RENDERER) << endl;
+
+	SphereRendering	current = sphereRendering;
+	int	nModes = spheres.program ? 3 : 1;
+	for (int mode = 0; mode < nModes; mode++)
+	{
+		sphereRendering = SphereRendering(mode);
+
+		// Warming up
+		render(window);
+		glFinish();
+
+		double	start = glfwGetTime();
+		for (int i = 0; i < nFrames; i++)
+			render(window);
+		glFinish();
+
+		double	ms = 1000.0 * (glfwGetTime() - start) / nFrames;
+		cout << "  " << sphereRenderingName[mode] << ": " << ms << " ms/frame, "
+			<< nParticles / ms << " spheres/ms" << endl;
+	}
+	sphereRendering = current;
 }
 
 void
@@ -387,6 +480,13 @@ keyboard(GLFWwindow* window, int key, int scancode, int action, int mods)
 		case GLFW_KEY_E:		intMethod = EULER;			break;
 		case GLFW_KEY_M:		intMethod = MODIFIED_EULER;	break;
 		case GLFW_KEY_P:		intMethod = MID_POINT;	break;
+
+			// Rendering
+		case GLFW_KEY_R:
+			if (spheres.program) sphereRendering = SphereRendering((sphereRendering + 1) % 3);
+			cout << "Sphere rendering: " << sphereRenderingName[sphereRendering] << endl;
+			break;
+		case GLFW_KEY_B:		benchmarkSphereRendering(window);	break;
 		}
 	}
 }
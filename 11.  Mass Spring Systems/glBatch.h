@@ -0,0 +1,51 @@
+#pragma once
+
+#ifndef __GL_BATCH_H_
+#define __GL_BATCH_H_
+
+#include "glShader.h"
+
+// Batched replacement of glBegin()/glEnd() for lines, points and colored polygons
+//
+// The primitives are accumulated in a CPU arena grouped by primitive type and style
+// (line width, point size and stipple), and batchFlush() uploads the whole frame into
+// one streaming vertex buffer and issues a single draw call per group. Line strips and
+// loops are expanded into independent segments, and quads into triangles.
+//
+// Wide lines are expanded into screen-space quads in a geometry shader and the stipple
+// is evaluated in the fragment shader, so that it also works in the core profile where
+// glLineWidth() > 1 and glLineStipple() are not available. The stipple pattern restarts
+// at every segment. Without the shaders, e.g., in an OpenGL 2.1 context, batchFlush()
+// falls back to the immediate mode with the same results.
+
+// Shaders are optional in the compatibility profile
+bool	createBatch(const char* vertexShaderFile, const char* lineGeometryShaderFile,
+	const char* fragmentShaderFile);
+void	deleteBatch();
+
+// Style of the following primitives in pixels of the framebuffer
+void	batchLineWidth(float width);
+void	batchPointSize(float size);
+void	batchLineStipple(int factor, unsigned short pattern);	// 0xFFFF for a solid line
+
+// Transformation applied to the following vertices, identity by default
+void	batchModelView(const float* m);		// Column-major 4x4 matrix or NULL for identity
+void	batchLoadModelView();				// From GL_MODELVIEW_MATRIX in the compatibility profile
+
+// GL_POINTS, GL_LINES, GL_LINE_STRIP, GL_LINE_LOOP, GL_TRIANGLES or GL_QUADS
+void	batchBegin(GLenum mode);
+void	batchColor(float r, float g, float b, float a = 1);
+void	batchColor(const float* rgb);
+void	batchVertex(float x, float y, float z = 0);
+void	batchVertex(const float* xyz);
+void	batchEnd();
+
+// Draw all the primitives in the order of their first use and clear the arena.
+// The projection is a column-major 4x4 matrix, or NULL for GL_PROJECTION_MATRIX.
+void	batchFlush(const float* projection);
+
+// # of vertices and draw calls of the last flush
+int		batchNumVertices();
+int		batchNumDrawCalls();
+
+#endif	// __GL_BATCH_H_
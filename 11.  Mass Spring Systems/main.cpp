@@ -1,10 +1,13 @@
 #include "glSetup.h"
+#include "glSphere.h"
+#include "glBatch.h"
 
 #include <Eigen/Dense>
 
 using namespace Eigen;
 
 #include <iostream>
+#include <vector>
 using namespace std;
 
 void init();
@@ -37,6 +40,18 @@ GLfloat bgColor[4] = { 1,1,1,1 };
 // Sphere
 GLUquadricObj* sphere = NULL;
 
+// Sphere rendering: one draw call for all the particles except for the quadrics
+enum SphereRendering
+{
+	QUADRIC_SPHERES = 0,
+	INSTANCED_MESH,
+	IMPOSTORS,			// Ray-cast billboards of 4 vertices
+};
+SphereRendering sphereRendering = INSTANCED_MESH;	// Toggled with r
+const char*	sphereRenderingName[3] = { "quadric", "instanced mesh", "impostor" };
+InstancedSpheres	spheres;
+vector<Vector3f>	instanceColor;		// Colors uploaded last
+
 // Particles
 const int nParticles = 4;
 Vector3f	x[nParticles]; // Particle position
@@ -120,6 +135,7 @@ int main(int argc, char* argv[])
 	float elapsed = 0;
 	while (!glfwWindowShouldClose(window))
 	{
+		beginTiming(TIMING_UPDATE);
 		glfwPollEvents(); // Events
 
 		// Time passed during a single loop
@@ -129,7 +145,9 @@ int main(int argc, char* argv[])
 
 		// Time passed after the previous frame
 		elapsed += delta;
+		endTiming(TIMING_UPDATE);
 
+		beginTiming(TIMING_SIMULATE);
 		// Deal with the current frame
 		if (elapsed > timeStep)
 		{
@@ -137,9 +155,12 @@ int main(int argc, char* argv[])
 
 			elapsed = 0; // Rest the elapsed time
 		}
+		endTiming(TIMING_SIMULATE);
 
+		beginTiming(TIMING_RENDER);
 		render(window);
-		glfwSwapBuffers(window);
+		endTiming(TIMING_RENDER);
+		swapBuffers(window);
 	}
 
 	//Finalization
@@ -212,6 +233,12 @@ void quit()
 {
 	// Delete quadric shapes
 	gluDeleteQuadric(sphere);
+
+	// Delete the instanced spheres
+	deleteInstancedSpheres(spheres);
+
+	// Delete the batched lines
+	deleteBatch();
 }
 
 void update(float delta_t)
@@ -352,25 +379,56 @@ void render(GLFWwindow* window)
 	setupMaterial();
 
 	// Particles
-	for (int i = 0; i < nParticles; i++)
+	if (sphereRendering != QUADRIC_SPHERES)
 	{
-		glPushMatrix();
-		glTranslatef(x[i][0], x[i][1], x[i][2]);
-		if (constrained[i]) drawSphere(radius, Vector3f(1, 1, 0), 20);
-		else                drawSphere(radius, Vector3f(0, 1, 0), 20);
-		glPopMatrix();
+		// The radii and colors only when the # of the particles or a constraint has changed
+		bool	resized = (spheres.numInstances != nParticles);
+		bool	recolored = resized;
+
+		instanceColor.resize(nParticles);
+		for (int i = 0; i < nParticles; i++)
+		{
+			Vector3f	color = constrained[i] ? Vector3f(1, 1, 0) : Vector3f(0, 1, 0);
+			if (resized || color != instanceColor[i])
+			{
+				instanceColor[i] = color;
+				recolored = true;
+			}
+		}
+
+		vector<float>	radii;
+		if (resized) radii.assign(nParticles, radius);
+
+		uploadInstances(spheres, nParticles, x[0].data(), resized ? radii.data() : NULL,
+			recolored ? instanceColor[0].data() : NULL);
+
+		if (sphereRendering == INSTANCED_MESH)	drawInstancedSpheres(spheres);
+		else									drawSphereImpostors(spheres);
+	}
+	else
+	{
+		for (int i = 0; i < nParticles; i++)
+		{
+			glPushMatrix();
+			glTranslatef(x[i][0], x[i][1], x[i][2]);
+			if (constrained[i]) drawSphere(radius, Vector3f(1, 1, 0), 20);
+			else                drawSphere(radius, Vector3f(0, 1, 0), 20);
+			glPopMatrix();
+		}
 	}
 
-	// Edges
-	glLineWidth(7 * dpiScaling);
-	glColor3f(0, 0, 1);
-	glBegin(GL_LINES);
+	// Edges with one upload and one draw call
+	batchLineWidth(7 * dpiScaling);
+	batchColor(0, 0, 1);
+	batchBegin(GL_LINES);
 	for (int i = 0; i < nEdges; i++)
 	{
-		glVertex3fv(x[e1[i]].data());
-		glVertex3fv(x[e2[i]].data());
+		batchVertex(x[e1[i]].data());
+		batchVertex(x[e2[i]].data());
 	}
-	glEnd();
+	batchEnd();
+
+	batchFlush(NULL);
 }
 
 void keyboard(GLFWwindow* window, int key, int scancode, int action, int mods)
@@ -392,6 +450,12 @@ void keyboard(GLFWwindow* window, int key, int scancode, int action, int mods)
 
 		case GLFW_KEY_C:		useConst = !useConst; break; // Consts ctrl on/off
 
+			// Rendering
+		case GLFW_KEY_R:
+			if (spheres.program) sphereRendering = SphereRendering((sphereRendering + 1) % 3);
+			cout << "Sphere rendering: " << sphereRenderingName[sphereRendering] << endl;
+			break;
+
 			// Spinrg constants
 		case GLFW_KEY_UP: k0 = min(k0 + 0.1f, 10.0f); rebuildSpringK(); break;
 		case GLFW_KEY_DOWN: k0 = max(k0 - 0.1f, 0.1f); rebuildSpringK(); break;
@@ -448,6 +512,20 @@ init()
 	gluQuadricOrientation(sphere, GLU_OUTSIDE);
 	gluQuadricTexture(sphere, GL_FALSE);
 
+	// Instanced spheres and impostors falling back to the quadrics when unsupported
+	if (!createInstancedSpheres(spheres, 20, "sv11_instanced_sphere.glsl",
+		"sf11_instanced_sphere.glsl") ||
+		!createSphereImpostors(spheres, "sv11_sphere_impostor.glsl", "sf11_sphere_impostor.glsl"))
+	{
+		cerr << "Instanced spheres are not available" << endl;
+		deleteInstancedSpheres(spheres);
+		sphereRendering = QUADRIC_SPHERES;
+	}
+
+	// Batched edges drawn in the immediate mode when the shaders are unsupported
+	if (!createBatch("sv11_batch.glsl", "sg11_batch_line.glsl", "sf11_batch.glsl"))
+		cerr << "Batched lines fall back to the immediate mode" << endl;
+
 	// Keyboard and mouse
 	cout << "Keyboard input: space for play/pause" << endl;
 	cout << "Keyboard Input: g for gravity on/off" << endl;
@@ -460,6 +538,7 @@ init()
 	cout << "Keyboard Input: [1:4] for constraint specification" << endl;
 	cout << "Keyboard Input: up/down to increase/decrease the spring constant" << endl;
 	cout << "Keyboard Input: left/right to increase/decrease the damping constant" << endl;
+	cout << "Keyboard Input: r for quadric/instanced mesh/impostor spheres" << endl;
 }
 
 // Light
@@ -0,0 +1,24 @@
+
+#version 400
+
+in VertexData
+{
+	vec4	color;
+	float	lineDistance;		// Distance along the line segment in pixels
+} inData;
+
+layout (location = 0) out vec4 FragColor;
+
+// Same as glLineStipple(factor, pattern): bit i of the pattern is used for the i-th run
+// of StippleFactor pixels.
+uniform int		StippleFactor = 1;
+uniform int		StipplePattern = 0xFFFF;
+
+void
+main(void)
+{
+	int	bit = int(inData.lineDistance / float(StippleFactor)) & 15;
+	if (((StipplePattern >> bit) & 1) == 0)	discard;
+
+	FragColor = inData.color;
+}
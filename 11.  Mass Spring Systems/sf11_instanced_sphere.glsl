@@ -0,0 +1,9 @@
+#version 120
+
+varying vec4	color;
+
+void
+main(void)
+{
+	gl_FragColor = color;
+}
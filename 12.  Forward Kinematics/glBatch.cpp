@@ -0,0 +1,422 @@
+#include "glBatch.h"
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+using namespace std;
+
+// Attribute locations shared with the batch shaders
+enum
+{
+	VERTEX_POSITION = 0,
+	VERTEX_COLOR = 1,
+};
+
+struct BatchVertex
+{
+	GLfloat	position[3];	// In the view coordinate system
+	GLfloat	color[4];
+};
+
+// Primitives of the same type and style drawn with one call
+struct BatchGroup
+{
+	GLenum	mode;				// GL_POINTS, GL_LINES or GL_TRIANGLES
+	float	size;				// Point size or line width
+	int		stippleFactor;
+	int		stipplePattern;
+
+	int		order;				// Order of the first use in this frame
+	int		first;				// Offset in the vertex buffer
+
+	vector<BatchVertex>	vertex;	// The capacity is reused in the next frames
+};
+
+// Shaders and the streaming vertex buffer
+static GLuint	pointProgram = 0, lineProgram = 0;
+static GLuint	vertexShader = 0, lineGeometryShader = 0, fragmentShader = 0;
+static GLuint	vao = 0, vertexId = 0;
+static GLsizeiptr	bufferSize = 0;
+
+// Current states
+static float	lineWidth = 1, pointSize = 1;
+static int		stippleFactor = 1, stipplePattern = 0xFFFF;
+static GLfloat	modelView[16];
+static bool		identityModelView = true;
+static GLfloat	currentColor[4] = { 1, 1, 1, 1 };
+static GLenum	currentMode = 0;
+
+// Arena
+static vector<BatchGroup>	groups;
+static vector<BatchVertex>	primitive;	// Vertices between batchBegin() and batchEnd()
+static int	numUsedGroups = 0;
+
+// Statistics of the last flush
+static int	numVertices = 0, numDrawCalls = 0;
+
+static bool
+linkBatchProgram(GLuint& program, GLuint geometryShader)
+{
+	program = glCreateProgram();
+	glAttachShader(program, vertexShader);
+	if (geometryShader)	glAttachShader(program, geometryShader);
+	glAttachShader(program, fragmentShader);
+
+	glLinkProgram(program);
+	printProgramInfoLog(program);
+
+	GLint	linked = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+
+	return	linked == GL_TRUE;
+}
+
+bool
+createBatch(const char* vertexShaderFile, const char* lineGeometryShaderFile,
+	const char* fragmentShaderFile)
+{
+	// Geometry shaders require OpenGL 4.0 for the GLSL 4.00 shaders
+	if (!GLEW_VERSION_4_0)	return	false;
+
+	vertexShader = createShaderFromFile(GL_VERTEX_SHADER, vertexShaderFile);
+	lineGeometryShader = createShaderFromFile(GL_GEOMETRY_SHADER, lineGeometryShaderFile);
+	fragmentShader = createShaderFromFile(GL_FRAGMENT_SHADER, fragmentShaderFile);
+	if (vertexShader == 0 || lineGeometryShader == 0 || fragmentShader == 0 ||
+		!linkBatchProgram(pointProgram, 0) ||
+		!linkBatchProgram(lineProgram, lineGeometryShader))
+	{
+		deleteBatch();
+		return	false;
+	}
+
+	glGenVertexArrays(1, &vao);
+	glGenBuffers(1, &vertexId);
+
+	// Interleaved positions and colors
+	glBindVertexArray(vao);
+	glBindBuffer(GL_ARRAY_BUFFER, vertexId);
+
+	glEnableVertexAttribArray(VERTEX_POSITION);
+	glVertexAttribPointer(VERTEX_POSITION, 3, GL_FLOAT, GL_FALSE, sizeof(BatchVertex),
+		(const GLvoid*)offsetof(BatchVertex, position));
+
+	glEnableVertexAttribArray(VERTEX_COLOR);
+	glVertexAttribPointer(VERTEX_COLOR, 4, GL_FLOAT, GL_FALSE, sizeof(BatchVertex),
+		(const GLvoid*)offsetof(BatchVertex, color));
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	return	isOK("createBatch()", __FILE__, __LINE__, false);
+}
+
+void
+deleteBatch()
+{
+	if (pointProgram)		glDeleteProgram(pointProgram);
+	if (lineProgram)		glDeleteProgram(lineProgram);
+	if (vertexShader)		glDeleteShader(vertexShader);
+	if (lineGeometryShader)	glDeleteShader(lineGeometryShader);
+	if (fragmentShader)		glDeleteShader(fragmentShader);
+
+	if (vertexId)	glDeleteBuffers(1, &vertexId);
+	if (vao)		glDeleteVertexArrays(1, &vao);
+
+	pointProgram = lineProgram = 0;
+	vertexShader = lineGeometryShader = fragmentShader = 0;
+	vao = vertexId = 0;
+	bufferSize = 0;
+
+	groups.clear();
+	numUsedGroups = 0;
+}
+
+void	batchLineWidth(float width) { lineWidth = width; }
+void	batchPointSize(float size) { pointSize = size; }
+
+void
+batchLineStipple(int factor, unsigned short pattern)
+{
+	stippleFactor = max(factor, 1);
+	stipplePattern = pattern;
+}
+
+void
+batchModelView(const float* m)
+{
+	identityModelView = (m == NULL);
+	if (m)	copy(m, m + 16, modelView);
+}
+
+void
+batchLoadModelView()
+{
+	glGetFloatv(GL_MODELVIEW_MATRIX, modelView);
+	identityModelView = false;
+}
+
+void
+batchBegin(GLenum mode)
+{
+	currentMode = mode;
+	primitive.clear();
+}
+
+void
+batchColor(float r, float g, float b, float a)
+{
+	currentColor[0] = r;
+	currentColor[1] = g;
+	currentColor[2] = b;
+	currentColor[3] = a;
+}
+
+void	batchColor(const float* rgb) { batchColor(rgb[0], rgb[1], rgb[2]); }
+
+void
+batchVertex(float x, float y, float z)
+{
+	BatchVertex	v;
+	if (identityModelView)
+	{
+		v.position[0] = x;
+		v.position[1] = y;
+		v.position[2] = z;
+	}
+	else
+	{
+		const GLfloat* m = modelView;
+		float	w = m[3] * x + m[7] * y + m[11] * z + m[15];
+		for (int i = 0; i < 3; i++)
+			v.position[i] = (m[i] * x + m[4 + i] * y + m[8 + i] * z + m[12 + i]) / w;
+	}
+	copy(currentColor, currentColor + 4, v.color);
+
+	primitive.push_back(v);
+}
+
+void	batchVertex(const float* xyz) { batchVertex(xyz[0], xyz[1], xyz[2]); }
+
+// Group for the current style
+static BatchGroup&
+findGroup(GLenum mode)
+{
+	float	size = (mode == GL_POINTS) ? pointSize : (mode == GL_LINES) ? lineWidth : 0;
+	int		factor = (mode == GL_LINES) ? stippleFactor : 1;
+	int		pattern = (mode == GL_LINES) ? stipplePattern : 0xFFFF;
+
+	size_t	i = 0;
+	while (i < groups.size() && !(groups[i].mode == mode && groups[i].size == size &&
+		groups[i].stippleFactor == factor && groups[i].stipplePattern == pattern))	i++;
+
+	if (i == groups.size())
+	{
+		groups.push_back(BatchGroup());
+		groups[i].mode = mode;
+		groups[i].size = size;
+		groups[i].stippleFactor = factor;
+		groups[i].stipplePattern = pattern;
+	}
+
+	BatchGroup&	g = groups[i];
+	if (g.vertex.empty())	g.order = numUsedGroups++;
+
+	return	g;
+}
+
+void
+batchEnd()
+{
+	int	n = (int)primitive.size();
+	const vector<BatchVertex>&	p = primitive;
+
+	switch (currentMode)
+	{
+	case GL_POINTS:
+		{
+			vector<BatchVertex>&	v = findGroup(GL_POINTS).vertex;
+			v.insert(v.end(), p.begin(), p.end());
+		}
+		break;
+
+	case GL_LINES:
+		{
+			vector<BatchVertex>&	v = findGroup(GL_LINES).vertex;
+			v.insert(v.end(), p.begin(), p.begin() + (n / 2) * 2);
+		}
+		break;
+
+	case GL_LINE_STRIP:
+	case GL_LINE_LOOP:
+		{
+			vector<BatchVertex>&	v = findGroup(GL_LINES).vertex;
+			for (int i = 1; i < n; i++)
+			{
+				v.push_back(p[i - 1]);
+				v.push_back(p[i]);
+			}
+
+			if (currentMode == GL_LINE_LOOP && n > 2)
+			{
+				v.push_back(p[n - 1]);
+				v.push_back(p[0]);
+			}
+		}
+		break;
+
+	case GL_TRIANGLES:
+		{
+			vector<BatchVertex>&	v = findGroup(GL_TRIANGLES).vertex;
+			v.insert(v.end(), p.begin(), p.begin() + (n / 3) * 3);
+		}
+		break;
+
+	case GL_QUADS:
+		{
+			// Two triangles with the same orientation as the quad
+			vector<BatchVertex>&	v = findGroup(GL_TRIANGLES).vertex;
+			for (int i = 0; i + 3 < n; i += 4)
+			{
+				v.push_back(p[i]);	v.push_back(p[i + 1]);	v.push_back(p[i + 2]);
+				v.push_back(p[i]);	v.push_back(p[i + 2]);	v.push_back(p[i + 3]);
+			}
+		}
+		break;
+
+	default:
+		cerr << "ERROR: batchEnd() does not support the primitive " << currentMode << endl;
+		break;
+	}
+
+	currentMode = 0;
+	primitive.clear();
+}
+
+static bool	isUnusedGroup(const BatchGroup& g) { return g.vertex.empty(); }
+static bool	isUsedBefore(const BatchGroup& a, const BatchGroup& b) { return a.order < b.order; }
+
+// Fixed-function path for the contexts without the batch shaders
+static void
+flushImmediateMode(const float* projection)
+{
+	glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT | GL_LINE_BIT | GL_POINT_BIT);
+	glDisable(GL_LIGHTING);
+	glDisable(GL_TEXTURE_2D);
+
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadMatrixf(projection);
+
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+
+	for (size_t i = 0; i < groups.size(); i++)
+	{
+		const BatchGroup&	g = groups[i];
+		if (g.mode == GL_POINTS)	glPointSize(g.size);
+		if (g.mode == GL_LINES)
+		{
+			glLineWidth(g.size);
+			glLineStipple(g.stippleFactor, (GLushort)g.stipplePattern);
+			if (g.stipplePattern != 0xFFFF)	glEnable(GL_LINE_STIPPLE);
+			else							glDisable(GL_LINE_STIPPLE);
+		}
+
+		glBegin(g.mode);
+		for (size_t j = 0; j < g.vertex.size(); j++)
+		{
+			glColor4fv(g.vertex[j].color);
+			glVertex3fv(g.vertex[j].position);
+		}
+		glEnd();
+	}
+
+	glPopMatrix();
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+
+	glPopAttrib();
+}
+
+void
+batchFlush(const float* projection)
+{
+	GLfloat	P[16];
+	if (projection == NULL)
+	{
+		glGetFloatv(GL_PROJECTION_MATRIX, P);
+		projection = P;
+	}
+
+	// Groups in the order of their first use in this frame
+	groups.erase(remove_if(groups.begin(), groups.end(), isUnusedGroup), groups.end());
+	sort(groups.begin(), groups.end(), isUsedBefore);
+
+	numVertices = numDrawCalls = 0;
+	for (size_t i = 0; i < groups.size(); i++)
+	{
+		groups[i].first = numVertices;
+		numVertices += (int)groups[i].vertex.size();
+	}
+
+	if (numVertices > 0 && pointProgram == 0)
+	{
+		flushImmediateMode(projection);
+		numDrawCalls = (int)groups.size();
+	}
+	else if (numVertices > 0)
+	{
+		// One upload per frame. glBufferData() orphans the storage still used by the GPU,
+		// and the buffer grows geometrically to avoid reallocations in every frame.
+		GLsizeiptr	size = numVertices * sizeof(BatchVertex);
+		if (size > bufferSize)	bufferSize = max(size, 2 * bufferSize);
+
+		glBindBuffer(GL_ARRAY_BUFFER, vertexId);
+		glBufferData(GL_ARRAY_BUFFER, bufferSize, NULL, GL_STREAM_DRAW);
+		for (size_t i = 0; i < groups.size(); i++)
+			glBufferSubData(GL_ARRAY_BUFFER, groups[i].first * sizeof(BatchVertex),
+				groups[i].vertex.size() * sizeof(BatchVertex), &groups[i].vertex[0]);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		// Viewport for the line widths in pixels
+		GLint	viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+
+		setUniformMatrix4fv(pointProgram, "ProjectionMatrix", projection);
+		setUniformMatrix4fv(lineProgram, "ProjectionMatrix", projection);
+		setUniform(lineProgram, "Viewport", Vector2f(float(viewport[2]), float(viewport[3])));
+
+		glEnable(GL_PROGRAM_POINT_SIZE);
+		glBindVertexArray(vao);
+		for (size_t i = 0; i < groups.size(); i++)
+		{
+			const BatchGroup&	g = groups[i];
+			GLuint	program = (g.mode == GL_LINES) ? lineProgram : pointProgram;
+
+			if (g.mode == GL_LINES)	setUniform(program, "LineWidth", g.size);
+			else					setUniform(program, "PointSize", max(g.size, 1.0f));
+			setUniformi(program, "StippleFactor", g.stippleFactor);
+			setUniformi(program, "StipplePattern", g.stipplePattern);
+
+			glUseProgram(program);
+			glDrawArrays(g.mode, g.first, (GLsizei)g.vertex.size());
+			numDrawCalls++;
+		}
+		glBindVertexArray(0);
+		glUseProgram(0);
+		glDisable(GL_PROGRAM_POINT_SIZE);
+
+		isOK("batchFlush()", __FILE__, __LINE__);
+	}
+
+	// Clear the arena keeping the capacity
+	for (size_t i = 0; i < groups.size(); i++)	groups[i].vertex.clear();
+	numUsedGroups = 0;
+}
+
+int	batchNumVertices() { return numVertices; }
+int	batchNumDrawCalls() { return numDrawCalls; }
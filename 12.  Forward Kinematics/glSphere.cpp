@@ -0,0 +1,246 @@
+#include "glSphere.h"
+
+#ifdef _WIN32
+#define _USE_MATH_DEFINES
+#endif
+
+#include <math.h>
+
+#include <iostream>
+using namespace std;
+
+// Attribute locations shared with the instanced sphere shaders
+enum
+{
+	VERTEX_POSITION = 0,
+	VERTEX_NORMAL = 1,
+	INSTANCE_POSITION = 2,
+	INSTANCE_RADIUS = 3,
+	INSTANCE_COLOR = 4,
+};
+
+// Unit sphere with the same parameterization as gluSphere(): the poles are on the z-axis
+static void
+buildUnitSphere(int N, MatrixXf& vertex, ArrayXXi& face)
+{
+	int	slices = N, stacks = N;
+
+	vertex.resize(3, (stacks + 1) * (slices + 1));
+	for (int i = 0; i <= stacks; i++)
+	{
+		float	theta = float(M_PI) * i / stacks;
+		for (int j = 0; j <= slices; j++)
+		{
+			float	phi = 2.0f * float(M_PI) * j / slices;
+			vertex.col(i * (slices + 1) + j) = Vector3f(sin(theta) * cos(phi),
+				sin(theta) * sin(phi), cos(theta));
+		}
+	}
+
+	// Two CCW triangles per quad when seen from the outside
+	face.resize(3, 2 * stacks * slices);
+	int	k = 0;
+	for (int i = 0; i < stacks; i++)
+	{
+		for (int j = 0; j < slices; j++)
+		{
+			int	a = i * (slices + 1) + j;
+			int	b = a + (slices + 1);
+
+			face(0, k) = a;	face(1, k) = b;		face(2, k) = b + 1;	k++;
+			face(0, k) = a;	face(1, k) = b + 1;	face(2, k) = a + 1;	k++;
+		}
+	}
+}
+
+// Per-instance attribute advancing once per sphere
+static void
+setupInstanceAttribute(GLuint location, GLuint bufferId, int size)
+{
+	glBindBuffer(GL_ARRAY_BUFFER, bufferId);
+	glEnableVertexAttribArray(location);
+	glVertexAttribPointer(location, size, GL_FLOAT, GL_FALSE, 0, NULL);
+	glVertexAttribDivisor(location, 1);
+}
+
+// Shaders with the attribute locations bound before linking
+static bool
+createSphereProgram(const char* vertexShaderFile, const char* fragmentShaderFile,
+	GLuint& program, GLuint& vertexShader, GLuint& fragmentShader)
+{
+	vertexShader = createShaderFromFile(GL_VERTEX_SHADER, vertexShaderFile);
+	fragmentShader = createShaderFromFile(GL_FRAGMENT_SHADER, fragmentShaderFile);
+	if (vertexShader == 0 || fragmentShader == 0)	return	false;
+
+	program = glCreateProgram();
+	glAttachShader(program, vertexShader);
+	glAttachShader(program, fragmentShader);
+
+	glBindAttribLocation(program, VERTEX_POSITION, "vPosition");
+	glBindAttribLocation(program, VERTEX_POSITION, "vCorner");
+	glBindAttribLocation(program, VERTEX_NORMAL, "vNormal");
+	glBindAttribLocation(program, INSTANCE_POSITION, "iPosition");
+	glBindAttribLocation(program, INSTANCE_RADIUS, "iRadius");
+	glBindAttribLocation(program, INSTANCE_COLOR, "iColor");
+
+	glLinkProgram(program);
+	printProgramInfoLog(program);
+
+	GLint	linked = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+
+	return	linked == GL_TRUE;
+}
+
+// Per-instance buffers bound to the currently bound vertex array object
+static void
+setupInstanceAttributes(InstancedSpheres& s)
+{
+	if (s.positionId == 0)
+	{
+		glGenBuffers(1, &s.positionId);
+		glGenBuffers(1, &s.radiusId);
+		glGenBuffers(1, &s.colorId);
+	}
+
+	setupInstanceAttribute(INSTANCE_POSITION, s.positionId, 3);
+	setupInstanceAttribute(INSTANCE_RADIUS, s.radiusId, 1);
+	setupInstanceAttribute(INSTANCE_COLOR, s.colorId, 3);
+}
+
+bool
+createInstancedSpheres(InstancedSpheres& s, int N,
+	const char* vertexShaderFile, const char* fragmentShaderFile)
+{
+	if (!createSphereProgram(vertexShaderFile, fragmentShaderFile,
+		s.program, s.vertexShader, s.fragmentShader))	return	false;
+
+	// The unit sphere is uploaded only once. Its normals are its positions.
+	MatrixXf	vertex;
+	ArrayXXi	face;
+	buildUnitSphere(N, vertex, face);
+
+	createVBO(s.vao, s.indexId, s.vertexId, s.normalId);
+	s.numTris = uploadMesh2VBO(face, vertex, vertex, s.vao, s.indexId, s.vertexId, s.normalId);
+
+	glBindVertexArray(s.vao);
+	setupInstanceAttributes(s);
+	glBindVertexArray(0);
+
+	return	isOK("createInstancedSpheres()", __FILE__, __LINE__, false);
+}
+
+bool
+createSphereImpostors(InstancedSpheres& s,
+	const char* vertexShaderFile, const char* fragmentShaderFile)
+{
+	if (!createSphereProgram(vertexShaderFile, fragmentShaderFile,
+		s.impostorProgram, s.impostorVS, s.impostorFS))	return	false;
+
+	// 4 corners as a CCW triangle strip
+	GLfloat	corner[8] = { -1, -1,  1, -1,  -1, 1,  1, 1 };
+
+	glGenVertexArrays(1, &s.impostorVao);
+	glGenBuffers(1, &s.cornerId);
+
+	glBindVertexArray(s.impostorVao);
+
+	glBindBuffer(GL_ARRAY_BUFFER, s.cornerId);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(corner), corner, GL_STATIC_DRAW);
+	glEnableVertexAttribArray(VERTEX_POSITION);
+	glVertexAttribPointer(VERTEX_POSITION, 2, GL_FLOAT, GL_FALSE, 0, NULL);
+
+	setupInstanceAttributes(s);
+
+	glBindVertexArray(0);
+
+	return	isOK("createSphereImpostors()", __FILE__, __LINE__, false);
+}
+
+void
+uploadInstances(InstancedSpheres& s, int n, const float* position,
+	const float* radius, const float* color)
+{
+	// glBufferData() orphans the previous storage, so that it never waits for the GPU.
+	glBindBuffer(GL_ARRAY_BUFFER, s.positionId);
+	glBufferData(GL_ARRAY_BUFFER, n * 3 * sizeof(GLfloat), position, GL_STREAM_DRAW);
+
+	if (radius)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, s.radiusId);
+		glBufferData(GL_ARRAY_BUFFER, n * sizeof(GLfloat), radius, GL_STATIC_DRAW);
+	}
+
+	if (color)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, s.colorId);
+		glBufferData(GL_ARRAY_BUFFER, n * 3 * sizeof(GLfloat), color, GL_STATIC_DRAW);
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	s.numInstances = n;
+
+	isOK("uploadInstances()", __FILE__, __LINE__);
+}
+
+void
+drawInstancedSpheres(const InstancedSpheres& s)
+{
+	if (s.numInstances == 0)	return;
+
+	glUseProgram(s.program);
+	glBindVertexArray(s.vao);
+
+	glDrawElementsInstanced(GL_TRIANGLES, s.numTris * 3, GL_UNSIGNED_INT, NULL,
+		s.numInstances);
+
+	glBindVertexArray(0);
+	glUseProgram(0);
+
+	isOK("drawInstancedSpheres()", __FILE__, __LINE__);
+}
+
+void
+drawSphereImpostors(const InstancedSpheres& s)
+{
+	if (s.numInstances == 0)	return;
+
+	glUseProgram(s.impostorProgram);
+	glBindVertexArray(s.impostorVao);
+
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, s.numInstances);
+
+	glBindVertexArray(0);
+	glUseProgram(0);
+
+	isOK("drawSphereImpostors()", __FILE__, __LINE__);
+}
+
+void
+deleteInstancedSpheres(InstancedSpheres& s)
+{
+	if (s.positionId != 0)
+	{
+		glDeleteBuffers(1, &s.positionId);
+		glDeleteBuffers(1, &s.radiusId);
+		glDeleteBuffers(1, &s.colorId);
+
+		s.positionId = s.radiusId = s.colorId = 0;
+	}
+
+	if (s.cornerId != 0)
+	{
+		glDeleteVertexArrays(1, &s.impostorVao);
+		glDeleteBuffers(1, &s.cornerId);
+
+		s.impostorVao = s.cornerId = 0;
+	}
+
+	deleteVBO(s.vao, s.indexId, s.vertexId, s.normalId);
+	deleteShaders(s.program, s.vertexShader, s.fragmentShader);
+	deleteShaders(s.impostorProgram, s.impostorVS, s.impostorFS);
+
+	s.program = s.vertexShader = s.fragmentShader = 0;
+	s.impostorProgram = s.impostorVS = s.impostorFS = 0;
+	s.numTris = s.numInstances = 0;
+}
@@ -1,10 +1,15 @@
 #include "glSetup.h"
+#include "glSphere.h"
+#include "glBatch.h"
+#include "skinning.h"
+#include "mesh.h"
 
 #include <Eigen/Dense>
 
 using namespace Eigen;
 
 #include <iostream>
+#include <vector>
 using namespace std;
 
 #ifdef _WIN32
@@ -12,12 +17,17 @@ using namespace std;
 #endif
 
 #include <math.h>
+#include <string.h>
 
 void init();
 void quit();
 void keyboard(GLFWwindow* window, int key, int code, int action, int mods);
 void render(GLFWwindow* window);
 
+void initSkin();
+void drawSkin();
+void benchmarkSkinning();
+
 // Light configuration
 Vector4f light(0.0f, 0.0f, 5.0f, 1.0f); // Light position
 
@@ -32,11 +42,30 @@ GLfloat bgColor[4] = { 1,1,1,1 };
 GLUquadricObj* sphere = NULL;
 GLUquadricObj* cylinder = NULL;
 
+// Joint spheres: quadrics or ray-cast impostors drawn in one call at the end of the frame
+bool				useImpostors = false;
+InstancedSpheres	jointSpheres;
+vector<Vector3f>	jointCenter;	// In the eye coordinate system
+vector<float>		jointRadius;
+vector<Vector3f>	jointColor;
+
+// Skin bound to the joints, skinned on the GPU or on the CPU
+bool			showSkin = false;
+bool			gpuSkinning = true;
+SkinningMethod	skinMethod = SKINNING_LBS;
+SkinnedMesh		skin;
+SkinPalette		skinPalette;
+const char*		skinMeshFile = NULL;	// --skin-mesh file.off, or a capsule around the chain
+
 int main(int argc, char* argv[])
 {
 	// Orthographics viewing
 	perspectiveView = false;
 
+	// Mesh of the skin
+	for (int i = 1; i < argc; i++)
+		if (strcmp(argv[i], "--skin-mesh") == 0 && i + 1 < argc) skinMeshFile = argv[++i];
+
 	// Initialize the OpenGL system
 	GLFWwindow* window = initializeOpenGL(argc, argv, bgColor);
 	if (window == NULL) return -1;
@@ -64,9 +93,13 @@ int main(int argc, char* argv[])
 	// Main loop
 	while (!glfwWindowShouldClose(window))
 	{
+		beginTiming(TIMING_RENDER);
 		render(window);          // Draw one frames  
-		glfwSwapBuffers(window); // Swap buffers
+		endTiming(TIMING_RENDER);
+		swapBuffers(window); // Swap buffers
+		beginTiming(TIMING_UPDATE);
 		glfwPollEvents();		 // Events
+		endTiming(TIMING_UPDATE);
 	}
 
 	//Finalization
@@ -96,10 +129,29 @@ init()
 	gluQuadricOrientation(cylinder, GLU_OUTSIDE);
 	gluQuadricTexture(cylinder, GL_FALSE);
 
+	// Sphere impostors for the joints
+	if (!createSphereImpostors(jointSpheres, "sv12_sphere_impostor.glsl",
+		"sf12_sphere_impostor.glsl"))
+	{
+		cerr << "Sphere impostors are not available" << endl;
+		deleteInstancedSpheres(jointSpheres);
+	}
+
+	// Batched axes drawn in the immediate mode when the shaders are unsupported
+	if (!createBatch("sv12_batch.glsl", "sg12_batch_line.glsl", "sf12_batch.glsl"))
+		cerr << "Batched lines fall back to the immediate mode" << endl;
+
+	// Skin bound to the joints in the bind pose
+	initSkin();
+
 	// Keyboard and mouse
 	cout << "Keyboard Input: [1:3] for joint selection" << endl;
 	cout << "Keyboard Input: left/right for adjusting joint angles" << endl;
 	cout << "Keyboard Input: d for damping on/off" << endl;
+	cout << "Keyboard Input: s for the sphere impostors on/off" << endl;
+	cout << "Keyboard Input: k for the skin off/LBS/DQS" << endl;
+	cout << "Keyboard Input: g for skinning on the GPU/CPU" << endl;
+	cout << "Keyboard Input: b for the skinning benchmark" << endl;
 }
 
 
@@ -108,6 +160,15 @@ void quit()
 	// Delete quadric shapes
 	gluDeleteQuadric(sphere);
 	gluDeleteQuadric(cylinder);
+
+	// Delete the sphere impostors
+	deleteInstancedSpheres(jointSpheres);
+
+	// Delete the batched lines
+	deleteBatch();
+
+	// Delete the skin
+	deleteSkinnedMesh(skin);
 }
 
 // Light
@@ -166,8 +227,51 @@ void drawCylinder(float radius,float height, const Vector3f& color)
 	gluCylinder(sphere, radius, radius,height,72,5);
 }
 
+// Queue a sphere centered at p in the current modelview coordinate system
+void queueJointSphere(const Vector3f& p, float radius, const Vector3f& color)
+{
+	Matrix4f	M;
+	glGetFloatv(GL_MODELVIEW_MATRIX, M.data());
+
+	jointCenter.push_back((M * p.homogeneous()).head<3>());
+	jointRadius.push_back(radius * M.col(0).head<3>().norm());
+	jointColor.push_back(color);
+}
+
+// Draw all the queued joint spheres with a single instanced call
+void flushJointSpheres()
+{
+	if (jointCenter.empty()) return;
+
+	// The centers are already in the eye coordinate system
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+
+	uploadInstances(jointSpheres, (int)jointCenter.size(), jointCenter[0].data(),
+		jointRadius.data(), jointColor[0].data());
+	drawSphereImpostors(jointSpheres);
+
+	glPopMatrix();
+
+	jointCenter.clear();
+	jointRadius.clear();
+	jointColor.clear();
+}
+
 void drawJoint(float radius, const Vector3f& color)
 {
+	if (useImpostors)
+	{
+		// Front and rear spheres as 4-vertex impostors
+		queueJointSphere(Vector3f(0, 0, radius), radius, color);
+		queueJointSphere(Vector3f(0, 0, -radius), radius, color);
+
+		// Cylinder
+		drawCylinder(radius, radius, color);
+		return;
+	}
+
 	glPushMatrix();
 
 	// Front sphere
@@ -315,6 +419,15 @@ void render(GLFWwindow* window)
 	
 	if (useOpenGL) drawKinematicModelUsingOpenGL();
 	else           drawKinematicModelUsingEigen();
+
+	// Skin around the joints and links
+	if (showSkin) drawSkin();
+
+	// Joint spheres queued as impostors
+	flushJointSpheres();
+
+	// Axes queued by drawAxes()
+	batchFlush(NULL);
 }
 
 void drawKinematicModelUsingOpenGL()
@@ -418,6 +531,208 @@ Vector3f computeEE()
 	return ee.block<3, 1>(0, 0);
 }
 
+// World transforms of the joints after their rotations as in drawKinematicModelUsingEigen()
+void computeJointTransforms(const float angle[], Matrix4f joint[])
+{
+	Matrix4f T;
+	T.setIdentity();
+	T.block<3, 1>(0, 3) = basePosition;
+
+	Matrix4f T_joint, T_link;
+	for (int i = 0; i < nLinks; i++)
+	{
+		T_joint.setIdentity();
+		T_joint.block<3, 3>(0, 0) = Matrix3f(AngleAxisf(angle[i], Vector3f::UnitZ()));
+		T = T * T_joint;
+		joint[i] = T;
+
+		T_link.setIdentity();
+		T_link.block<3, 1>(0, 3) = Vector3f(0.0, linkLength[i], 0.0);
+		T = T * T_link;
+	}
+}
+
+// Bind pose of the straight chain
+float		bindAngle[nLinks] = { 0, 0, 0 };
+Matrix4f	bindTransform[nLinks];
+
+// Capsule of the radius around the segment from a to a + (0, length, 0): slices around the
+// y-axis and rings from the bottom pole to the top one, capRings of them in each cap
+void createCapsule(const Vector3f& a, float length, float radius, int slices, int rings, int capRings,
+	MatrixXf& vertex, MatrixXf& normal, ArrayXXi& face)
+{
+	vertex.resize(3, (rings + 1) * (slices + 1));
+	normal.resize(3, (rings + 1) * (slices + 1));
+	for (int i = 0; i <= rings; i++)
+	{
+		// Elevation of the normal and the height of the ring
+		float	phi = 0, y = 0;
+		if (i < capRings)
+		{
+			phi = -0.5f * float(M_PI) * (capRings - i) / capRings;
+			y = radius * sin(phi);
+		}
+		else if (i > rings - capRings)
+		{
+			phi = 0.5f * float(M_PI) * (i - (rings - capRings)) / capRings;
+			y = length + radius * sin(phi);
+		}
+		else y = length * (i - capRings) / (rings - 2 * capRings);
+
+		for (int j = 0; j <= slices; j++)
+		{
+			float		theta = 2.0f * float(M_PI) * j / slices;
+			Vector3f	n(cos(phi) * cos(theta), sin(phi), cos(phi) * sin(theta));
+
+			normal.col(i * (slices + 1) + j) = n;
+			vertex.col(i * (slices + 1) + j) = a + Vector3f(radius * n.x(), y, radius * n.z());
+		}
+	}
+
+	// Two CCW triangles per quad when seen from the outside
+	face.resize(3, 2 * rings * slices);
+	int	k = 0;
+	for (int i = 0; i < rings; i++)
+	{
+		for (int j = 0; j < slices; j++)
+		{
+			int	a = i * (slices + 1) + j;
+			int	b = a + (slices + 1);
+
+			face(0, k) = a;		face(1, k) = b;	face(2, k) = a + 1;	k++;
+			face(0, k) = a + 1;	face(1, k) = b;	face(2, k) = b + 1;	k++;
+		}
+	}
+}
+
+void initSkin()
+{
+	MatrixXf	vertex, normal;
+	ArrayXXi	face;
+
+	float	chainLength = 0;
+	for (int i = 0; i < nLinks; i++) chainLength += linkLength[i];
+
+	if (skinMeshFile)
+	{
+		readMesh(skinMeshFile, vertex, normal, face);
+		if (vertex.cols() == 0) cout << "Error: can't read " << skinMeshFile << endl;
+	}
+
+	if (vertex.cols() > 0)
+	{
+		// Bottom of the mesh at the base, and its height along the chain
+		Vector3f	lo = vertex.rowwise().minCoeff(), hi = vertex.rowwise().maxCoeff();
+		Vector3f	origin(0.5f * (lo.x() + hi.x()), lo.y(), 0.5f * (lo.z() + hi.z()));
+		float		scale = chainLength / max(hi.y() - lo.y(), 1.0e-6f);
+
+		vertex = ((vertex.colwise() - origin) * scale).colwise() + basePosition;
+	}
+	else createCapsule(basePosition, chainLength, 0.06f, 256, 400, 32, vertex, normal, face);
+
+	// Bones of the joints in the bind pose
+	Vector3f	boneStart[nLinks], boneEnd[nLinks];
+	computeJointTransforms(bindAngle, bindTransform);
+	for (int i = 0; i < nLinks; i++)
+	{
+		boneStart[i] = bindTransform[i].block<3, 1>(0, 3);
+		boneEnd[i] = boneStart[i] + bindTransform[i].block<3, 1>(0, 1) * linkLength[i];
+	}
+
+	double start = glfwGetTime();
+	bindSkin(skin, vertex, normal, face, nLinks, boneStart, boneEnd);
+	if (!createSkinnedMesh(skin, "sv12_skin.glsl", "sf12_skin.glsl"))
+	{
+		cerr << "Skinning falls back to the CPU" << endl;
+		gpuSkinning = false;
+	}
+	cout << "Skinning: " << skin.restVertex.cols() << " vertices bound to " << nLinks
+		<< " joints in " << (glfwGetTime() - start) * 1000.0 << " ms" << endl;
+}
+
+void computeCurrentPalette(SkinPalette& palette)
+{
+	Matrix4f	world[nLinks];
+	computeJointTransforms(jointAngle, world);
+	computeSkinPalette(nLinks, bindTransform, world, palette);
+}
+
+void drawSkin()
+{
+	computeCurrentPalette(skinPalette);
+
+	// The palette once a frame for the vertex shader, or the vertices skinned here
+	if (gpuSkinning) uploadSkinPalette(skin, skinPalette);
+	else
+	{
+		skinVertices(skin, skinPalette, skinMethod);
+		uploadSkinnedVertices(skin);
+	}
+
+	// The vertices are in the world coordinate system
+	glLoadIdentity();
+	setDiffuseColor(Vector3f(0.95f, 0.75f, 0.6f));
+	drawSkinnedMesh(skin, skinMethod, gpuSkinning);
+}
+
+// Both methods of the current pose on the CPU, scalar and SIMD on a thread and on all the
+// cores, and on the GPU with the rasterizer discarded to time the vertex stage alone
+void benchmarkSkinning()
+{
+	const int	runs = 20;
+	int			n = int(skin.restVertex.cols());
+
+	computeCurrentPalette(skinPalette);
+	cout << "Skinning: " << n << " vertices, " << nLinks << " joints, "
+		<< (skinningSIMD() ? "AVX2" : "no SIMD") << endl;
+
+	for (int m = 0; m < NUM_SKINNING_METHODS; m++)
+	{
+		SkinningMethod	method = SkinningMethod(m);
+
+		for (int simd = 0; simd <= int(skinningSIMD()); simd++)
+		{
+			for (int t = 1; t >= 0; t--)
+			{
+				double start = glfwGetTime();
+				for (int r = 0; r < runs; r++) skinVertices(skin, skinPalette, method, simd != 0, t);
+				double seconds = (glfwGetTime() - start) / runs;
+
+				cout << "  " << skinningName[m] << " CPU " << (simd ? "SIMD" : "scalar") << " on "
+					<< (t ? "1 thread" : "all the cores") << ": " << seconds * 1000.0 << " ms, "
+					<< n / seconds * 1.0e-6 << " M vertices/s" << endl;
+			}
+		}
+
+		if (skin.program == 0 || !(GLEW_VERSION_3_3 || GLEW_ARB_timer_query)) continue;
+
+		uploadSkinPalette(skin, skinPalette);
+
+		GLuint	query;
+		glGenQueries(1, &query);
+		glEnable(GL_RASTERIZER_DISCARD);
+
+		// No other GL_TIME_ELAPSED query may be active, e.g., the one of the frame.
+		suspendGPUTiming();
+
+		drawSkinnedMesh(skin, method, true);	// Warm-up
+		glBeginQuery(GL_TIME_ELAPSED, query);
+		for (int r = 0; r < runs; r++) drawSkinnedMesh(skin, method, true);
+		glEndQuery(GL_TIME_ELAPSED);
+
+		glDisable(GL_RASTERIZER_DISCARD);
+
+		GLuint64	elapsed = 0;
+		glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+		glDeleteQueries(1, &query);
+		resumeGPUTiming();
+
+		double seconds = elapsed * 1.0e-9 / runs;
+		cout << "  " << skinningName[m] << " GPU: " << seconds * 1000.0 << " ms, "
+			<< n / seconds * 1.0e-6 << " M vertices/s" << endl;
+	}
+}
+
 
 void keyboard(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
@@ -440,6 +755,29 @@ void keyboard(GLFWwindow* window, int key, int scancode, int action, int mods)
 	
 		//Drawing method
 		case GLFW_KEY_D: useOpenGL= !useOpenGL; break;
+
+		// Joint spheres
+		case GLFW_KEY_S:
+			useImpostors = !useImpostors && jointSpheres.impostorProgram;
+			cout << "Sphere impostors " << (useImpostors ? "on" : "off") << endl;
+			break;
+
+		// Skinning
+		case GLFW_KEY_K:
+			if (!showSkin)
+			{
+				showSkin = true;
+				skinMethod = SKINNING_LBS;
+			}
+			else if (skinMethod == SKINNING_LBS) skinMethod = SKINNING_DQS;
+			else showSkin = false;
+			cout << "Skin " << (showSkin ? skinningName[skinMethod] : "off") << endl;
+			break;
+		case GLFW_KEY_G:
+			gpuSkinning = !gpuSkinning && skin.program;
+			cout << "Skinning on the " << (gpuSkinning ? "GPU" : "CPU") << endl;
+			break;
+		case GLFW_KEY_B: benchmarkSkinning(); break;
 		}
 	}
 }
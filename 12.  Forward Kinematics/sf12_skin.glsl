@@ -0,0 +1,35 @@
+#version 150 compatibility
+
+in vec3	position;
+in vec3	normal;
+
+// Same as the fixed-function lighting with GL_LIGHT0 and the front material
+vec4
+lighting(vec3 P, vec3 N)
+{
+	vec4	c = gl_FrontMaterial.ambient * (gl_LightModel.ambient + gl_LightSource[0].ambient);
+
+	// Positional or directional light in the eye coordinate system
+	vec4	lp = gl_LightSource[0].position;
+	vec3	L = normalize(lp.xyz - P * lp.w);
+
+	float	lambertian = max(dot(N, L), 0.0);
+	c.rgb += lambertian * gl_FrontMaterial.diffuse.rgb * gl_LightSource[0].diffuse.rgb;
+
+	// Specular term with the non-local viewer
+	if (lambertian > 0.0)
+	{
+		vec3	H = normalize(L + vec3(0, 0, 1));
+		float	specular = pow(max(dot(N, H), 0.0), gl_FrontMaterial.shininess);
+		c.rgb += specular * gl_FrontMaterial.specular.rgb * gl_LightSource[0].specular.rgb;
+	}
+
+	c.a = 1.0;
+	return c;
+}
+
+void
+main(void)
+{
+	gl_FragColor = lighting(position, normalize(normal));
+}
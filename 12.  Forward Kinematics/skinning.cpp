@@ -0,0 +1,558 @@
+#include "skinning.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <thread>
+#include <utility>
+#include <vector>
+using namespace std;
+
+#ifdef __AVX2__
+#define SKINNING_AVX2
+#include <immintrin.h>
+#endif
+
+const char*	skinningName[NUM_SKINNING_METHODS] = { "LBS", "DQS" };
+
+// Attribute locations of sv12_skin.glsl
+enum
+{
+	VERTEX_POSITION = 0,
+	VERTEX_NORMAL = 1,
+	VERTEX_JOINT = 2,
+	VERTEX_WEIGHT = 3,
+};
+
+static const GLuint	PALETTE_BINDING = 0;	// Binding point of the uniform buffer
+
+void
+computeSkinPalette(int numJoints, const Matrix4f bind[], const Matrix4f world[],
+	SkinPalette& palette)
+{
+	numJoints = min(numJoints, MAX_SKIN_JOINTS);
+	for (int j = 0; j < numJoints; j++)
+	{
+		Matrix4f	M = world[j] * bind[j].inverse();
+
+		for (int r = 0; r < 3; r++)
+			for (int c = 0; c < 4; c++) palette.matrix[j][4 * r + c] = M(r, c);
+
+		// Real part q of the rotation, and dual part t q / 2 of the translation t
+		Quaternionf	q(Matrix3f(M.block<3, 3>(0, 0)));
+		q.normalize();
+
+		Vector3f	t = M.block<3, 1>(0, 3);
+		Quaternionf	d = Quaternionf(0, t.x(), t.y(), t.z()) * q;
+
+		Map<Vector4f>(palette.dualQuat[j]) = q.coeffs();
+		Map<Vector4f>(palette.dualQuat[j] + 4) = 0.5f * d.coeffs();
+	}
+}
+
+// Distance from p to the segment ab
+static inline float
+distanceToSegment(const Vector3f& p, const Vector3f& a, const Vector3f& b)
+{
+	Vector3f	ab = b - a;
+	float		l2 = ab.squaredNorm();
+	float		t = (l2 > 0) ? min(max((p - a).dot(ab) / l2, 0.0f), 1.0f) : 0.0f;
+
+	return (p - a - t * ab).norm();
+}
+
+void
+bindSkin(SkinnedMesh& s, const MatrixXf& vertex, const MatrixXf& normal,
+	const ArrayXXi& face, int numJoints, const Vector3f boneStart[], const Vector3f boneEnd[])
+{
+	int	n = int(vertex.cols());
+	numJoints = min(numJoints, MAX_SKIN_JOINTS);
+
+	s.restVertex = s.vertex = vertex;
+	s.restNormal = s.normal = normal;
+	s.face = face;
+
+	// The unused influences are the joint 0 of the weight 0
+	s.joint.setZero(SKIN_INFLUENCES, n);
+	s.weight.setZero(SKIN_INFLUENCES, n);
+
+	int						m = min(numJoints, SKIN_INFLUENCES);
+	vector<pair<float, int> >	influence(numJoints);
+	for (int i = 0; i < n; i++)
+	{
+		for (int j = 0; j < numJoints; j++)
+		{
+			float	d = max(distanceToSegment(vertex.col(i), boneStart[j], boneEnd[j]), 1.0e-4f);
+			influence[j] = make_pair(1 / (d * d * d * d), j);
+		}
+		partial_sort(influence.begin(), influence.begin() + m, influence.end(),
+			greater<pair<float, int> >());
+
+		float	sum = 0;
+		for (int k = 0; k < m; k++) sum += influence[k].first;
+
+		// The heaviest first, whose hemisphere DQS follows
+		for (int k = 0; k < m; k++)
+		{
+			s.joint(k, i) = influence[k].second;
+			s.weight(k, i) = influence[k].first / sum;
+		}
+	}
+}
+
+// Shaders with the attribute locations and the uniform block bound
+static bool
+createSkinProgram(SkinnedMesh& s, const char* vertexShaderFile, const char* fragmentShaderFile)
+{
+	if (!GLEW_VERSION_3_1 && !GLEW_ARB_uniform_buffer_object)	return	false;
+
+	s.vertexShader = createShaderFromFile(GL_VERTEX_SHADER, vertexShaderFile);
+	s.fragmentShader = createShaderFromFile(GL_FRAGMENT_SHADER, fragmentShaderFile);
+	if (s.vertexShader == 0 || s.fragmentShader == 0)	return	false;
+
+	s.program = glCreateProgram();
+	glAttachShader(s.program, s.vertexShader);
+	glAttachShader(s.program, s.fragmentShader);
+
+	glBindAttribLocation(s.program, VERTEX_POSITION, "vPosition");
+	glBindAttribLocation(s.program, VERTEX_NORMAL, "vNormal");
+	glBindAttribLocation(s.program, VERTEX_JOINT, "vJoint");
+	glBindAttribLocation(s.program, VERTEX_WEIGHT, "vWeight");
+
+	glLinkProgram(s.program);
+	printProgramInfoLog(s.program);
+
+	GLint	linked = GL_FALSE;
+	glGetProgramiv(s.program, GL_LINK_STATUS, &linked);
+	if (linked != GL_TRUE)	return	false;
+
+	GLuint	block = glGetUniformBlockIndex(s.program, "SkinPalette");
+	if (block == GL_INVALID_INDEX)	return	false;
+	glUniformBlockBinding(s.program, block, PALETTE_BINDING);
+
+	return	isOK("createSkinProgram()", __FILE__, __LINE__, false);
+}
+
+static void
+deleteSkinProgram(SkinnedMesh& s)
+{
+	if (s.vertexShader)		glDeleteShader(s.vertexShader);
+	if (s.fragmentShader)	glDeleteShader(s.fragmentShader);
+	if (s.program)			glDeleteProgram(s.program);
+
+	s.program = s.vertexShader = s.fragmentShader = 0;
+}
+
+bool
+createSkinnedMesh(SkinnedMesh& s, const char* vertexShaderFile, const char* fragmentShaderFile)
+{
+	GLsizeiptr	n = s.restVertex.cols();
+
+	// Triangles and the vertices skinned on the CPU, used by both the paths
+	glGenBuffers(1, &s.indexId);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, s.indexId);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, s.face.size() * sizeof(GLint), s.face.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	glGenBuffers(1, &s.skinnedId);
+	uploadSkinnedVertices(s);
+
+	if (!createSkinProgram(s, vertexShaderFile, fragmentShaderFile))
+	{
+		deleteSkinProgram(s);
+		return	false;
+	}
+
+	// Rest pose: the positions and then the normals, the joints and then the weights
+	glGenBuffers(1, &s.restId);
+	glBindBuffer(GL_ARRAY_BUFFER, s.restId);
+	glBufferData(GL_ARRAY_BUFFER, n * 6 * sizeof(GLfloat), NULL, GL_STATIC_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, n * 3 * sizeof(GLfloat), s.restVertex.data());
+	glBufferSubData(GL_ARRAY_BUFFER, n * 3 * sizeof(GLfloat), n * 3 * sizeof(GLfloat), s.restNormal.data());
+
+	glGenBuffers(1, &s.influenceId);
+	glBindBuffer(GL_ARRAY_BUFFER, s.influenceId);
+	glBufferData(GL_ARRAY_BUFFER, n * SKIN_INFLUENCES * (sizeof(GLint) + sizeof(GLfloat)), NULL, GL_STATIC_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, n * SKIN_INFLUENCES * sizeof(GLint), s.joint.data());
+	glBufferSubData(GL_ARRAY_BUFFER, n * SKIN_INFLUENCES * sizeof(GLint),
+		n * SKIN_INFLUENCES * sizeof(GLfloat), s.weight.data());
+
+	glGenVertexArrays(1, &s.vao);
+	glBindVertexArray(s.vao);
+
+	glBindBuffer(GL_ARRAY_BUFFER, s.restId);
+	glEnableVertexAttribArray(VERTEX_POSITION);
+	glVertexAttribPointer(VERTEX_POSITION, 3, GL_FLOAT, GL_FALSE, 0, NULL);
+	glEnableVertexAttribArray(VERTEX_NORMAL);
+	glVertexAttribPointer(VERTEX_NORMAL, 3, GL_FLOAT, GL_FALSE, 0, (GLvoid*)(n * 3 * sizeof(GLfloat)));
+
+	// The joint indices stay integers
+	glBindBuffer(GL_ARRAY_BUFFER, s.influenceId);
+	glEnableVertexAttribArray(VERTEX_JOINT);
+	glVertexAttribIPointer(VERTEX_JOINT, SKIN_INFLUENCES, GL_INT, 0, NULL);
+	glEnableVertexAttribArray(VERTEX_WEIGHT);
+	glVertexAttribPointer(VERTEX_WEIGHT, SKIN_INFLUENCES, GL_FLOAT, GL_FALSE, 0,
+		(GLvoid*)(n * SKIN_INFLUENCES * sizeof(GLint)));
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, s.indexId);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	// Palette rewritten in place every frame
+	glGenBuffers(1, &s.paletteId);
+	glBindBuffer(GL_UNIFORM_BUFFER, s.paletteId);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(SkinPalette), NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	return	isOK("createSkinnedMesh()", __FILE__, __LINE__, false);
+}
+
+void
+uploadSkinPalette(SkinnedMesh& s, const SkinPalette& palette)
+{
+	if (s.paletteId == 0)	return;
+
+	glBindBuffer(GL_UNIFORM_BUFFER, s.paletteId);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(SkinPalette), &palette);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	isOK("uploadSkinPalette()", __FILE__, __LINE__);
+}
+
+//
+// Skinning on the CPU
+//
+// The same arithmetic as sv12_skin.glsl, written once for float and for 8 floats in AVX2
+// registers. The lanes gather the entries of the palette by their own joint indices.
+//
+static inline float	sqrtv(float x) { return sqrtf(x); }
+static inline float	selectv(bool m, float a, float b) { return m ? a : b; }
+static inline float	gatherv(const float* table, int index) { return table[index]; }
+
+#ifdef SKINNING_AVX2
+struct Float8
+{
+	__m256	v;
+
+	Float8() {}
+	Float8(__m256 x) : v(x) {}
+	Float8(float x) : v(_mm256_set1_ps(x)) {}
+};
+
+struct Int8
+{
+	__m256i	v;
+
+	Int8() {}
+	Int8(__m256i x) : v(x) {}
+};
+
+static inline Float8	operator+(Float8 a, Float8 b) { return _mm256_add_ps(a.v, b.v); }
+static inline Float8	operator-(Float8 a, Float8 b) { return _mm256_sub_ps(a.v, b.v); }
+static inline Float8	operator*(Float8 a, Float8 b) { return _mm256_mul_ps(a.v, b.v); }
+static inline Float8	operator/(Float8 a, Float8 b) { return _mm256_div_ps(a.v, b.v); }
+static inline Float8	operator-(Float8 a) { return _mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f)); }
+static inline Float8&	operator+=(Float8& a, Float8 b) { return a = a + b; }
+static inline Float8&	operator*=(Float8& a, Float8 b) { return a = a * b; }
+static inline Int8		operator*(Int8 a, int b) { return _mm256_mullo_epi32(a.v, _mm256_set1_epi32(b)); }
+
+// Comparisons are masks of all the bits
+static inline Float8	operator<(Float8 a, Float8 b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ); }
+
+static inline Float8	sqrtv(Float8 x) { return _mm256_sqrt_ps(x.v); }
+static inline Float8	selectv(Float8 m, Float8 a, Float8 b) { return _mm256_blendv_ps(b.v, a.v, m.v); }
+static inline Float8	gatherv(const float* table, Int8 index) { return _mm256_i32gather_ps(table, index.v, 4); }
+#endif
+
+template<class F> static inline void
+cross(const F a[], const F b[], F c[3])
+{
+	c[0] = a[1] * b[2] - a[2] * b[1];
+	c[1] = a[2] * b[0] - a[0] * b[2];
+	c[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+template<class F> static inline void
+normalize(F v[3])
+{
+	F	l = F(1.0f) / sqrtv(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+	for (int c = 0; c < 3; c++) v[c] *= l;
+}
+
+// v + 2 q.xyz x (q.xyz x v + q.w v) by the unit quaternion q
+template<class F> static inline void
+rotate(const F q[4], F v[3])
+{
+	F	a[3], b[3];
+	cross(q, v, a);
+	for (int c = 0; c < 3; c++) a[c] += q[3] * v[c];
+
+	cross(q, a, b);
+	for (int c = 0; c < 3; c++) v[c] += F(2.0f) * b[c];
+}
+
+// Blend of the 3x4 matrices. The normal goes through the inverse transpose of the blend,
+// whose columns are the cross products of the columns of the 3x3 part divided by the
+// determinant, as the blend of rotations is not a rotation.
+template<class F, class I> static inline void
+skinLBS(const SkinPalette& palette, const I joint[], const F weight[], F p[3], F n[3])
+{
+	F	M[12];
+	for (int e = 0; e < 12; e++) M[e] = 0.0f;
+
+	for (int k = 0; k < SKIN_INFLUENCES; k++)
+	{
+		I	base = joint[k] * 12;
+		for (int e = 0; e < 12; e++) M[e] += weight[k] * gatherv(&palette.matrix[0][0] + e, base);
+	}
+
+	F	q[3];
+	for (int r = 0; r < 3; r++) q[r] = M[4 * r] * p[0] + M[4 * r + 1] * p[1] + M[4 * r + 2] * p[2] + M[4 * r + 3];
+
+	F	c0[3] = { M[0], M[4], M[8] }, c1[3] = { M[1], M[5], M[9] }, c2[3] = { M[2], M[6], M[10] };
+	F	a[3], b[3], c[3];
+	cross(c1, c2, a);
+	cross(c2, c0, b);
+	cross(c0, c1, c);
+
+	F	m[3];
+	for (int r = 0; r < 3; r++) m[r] = a[r] * n[0] + b[r] * n[1] + c[r] * n[2];
+	normalize(m);
+
+	for (int r = 0; r < 3; r++) { p[r] = q[r]; n[r] = m[r]; }
+}
+
+// Blend of the dual quaternions in the hemisphere of the first joint, normalized by the
+// length of the real part
+template<class F, class I> static inline void
+skinDQS(const SkinPalette& palette, const I joint[], const F weight[], F p[3], F n[3])
+{
+	const float*	table = &palette.dualQuat[0][0];
+
+	F	r0[4], r[4], d[4];
+	I	base = joint[0] * 8;
+	for (int e = 0; e < 4; e++)
+	{
+		r0[e] = gatherv(table + e, base);
+		r[e] = d[e] = 0.0f;
+	}
+
+	for (int k = 0; k < SKIN_INFLUENCES; k++)
+	{
+		F	qr[4], qd[4];
+		base = joint[k] * 8;
+		for (int e = 0; e < 4; e++)
+		{
+			qr[e] = gatherv(table + e, base);
+			qd[e] = gatherv(table + 4 + e, base);
+		}
+
+		// q and -q are the same rotation
+		F	cosine = qr[0] * r0[0] + qr[1] * r0[1] + qr[2] * r0[2] + qr[3] * r0[3];
+		F	w = selectv(cosine < F(0.0f), -weight[k], weight[k]);
+		for (int e = 0; e < 4; e++)
+		{
+			r[e] += w * qr[e];
+			d[e] += w * qd[e];
+		}
+	}
+
+	F	l = F(1.0f) / sqrtv(r[0] * r[0] + r[1] * r[1] + r[2] * r[2] + r[3] * r[3]);
+	for (int e = 0; e < 4; e++)
+	{
+		r[e] *= l;
+		d[e] *= l;
+	}
+
+	// Translation 2 (r.w d.xyz - d.w r.xyz + r.xyz x d.xyz)
+	F	t[3];
+	cross(r, d, t);
+	for (int c = 0; c < 3; c++) t[c] = F(2.0f) * (r[3] * d[c] - d[3] * r[c] + t[c]);
+
+	rotate(r, p);
+	for (int c = 0; c < 3; c++) p[c] += t[c];
+
+	rotate(r, n);
+}
+
+template<class F, class I> static inline void
+skinVertex(const SkinPalette& palette, SkinningMethod method, const I joint[], const F weight[],
+	F p[3], F n[3])
+{
+	if (method == SKINNING_DQS)	skinDQS(palette, joint, weight, p, n);
+	else						skinLBS(palette, joint, weight, p, n);
+}
+
+static const int	GRAIN = 4096;	// Minimum vertices of a thread
+
+// f(begin, end) over the ranges of [0, n) on the threads, in multiples of 8 but the last
+static void
+parallelRanges(int n, int numThreads, const function<void(int, int)>& f)
+{
+	if (numThreads <= 0) numThreads = max(int(thread::hardware_concurrency()), 1);
+	numThreads = max(min(numThreads, (n + GRAIN - 1) / GRAIN), 1);
+
+	vector<thread>	workers;
+	for (int i = 1; i < numThreads; i++)
+	{
+		int	begin = int(int64_t(n) * i / numThreads) & ~7;
+		int	end = (i + 1 < numThreads) ? int(int64_t(n) * (i + 1) / numThreads) & ~7 : n;
+		workers.push_back(thread(f, begin, end));
+	}
+
+	f(0, (numThreads > 1) ? int(int64_t(n) / numThreads) & ~7 : n);
+
+	for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+}
+
+void
+skinVertices(SkinnedMesh& s, const SkinPalette& palette, SkinningMethod method,
+	bool simd, int numThreads)
+{
+	int	n = int(s.restVertex.cols());
+	s.vertex.resize(3, n);
+	s.normal.resize(3, n);
+
+	const float*	restVertex = s.restVertex.data();
+	const float*	restNormal = s.restNormal.data();
+	const int*		joint = s.joint.data();
+	const float*	weight = s.weight.data();
+	float*			vertex = s.vertex.data();
+	float*			normal = s.normal.data();
+
+	parallelRanges(n, numThreads, [&](int begin, int end)
+	{
+		int	i = begin;
+#ifdef SKINNING_AVX2
+		// Lanes of the interleaved attributes of 8 vertices
+		const __m256i	lane3 = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+		const __m256i	lane4 = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+		for (; simd && i + 8 <= end; i += 8)
+		{
+			Float8	p[3], m[3], w[SKIN_INFLUENCES];
+			Int8	j[SKIN_INFLUENCES];
+			for (int c = 0; c < 3; c++)
+			{
+				p[c] = _mm256_i32gather_ps(restVertex + 3 * i + c, lane3, 4);
+				m[c] = _mm256_i32gather_ps(restNormal + 3 * i + c, lane3, 4);
+			}
+			for (int k = 0; k < SKIN_INFLUENCES; k++)
+			{
+				j[k] = _mm256_i32gather_epi32(joint + SKIN_INFLUENCES * i + k, lane4, 4);
+				w[k] = _mm256_i32gather_ps(weight + SKIN_INFLUENCES * i + k, lane4, 4);
+			}
+
+			skinVertex(palette, method, j, w, p, m);
+
+			// Back into the interleaved columns
+			alignas(32) float	lanes[6][8];
+			for (int c = 0; c < 3; c++)
+			{
+				_mm256_store_ps(lanes[c], p[c].v);
+				_mm256_store_ps(lanes[3 + c], m[c].v);
+			}
+			for (int l = 0; l < 8; l++)
+				for (int c = 0; c < 3; c++)
+				{
+					vertex[3 * (i + l) + c] = lanes[c][l];
+					normal[3 * (i + l) + c] = lanes[3 + c][l];
+				}
+		}
+#endif
+		for (; i < end; i++)
+		{
+			float	p[3], m[3];
+			for (int c = 0; c < 3; c++)
+			{
+				p[c] = restVertex[3 * i + c];
+				m[c] = restNormal[3 * i + c];
+			}
+
+			skinVertex(palette, method, joint + SKIN_INFLUENCES * i, weight + SKIN_INFLUENCES * i, p, m);
+
+			for (int c = 0; c < 3; c++)
+			{
+				vertex[3 * i + c] = p[c];
+				normal[3 * i + c] = m[c];
+			}
+		}
+	});
+}
+
+void
+uploadSkinnedVertices(SkinnedMesh& s)
+{
+	GLsizeiptr	n = s.vertex.cols();
+
+	// glBufferData() orphans the previous storage, so that it never waits for the GPU.
+	glBindBuffer(GL_ARRAY_BUFFER, s.skinnedId);
+	glBufferData(GL_ARRAY_BUFFER, n * 6 * sizeof(GLfloat), NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, n * 3 * sizeof(GLfloat), s.vertex.data());
+	glBufferSubData(GL_ARRAY_BUFFER, n * 3 * sizeof(GLfloat), n * 3 * sizeof(GLfloat), s.normal.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	isOK("uploadSkinnedVertices()", __FILE__, __LINE__);
+}
+
+void
+drawSkinnedMesh(const SkinnedMesh& s, SkinningMethod method, bool gpu)
+{
+	if (gpu && s.program)
+	{
+		glUseProgram(s.program);
+		setUniformi(s.program, "method", method);
+		glBindBufferBase(GL_UNIFORM_BUFFER, PALETTE_BINDING, s.paletteId);
+
+		glBindVertexArray(s.vao);
+		glDrawElements(GL_TRIANGLES, GLsizei(s.face.size()), GL_UNSIGNED_INT, NULL);
+		glBindVertexArray(0);
+
+		glUseProgram(0);
+	}
+	else
+	{
+		// Fixed-function pipeline from the buffer of uploadSkinnedVertices()
+		glBindBuffer(GL_ARRAY_BUFFER, s.skinnedId);
+		glEnableClientState(GL_VERTEX_ARRAY);
+		glVertexPointer(3, GL_FLOAT, 0, NULL);
+		glEnableClientState(GL_NORMAL_ARRAY);
+		glNormalPointer(GL_FLOAT, 0, (GLvoid*)(s.vertex.cols() * 3 * sizeof(GLfloat)));
+
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, s.indexId);
+		glDrawElements(GL_TRIANGLES, GLsizei(s.face.size()), GL_UNSIGNED_INT, NULL);
+
+		glDisableClientState(GL_VERTEX_ARRAY);
+		glDisableClientState(GL_NORMAL_ARRAY);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	isOK("drawSkinnedMesh()", __FILE__, __LINE__);
+}
+
+void
+deleteSkinnedMesh(SkinnedMesh& s)
+{
+	if (s.vao)	glDeleteVertexArrays(1, &s.vao);
+
+	GLuint	buffer[5] = { s.indexId, s.restId, s.influenceId, s.skinnedId, s.paletteId };
+	for (int i = 0; i < 5; i++)
+		if (buffer[i]) glDeleteBuffers(1, &buffer[i]);
+
+	s.vao = s.indexId = s.restId = s.influenceId = s.skinnedId = s.paletteId = 0;
+
+	deleteSkinProgram(s);
+}
+
+bool
+skinningSIMD()
+{
+#ifdef SKINNING_AVX2
+	return true;
+#else
+	return false;
+#endif
+}
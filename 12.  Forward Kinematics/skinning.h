@@ -0,0 +1,100 @@
+#pragma once
+
+#ifndef __SKINNING_H_
+#define __SKINNING_H_
+
+#include "glShader.h"
+
+// Skinning of a mesh bound to the joints of a hierarchy
+//
+// Every vertex follows up to 4 joints with weights summing to 1 from its position in the
+// bind pose. The transform of a joint is its current world transform times the inverse of
+// its bind one. Linear blend skinning (LBS) blends the 3x4 matrices of the joints, which
+// collapses the volume around a bent joint. Dual quaternion skinning (DQS) blends the unit
+// dual quaternions of the same rigid transforms in the hemisphere of the first joint and
+// normalizes the sum, so that the blend stays rigid.
+//
+// The palette of the joints is uploaded once a frame into a uniform buffer, and the vertex
+// shader skins the rest pose from the static buffers. The CPU path skins the same rest pose
+// into the vertex and normal matrices for the collision, picking and export, and they are
+// drawn in the fixed-function pipeline when the shaders are not available.
+
+const int	MAX_SKIN_JOINTS = 32;		// Of the uniform buffer, also in sv12_skin.glsl
+const int	SKIN_INFLUENCES = 4;		// Joints of a vertex
+
+enum SkinningMethod
+{
+	SKINNING_LBS = 0,		// Linear blend skinning
+	SKINNING_DQS,			// Dual quaternion skinning
+	NUM_SKINNING_METHODS
+};
+
+extern const char*	skinningName[NUM_SKINNING_METHODS];
+
+// Same layout as the std140 block of sv12_skin.glsl
+struct SkinPalette
+{
+	float	matrix[MAX_SKIN_JOINTS][12];	// Rows of the 3x4 matrices
+	float	dualQuat[MAX_SKIN_JOINTS][8];	// Real and dual parts, (x, y, z, w) each
+};
+
+struct SkinnedMesh
+{
+	// Bind pose, 3 x # of vertices, and the joints and their weights, 4 x # of vertices
+	MatrixXf	restVertex, restNormal;
+	ArrayXXi	joint;
+	MatrixXf	weight;
+	ArrayXXi	face;
+
+	// Skinned by skinVertices()
+	MatrixXf	vertex, normal;
+
+	GLuint	program, vertexShader, fragmentShader;
+
+	GLuint	vao;			// Vertex array object of the rest pose
+	GLuint	indexId;		// Buffer for triangle indices
+	GLuint	restId;			// Rest positions and normals
+	GLuint	influenceId;	// Joints and weights
+	GLuint	skinnedId;		// Positions and normals skinned on the CPU
+	GLuint	paletteId;		// Uniform buffer of SkinPalette
+
+	SkinnedMesh()
+	{
+		program = vertexShader = fragmentShader = 0;
+		vao = indexId = restId = influenceId = skinnedId = paletteId = 0;
+	}
+};
+
+// Matrices and dual quaternions of the joints from their bind and current world transforms
+void	computeSkinPalette(int numJoints, const Matrix4f bind[], const Matrix4f world[],
+	SkinPalette& palette);
+
+// The mesh in the bind pose bound to the joints of the bones, segments in the bind pose.
+// The weights fall off with the 4th power of the distance to the bones, and the nearest
+// 4 are normalized.
+void	bindSkin(SkinnedMesh& s, const MatrixXf& vertex, const MatrixXf& normal,
+	const ArrayXXi& face, int numJoints, const Vector3f boneStart[], const Vector3f boneEnd[]);
+
+// Buffers of the bound mesh. Returns false without the shaders, and then only the CPU path
+// is available.
+bool	createSkinnedMesh(SkinnedMesh& s, const char* vertexShaderFile,
+	const char* fragmentShaderFile);
+
+// Once a frame before drawing on the GPU
+void	uploadSkinPalette(SkinnedMesh& s, const SkinPalette& palette);
+
+// The skinned vertices and normals on the CPU with the normals normalized. The vertices are
+// split into the ranges of the threads, and 8 vertices go together in AVX2 when built with
+// it, e.g., -mavx2 or /arch:AVX2, unless simd is false.
+void	skinVertices(SkinnedMesh& s, const SkinPalette& palette, SkinningMethod method,
+	bool simd = true, int numThreads = 0);	// 0 for all the cores
+void	uploadSkinnedVertices(SkinnedMesh& s);
+
+// In the current modelview coordinate system, skinned in the vertex shader or from the
+// vertices uploaded by uploadSkinnedVertices()
+void	drawSkinnedMesh(const SkinnedMesh& s, SkinningMethod method, bool gpu);
+void	deleteSkinnedMesh(SkinnedMesh& s);
+
+bool	skinningSIMD();		// Built with AVX2
+
+#endif	// __SKINNING_H_
@@ -0,0 +1,81 @@
+#version 150 compatibility
+
+// Rest pose, and up to 4 joints with their weights. The unused joints are of the weight 0.
+in vec3		vPosition;
+in vec3		vNormal;
+in ivec4	vJoint;
+in vec4		vWeight;
+
+// Palette of MAX_SKIN_JOINTS = 32 in skinning.h: the rows of the 3x4 matrices for LBS, and
+// the real and dual parts of the dual quaternions for DQS
+layout(std140) uniform SkinPalette
+{
+	vec4	matrixRow[3 * 32];
+	vec4	dualQuat[2 * 32];
+};
+
+uniform int	method;		// 0 for LBS, 1 for DQS
+
+// In the eye coordinate system
+out vec3	position;
+out vec3	normal;
+
+// v + 2 q.xyz x (q.xyz x v + q.w v) by the unit quaternion q
+vec3
+rotate(vec4 q, vec3 v)
+{
+	return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void
+main(void)
+{
+	vec3	P, N;
+	if (method == 1)
+	{
+		// Dual quaternions in the hemisphere of the first joint, as q and -q are the same
+		vec4	r0 = dualQuat[2 * vJoint[0]];
+		vec4	r = vec4(0.0), d = vec4(0.0);
+		for (int k = 0; k < 4; k++)
+		{
+			vec4	qr = dualQuat[2 * vJoint[k]];
+			vec4	qd = dualQuat[2 * vJoint[k] + 1];
+			float	w = (dot(qr, r0) < 0.0) ? -vWeight[k] : vWeight[k];
+
+			r += w * qr;
+			d += w * qd;
+		}
+
+		float	l = length(r);
+		r /= l;
+		d /= l;
+
+		P = rotate(r, vPosition) + 2.0 * (r.w * d.xyz - d.w * r.xyz + cross(r.xyz, d.xyz));
+		N = rotate(r, vNormal);
+	}
+	else
+	{
+		// Blend of the matrices, and the normal by the inverse transpose of the blend up to
+		// the determinant
+		vec4	row0 = vec4(0.0), row1 = vec4(0.0), row2 = vec4(0.0);
+		for (int k = 0; k < 4; k++)
+		{
+			row0 += vWeight[k] * matrixRow[3 * vJoint[k]];
+			row1 += vWeight[k] * matrixRow[3 * vJoint[k] + 1];
+			row2 += vWeight[k] * matrixRow[3 * vJoint[k] + 2];
+		}
+
+		vec4	p = vec4(vPosition, 1.0);
+		P = vec3(dot(row0, p), dot(row1, p), dot(row2, p));
+
+		vec3	c0 = vec3(row0.x, row1.x, row2.x);
+		vec3	c1 = vec3(row0.y, row1.y, row2.y);
+		vec3	c2 = vec3(row0.z, row1.z, row2.z);
+		N = mat3(cross(c1, c2), cross(c2, c0), cross(c0, c1)) * vNormal;
+	}
+
+	position = vec3(gl_ModelViewMatrix * vec4(P, 1.0));
+	normal = normalize(gl_NormalMatrix * N);
+
+	gl_Position = gl_ModelViewProjectionMatrix * vec4(P, 1.0);
+}
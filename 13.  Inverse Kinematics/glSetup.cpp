@@ -1,7 +1,13 @@
 #include "glSetup.h"
 
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <algorithm>
+#include <fstream>
 #include <iostream>
+#include <string>
+#include <vector>
 using namespace std;
 
 bool fullScreen = false;
@@ -59,12 +65,632 @@ void reshape(GLFWwindow* window, int w, int h)
     cerr << " with screen" << screenW << "x " << screenH << endl;
 }
 
+//
+// Frame timing
+//
+bool timingOverlay = false;         // Frame-time graph and histogram
+const char* timingCSVFile = NULL;   // Per-frame timings in milliseconds
+
+static const int TIMING_FRAMES = 240;   // Rolling window of the statistics
+static const int GRAPH_FRAMES = 120;    // Frames in the overlay graph
+static const int GPU_QUERIES = 4;       // Ring of queries read a few frames later
+static const double GRAPH_MS = 33.3;    // Full height of the graph and histogram
+
+struct FrameTiming
+{
+    double scope[NUM_TIMING_SCOPES];    // CPU time of the scopes in seconds
+    double frame;                       // Time between the ends of the swaps
+    double gpu;                         // GPU time, negative until available
+};
+
+static FrameTiming frameTiming[TIMING_FRAMES];
+static int frameCount = 0;              // # of completed frames
+static double frameStart = -1;          // Not started yet if negative
+static double scopeStart[NUM_TIMING_SCOPES];
+
+static GLuint gpuQuery[GPU_QUERIES];
+static int gpuQueryFrame[GPU_QUERIES];  // Frame measured by the query, -1 if none
+static bool gpuTiming = false;
+static bool gpuQueryActive = false;     // Frame query begun and not ended yet
+static int gpuTimingSuspended = 0;      // Nesting of suspendGPUTiming()
+
+static ofstream timingCSV;
+static int csvFrame = 0;                // Next frame to write
+static string windowTitle;
+static double titleTime = 0;
+
+static const char* timingScopeName[NUM_TIMING_SCOPES] = { "update", "simulate", "render", "swap" };
+static const float timingScopeColor[NUM_TIMING_SCOPES][3] = {
+    { 0.6f, 0.6f, 0.6f }, { 0.2f, 0.8f, 0.2f }, { 0.2f, 0.4f, 1.0f }, { 1.0f, 0.6f, 0.0f } };
+
+//
+// Headless rendering
+//
+int headlessFrames = 0;                 // # of frames to render offscreen, 0 for the window
+static int headlessW = 1280, headlessH = 720;
+static const char* capturePrefix = NULL;
+static int captureEvery = 0;            // 0 for the last frame only
+
+static GLuint headlessFBO = 0, resolveFBO = 0;
+static GLuint headlessColor = 0, headlessDepth = 0, resolveColor = 0;
+
+// Statistics of all the frames, not only of the rolling window of the overlay
+static vector<double> headlessFrameTime, headlessGPUTime;
+static double headlessScopeTime[NUM_TIMING_SCOPES];
+static double headlessStart = 0;
+
+// --headless N, --size WxH, --capture prefix and --capture-every K
+static void
+parseHeadlessOptions(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--headless") == 0 && i + 1 < argc) headlessFrames = max(atoi(argv[++i]), 0);
+        else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) sscanf(argv[++i], "%dx%d", &headlessW, &headlessH);
+        else if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc) capturePrefix = argv[++i];
+        else if (strcmp(argv[i], "--capture-every") == 0 && i + 1 < argc) captureEvery = atoi(argv[++i]);
+    }
+
+    if (headlessW <= 0 || headlessH <= 0)
+    {
+        cerr << "ERROR: Invalid --size, 1280x720 instead" << endl;
+        headlessW = 1280;
+        headlessH = 720;
+    }
+}
+
+// Without any display server, GLFW 3.4 or later can fall back to its null platform with an
+// OSMesa context. GLEW should then be built with GLEW_OSMESA to load the entry points.
+static bool
+initHeadlessPlatform()
+{
+    if (headlessFrames == 0) return false;
+
+#ifdef GLFW_PLATFORM_NULL
+    glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+    if (!glfwInit()) return false;
+
+    glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+    cerr << "Status: Headless with the null platform and OSMesa" << endl;
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Multisampled framebuffer of the fixed size like the window with GLFW_SAMPLES 4, resolved
+// into a single-sampled one for the captures. Without framebuffer objects, the frames are
+// rendered into the back buffer of the invisible window of the same size.
+static bool
+createHeadlessFramebuffer()
+{
+    screenW = windowW = headlessW;
+    screenH = windowH = headlessH;
+    dpiScaling = 1;
+
+    if (!GLEW_VERSION_3_0 && !GLEW_ARB_framebuffer_object)
+    {
+        cerr << "Status: Headless without framebuffer objects" << endl;
+        return true;
+    }
+
+    GLint samples = 0;
+    glGetIntegerv(GL_MAX_SAMPLES, &samples);
+    samples = min(samples, 4);
+
+    glGenRenderbuffers(1, &headlessColor);
+    glBindRenderbuffer(GL_RENDERBUFFER, headlessColor);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, headlessW, headlessH);
+
+    glGenRenderbuffers(1, &headlessDepth);
+    glBindRenderbuffer(GL_RENDERBUFFER, headlessDepth);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH24_STENCIL8, headlessW, headlessH);
+
+    glGenFramebuffers(1, &headlessFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, headlessFBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, headlessColor);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, headlessDepth);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        cerr << "ERROR: Incomplete headless framebuffer" << endl;
+        return false;
+    }
+
+    glGenRenderbuffers(1, &resolveColor);
+    glBindRenderbuffer(GL_RENDERBUFFER, resolveColor);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, headlessW, headlessH);
+
+    glGenFramebuffers(1, &resolveFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, resolveFBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, resolveColor);
+
+    // The samples render into the bound framebuffer as into the window
+    glBindFramebuffer(GL_FRAMEBUFFER, headlessFBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    cerr << "Status: Headless " << headlessW << "x " << headlessH << " with " << samples
+        << " samples for " << headlessFrames << " frames" << endl;
+
+    headlessStart = glfwGetTime();
+    return true;
+}
+
+static unsigned long
+crc32(const unsigned char* data, size_t n, unsigned long crc)
+{
+    static unsigned long table[256] = { 0 };
+    if (table[1] == 0)
+    {
+        for (unsigned long i = 0; i < 256; i++)
+        {
+            unsigned long c = i;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320UL ^ (c >> 1) : c >> 1;
+            table[i] = c;
+        }
+    }
+
+    for (size_t i = 0; i < n; i++) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+static void
+writeChunk(ofstream& file, const char* type, const vector<unsigned char>& data)
+{
+    unsigned char header[8] = {
+        (unsigned char)(data.size() >> 24), (unsigned char)(data.size() >> 16),
+        (unsigned char)(data.size() >> 8), (unsigned char)data.size(),
+        (unsigned char)type[0], (unsigned char)type[1], (unsigned char)type[2], (unsigned char)type[3] };
+
+    unsigned long crc = crc32(header + 4, 4, 0xFFFFFFFFUL);
+    if (!data.empty()) crc = crc32(&data[0], data.size(), crc);
+    crc ^= 0xFFFFFFFFUL;
+    unsigned char footer[4] = {
+        (unsigned char)(crc >> 24), (unsigned char)(crc >> 16), (unsigned char)(crc >> 8), (unsigned char)crc };
+
+    file.write((const char*)header, 8);
+    if (!data.empty()) file.write((const char*)&data[0], data.size());
+    file.write((const char*)footer, 4);
+}
+
+// 8-bit RGB PNG of the bottom-up rows of glReadPixels() in uncompressed deflate blocks,
+// which keeps the capture cost predictable and needs no image library
+static bool
+writePNG(const char* filename, int w, int h, const unsigned char* rgb)
+{
+    ofstream file(filename, ios::binary);
+    if (!file.is_open()) return false;
+
+    static const unsigned char signature[8] = { 137, 'P', 'N', 'G', '\r', '\n', 26, '\n' };
+    file.write((const char*)signature, 8);
+
+    vector<unsigned char> ihdr(13, 0);
+    for (int i = 0; i < 4; i++)
+    {
+        ihdr[i] = (unsigned char)(w >> (24 - 8 * i));
+        ihdr[4 + i] = (unsigned char)(h >> (24 - 8 * i));
+    }
+    ihdr[8] = 8;    // Bit depth
+    ihdr[9] = 2;    // RGB
+    writeChunk(file, "IHDR", ihdr);
+
+    // Filter type 0 in front of every row, top row first
+    size_t rowSize = 3 * size_t(w);
+    vector<unsigned char> raw((rowSize + 1) * h);
+    for (int y = 0; y < h; y++)
+    {
+        raw[y * (rowSize + 1)] = 0;
+        memcpy(&raw[y * (rowSize + 1) + 1], rgb + (h - 1 - y) * rowSize, rowSize);
+    }
+
+    // zlib stream of stored blocks of at most 65535 bytes
+    vector<unsigned char> idat;
+    idat.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+    idat.push_back(0x78);
+    idat.push_back(0x01);
+
+    unsigned long a = 1, b = 0;
+    for (size_t i = 0; i < raw.size(); i += 65535)
+    {
+        size_t n = min(raw.size() - i, size_t(65535));
+        idat.push_back(i + n == raw.size() ? 1 : 0);
+        idat.push_back((unsigned char)n);
+        idat.push_back((unsigned char)(n >> 8));
+        idat.push_back((unsigned char)~n);
+        idat.push_back((unsigned char)(~n >> 8));
+        idat.insert(idat.end(), raw.begin() + i, raw.begin() + i + n);
+
+        for (size_t k = i; k < i + n; k++)
+        {
+            a = (a + raw[k]) % 65521;
+            b = (b + a) % 65521;
+        }
+    }
+    unsigned long adler = (b << 16) | a;
+    for (int i = 0; i < 4; i++) idat.push_back((unsigned char)(adler >> (24 - 8 * i)));
+    writeChunk(file, "IDAT", idat);
+
+    writeChunk(file, "IEND", vector<unsigned char>());
+
+    return file.good();
+}
+
+// Resolve the frame and read it back if it is to be captured
+static void
+captureHeadlessFrame(int frame)
+{
+    bool last = (frame == headlessFrames - 1);
+    if (!capturePrefix || !(last || (captureEvery > 0 && frame % captureEvery == 0))) return;
+
+    if (headlessFBO)
+    {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, headlessFBO);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, resolveFBO);
+        glBlitFramebuffer(0, 0, headlessW, headlessH, 0, 0, headlessW, headlessH, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, resolveFBO);
+    }
+    else glReadBuffer(GL_BACK);
+
+    static vector<unsigned char> pixels;
+    pixels.resize(3 * size_t(headlessW) * headlessH);
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, headlessW, headlessH, GL_RGB, GL_UNSIGNED_BYTE, &pixels[0]);
+
+    if (headlessFBO) glBindFramebuffer(GL_FRAMEBUFFER, headlessFBO);
+
+    char filename[1024];
+    snprintf(filename, sizeof(filename), "%s_%04d.png", capturePrefix, frame);
+    if (writePNG(filename, headlessW, headlessH, &pixels[0]))
+        cerr << "Status: Captured " << filename << endl;
+    else
+        cerr << "ERROR: Failed in writing " << filename << endl;
+}
+
+static double
+percentile(vector<double>& v, double p)
+{
+    if (v.empty()) return -1;
+
+    size_t k = min(size_t(p / 100.0 * v.size()), v.size() - 1);
+    nth_element(v.begin(), v.begin() + k, v.end());
+
+    return v[k] * 1000.0;
+}
+
+static void
+printHeadlessStatistics()
+{
+    double total = glfwGetTime() - headlessStart;
+    int n = int(headlessFrameTime.size());
+
+    cout << endl;
+    cout << "Headless: " << n << " frames of " << headlessW << "x" << headlessH << " in "
+        << total << " s (" << n / total << " fps)" << endl;
+    cout << "Headless: frame p50 " << percentile(headlessFrameTime, 50)
+        << " p95 " << percentile(headlessFrameTime, 95)
+        << " p99 " << percentile(headlessFrameTime, 99) << " ms" << endl;
+    if (!headlessGPUTime.empty())
+        cout << "Headless: GPU   p50 " << percentile(headlessGPUTime, 50)
+            << " p95 " << percentile(headlessGPUTime, 95)
+            << " p99 " << percentile(headlessGPUTime, 99) << " ms" << endl;
+    for (int i = 0; i < NUM_TIMING_SCOPES; i++)
+        cout << "Headless: " << timingScopeName[i] << " mean " << headlessScopeTime[i] / n * 1000.0 << " ms" << endl;
+}
+
+// --timing for the overlay and --timing-csv file for the per-frame timings
+static void
+parseTimingOptions(int argc, char* argv[])
+{
+    windowTitle = argv[0];
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--timing") == 0) timingOverlay = true;
+        else if (strcmp(argv[i], "--timing-csv") == 0 && i + 1 < argc) timingCSVFile = argv[++i];
+    }
+}
+
+static FrameTiming&
+currentFrameTiming()
+{
+    return frameTiming[frameCount % TIMING_FRAMES];
+}
+
+static void
+beginFrame()
+{
+    if (frameCount == 0)
+    {
+        // GPU time of every frame in a ring of queries so that it never waits for the results
+        gpuTiming = (GLEW_VERSION_3_3 || GLEW_ARB_timer_query) ? true : false;
+        if (gpuTiming) glGenQueries(GPU_QUERIES, gpuQuery);
+        for (int i = 0; i < GPU_QUERIES; i++) gpuQueryFrame[i] = -1;
+
+        if (timingCSVFile)
+        {
+            timingCSV.open(timingCSVFile);
+            timingCSV << "frame";
+            for (int i = 0; i < NUM_TIMING_SCOPES; i++) timingCSV << "," << timingScopeName[i];
+            timingCSV << ",frame_total,gpu" << endl;
+        }
+    }
+
+    FrameTiming& t = currentFrameTiming();
+    for (int i = 0; i < NUM_TIMING_SCOPES; i++) t.scope[i] = 0;
+    t.frame = -1;
+    t.gpu = -1;
+
+    // Only when the times are shown or recorded, as no other GL_TIME_ELAPSED query of the
+    // samples may be active at the same time
+    bool recorded = timingOverlay || timingCSV.is_open() || headlessFrames > 0;
+    if (gpuTiming && recorded && gpuTimingSuspended == 0)
+    {
+        int q = frameCount % GPU_QUERIES;
+        glBeginQuery(GL_TIME_ELAPSED, gpuQuery[q]);
+        gpuQueryFrame[q] = frameCount;
+        gpuQueryActive = true;
+    }
+
+    frameStart = glfwGetTime();
+}
+
+void
+beginTiming(TimingScope scope)
+{
+    if (frameStart < 0) beginFrame();
+    scopeStart[scope] = glfwGetTime();
+}
+
+void
+endTiming(TimingScope scope)
+{
+    currentFrameTiming().scope[scope] += glfwGetTime() - scopeStart[scope];
+}
+
+void
+suspendGPUTiming()
+{
+    if (gpuTimingSuspended++ > 0 || !gpuQueryActive) return;
+
+    // The partial time of the frame is discarded.
+    glEndQuery(GL_TIME_ELAPSED);
+    gpuQueryActive = false;
+    gpuQueryFrame[frameCount % GPU_QUERIES] = -1;
+}
+
+void
+resumeGPUTiming()
+{
+    if (gpuTimingSuspended > 0) gpuTimingSuspended--;
+}
+
+// Results of the queries already available, including the one just ended
+static void
+collectGPUTiming()
+{
+    for (int i = 0; i < GPU_QUERIES; i++)
+    {
+        if (gpuQueryFrame[i] < 0) continue;
+
+        GLint available = 0;
+        glGetQueryObjectiv(gpuQuery[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) continue;
+
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(gpuQuery[i], GL_QUERY_RESULT, &ns);
+        if (frameCount - gpuQueryFrame[i] < TIMING_FRAMES)
+            frameTiming[gpuQueryFrame[i] % TIMING_FRAMES].gpu = ns * 1.0e-9;
+        if (headlessFrames > 0) headlessGPUTime.push_back(ns * 1.0e-9);
+
+        gpuQueryFrame[i] = -1;
+    }
+}
+
+// p-th percentile of the completed frames in the rolling window in milliseconds
+double
+timingPercentile(double p, bool gpu)
+{
+    static double v[TIMING_FRAMES];
+
+    int n = 0;
+    for (int i = 0; i < min(frameCount, TIMING_FRAMES); i++)
+    {
+        double x = gpu ? frameTiming[i].gpu : frameTiming[i].frame;
+        if (x >= 0) v[n++] = x;
+    }
+    if (n == 0) return -1;
+
+    int k = min(int(p / 100.0 * n), n - 1);
+    nth_element(v, v + k, v + n);
+
+    return v[k] * 1000.0;
+}
+
+// Rectangle in pixels filled with a scissored clear, which works in both the legacy and
+// the core profiles without any shader or state other than the scissor box
+static void
+fillRect(int x, int y, int w, int h, float r, float g, float b)
+{
+    if (w <= 0 || h <= 0) return;
+
+    glScissor(x, y, w, h);
+    glClearColor(r, g, b, 1);
+    glClear(GL_COLOR_BUFFER_BIT);
+}
+
+// Stacked CPU scopes and GPU ticks of the last frames, and the histogram of the frame
+// times with the 50th, 95th and 99th percentiles
+static void
+drawTimingOverlay()
+{
+    GLfloat clearColor[4];
+    GLint scissorBox[4];
+    GLboolean scissorTest = glIsEnabled(GL_SCISSOR_TEST);
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+    glGetIntegerv(GL_SCISSOR_BOX, scissorBox);
+    glEnable(GL_SCISSOR_TEST);
+
+    int s = max(int(dpiScaling + 0.5f), 1);
+    int x0 = 8 * s, y0 = 8 * s, H = 100 * s, bar = 2 * s;
+    int graphW = GRAPH_FRAMES * bar;
+    const int nBins = 32;
+    int binW = 3 * s;
+    int histX0 = x0 + graphW + 8 * s;
+    double pixelsPerMs = H / GRAPH_MS;
+
+    // Background and the 60Hz budget
+    fillRect(x0 - 4 * s, y0 - 4 * s, graphW + nBins * binW + 16 * s, H + 8 * s, 0.1f, 0.1f, 0.1f);
+    fillRect(x0, y0 + int(1000.0 / 60.0 * pixelsPerMs), graphW, s, 0.4f, 0.4f, 0.4f);
+
+    // Frame-time graph
+    int n = min(frameCount, GRAPH_FRAMES);
+    for (int i = 0; i < n; i++)
+    {
+        const FrameTiming& t = frameTiming[(frameCount - n + i) % TIMING_FRAMES];
+        int x = x0 + (GRAPH_FRAMES - n + i) * bar;
+
+        int y = y0;
+        for (int k = 0; k < NUM_TIMING_SCOPES; k++)
+        {
+            int h = min(int(t.scope[k] * 1000.0 * pixelsPerMs + 0.5), y0 + H - y);
+            const float* c = timingScopeColor[k];
+            fillRect(x, y, bar, h, c[0], c[1], c[2]);
+            y += h;
+        }
+
+        // Rest of the frame not covered by the scopes
+        fillRect(x, y, bar, min(int(t.frame * 1000.0 * pixelsPerMs + 0.5), H) - (y - y0),
+            0.3f, 0.3f, 0.3f);
+
+        if (t.gpu >= 0)
+            fillRect(x, y0 + min(int(t.gpu * 1000.0 * pixelsPerMs), H - s), bar, s, 1, 1, 1);
+    }
+
+    // Histogram of the frame times
+    int count[nBins] = { 0 }, maxCount = 1;
+    for (int i = 0; i < min(frameCount, TIMING_FRAMES); i++)
+    {
+        if (frameTiming[i].frame < 0) continue;
+
+        int b = min(int(frameTiming[i].frame * 1000.0 / GRAPH_MS * nBins), nBins - 1);
+        maxCount = max(maxCount, ++count[b]);
+    }
+    for (int b = 0; b < nBins; b++)
+        fillRect(histX0 + b * binW, y0, binW - 1, count[b] * H / maxCount, 0.2f, 0.6f, 0.9f);
+
+    const double percentile[3] = { 50, 95, 99 };
+    const float percentileColor[3][3] = { { 1, 1, 1 }, { 1, 1, 0 }, { 1, 0, 0 } };
+    for (int i = 0; i < 3; i++)
+    {
+        double ms = min(timingPercentile(percentile[i]), GRAPH_MS);
+        if (ms < 0) continue;
+
+        const float* c = percentileColor[i];
+        fillRect(histX0 + int(ms / GRAPH_MS * nBins * binW), y0, s, H, c[0], c[1], c[2]);
+    }
+
+    glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+    glScissor(scissorBox[0], scissorBox[1], scissorBox[2], scissorBox[3]);
+    if (!scissorTest) glDisable(GL_SCISSOR_TEST);
+}
+
+// The numbers of the overlay in the window title twice a second
+static void
+updateTimingTitle(GLFWwindow* window)
+{
+    double now = glfwGetTime();
+    if (now - titleTime < 0.5) return;
+    titleTime = now;
+
+    char title[256];
+    snprintf(title, sizeof(title), "%s | frame p50 %.2f p95 %.2f p99 %.2f ms | GPU p50 %.2f p95 %.2f ms",
+        windowTitle.c_str(), timingPercentile(50), timingPercentile(95), timingPercentile(99),
+        timingPercentile(50, true), timingPercentile(95, true));
+    glfwSetWindowTitle(window, title);
+}
+
+void
+swapBuffers(GLFWwindow* window)
+{
+    if (frameStart < 0) beginFrame();
+    if (gpuQueryActive)
+    {
+        glEndQuery(GL_TIME_ELAPSED);
+        gpuQueryActive = false;
+    }
+
+    // F1 toggles the overlay. Polled to keep the keyboard callbacks of the samples.
+    static int previousF1 = GLFW_RELEASE;
+    int f1 = glfwGetKey(window, GLFW_KEY_F1);
+    if (f1 == GLFW_PRESS && previousF1 == GLFW_RELEASE)
+    {
+        timingOverlay = !timingOverlay;
+        if (!timingOverlay) glfwSetWindowTitle(window, windowTitle.c_str());
+    }
+    previousF1 = f1;
+
+    if (timingOverlay) drawTimingOverlay();
+
+    // Readback of the captures in place of the swap in the headless mode
+    beginTiming(TIMING_SWAP);
+    if (headlessFrames > 0) captureHeadlessFrame(frameCount);
+    else                    glfwSwapBuffers(window);
+    endTiming(TIMING_SWAP);
+
+    FrameTiming& t = currentFrameTiming();
+    t.frame = glfwGetTime() - frameStart;
+    if (headlessFrames > 0)
+    {
+        headlessFrameTime.push_back(t.frame);
+        for (int i = 0; i < NUM_TIMING_SCOPES; i++) headlessScopeTime[i] += t.scope[i];
+    }
+    frameCount++;
+
+    if (gpuTiming) collectGPUTiming();
+    if (timingOverlay) updateTimingTitle(window);
+
+    // End of the headless run after all the GPU times have arrived
+    bool finished = (headlessFrames > 0 && frameCount == headlessFrames);
+    if (finished)
+    {
+        glFinish();
+        if (gpuTiming) collectGPUTiming();
+
+        printHeadlessStatistics();
+        glfwSetWindowShouldClose(window, GL_TRUE);
+    }
+
+    // Rows are written when the GPU time can no longer arrive
+    if (timingCSV.is_open())
+    {
+        int last = finished ? frameCount - 1 : frameCount - GPU_QUERIES - 1;
+        for (; csvFrame <= last; csvFrame++)
+        {
+            const FrameTiming& t = frameTiming[csvFrame % TIMING_FRAMES];
+            timingCSV << csvFrame;
+            for (int i = 0; i < NUM_TIMING_SCOPES; i++) timingCSV << "," << t.scope[i] * 1000.0;
+            timingCSV << "," << t.frame * 1000.0 << ",";
+            if (t.gpu >= 0) timingCSV << t.gpu * 1000.0;
+            timingCSV << "\n";
+        }
+    }
+
+    beginFrame();
+}
+
 GLFWwindow* initializeOpenGL(int argc, char* argv[], GLfloat bgColor[4], bool modern)
 {
+    // Frame timing options
+    parseTimingOptions(argc, argv);
+
+    // Headless rendering options
+    parseHeadlessOptions(argc, argv);
+
     glfwSetErrorCallback(errorCallback); // óִ ݹ
 
     // Init GLFW
-    if (!glfwInit()) exit(EXIT_FAILURE); // ʱȭ н α׷ .
+    // Null platform of GLFW for the headless mode without any display server
+    if (!glfwInit() && !initHeadlessPlatform()) exit(EXIT_FAILURE); // ʱȭ н α׷ .
 
     if (modern) // Enable OpenGL 4.1 in OS X
     {
@@ -82,6 +708,9 @@ GLFWwindow* initializeOpenGL(int argc, char* argv[], GLfloat bgColor[4], bool mo
 
     glfwWindowHint(GLFW_SAMPLES, 4);
 
+    // Invisible window only for the context in the headless mode
+    if (headlessFrames > 0) glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
     // Create the window ( OpenGl   ִ Window )
     GLFWmonitor* monitor = glfwGetPrimaryMonitor(); // glfw  ͵ .
     int monitorW, monitorH;
@@ -98,6 +727,14 @@ GLFWwindow* initializeOpenGL(int argc, char* argv[], GLfloat bgColor[4], bool mo
 
 
     if (!fullScreen || !noMenuBar) monitor = NULL;
+
+    // Window of the fixed size of the offscreen framebuffer in the headless mode
+    if (headlessFrames > 0)
+    {
+        screenW = headlessW;
+        screenH = headlessH;
+        monitor = NULL;
+    }
     GLFWwindow* window = glfwCreateWindow(screenW, screenH, argv[0], monitor, NULL);
 
     if (!window)
@@ -141,23 +778,23 @@ GLFWwindow* initializeOpenGL(int argc, char* argv[], GLfloat bgColor[4], bool mo
     //װ ȴٸ 0 ƴ  ȴ.
     // 0̶   ȭ  
 
-    if (modern)
-    {
-        //GLSL version for shader loading
-        cout << "Status: GLSL " << glGetString(GL_SHADING_LANGUAGE_VERSION) << endl;
-
-        //GLEW : Supported version can be verified in glew.sourceforge.net/basic.html
-        cerr << "Status: GLEW " << glewGetString(GLEW_VERSION) << endl;
+    //GLSL version for shader loading
+    cout << "Status: GLSL " << glGetString(GL_SHADING_LANGUAGE_VERSION) << endl;
 
-        // Initiallizing GLEW
-        GLenum error = glewInit();
-        if (error != GLEW_OK)
-        {
-            cerr << "ERROR: " << glewGetErrorString(error) << endl;
-            return 0;
-        }
+    //GLEW : Supported version can be verified in glew.sourceforge.net/basic.html
+    cerr << "Status: GLEW " << glewGetString(GLEW_VERSION) << endl;
 
+    // Initiallizing GLEW: the legacy context also needs it for the sphere impostors
+    GLenum error = glewInit();
+    if (error != GLEW_OK)
+    {
+        cerr << "ERROR: " << glewGetErrorString(error) << endl;
+        return 0;
     }
+    // Offscreen framebuffer of the headless mode
+    if (headlessFrames > 0 && !createHeadlessFramebuffer()) return NULL;
+
+
     return window;
 }
 
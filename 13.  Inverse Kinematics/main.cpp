@@ -1,9 +1,11 @@
 #include "glSetup.h"
+#include "glSphere.h"
 
 #include <Eigen/Dense>
 using namespace Eigen;
 
 #include <iostream>
+#include <vector>
 using namespace std;
 
 #ifdef _WIN32
@@ -33,6 +35,13 @@ GLfloat bgColor[4] = { 1,1,1,1 };
 GLUquadricObj* sphere = NULL;
 GLUquadricObj* cylinder = NULL;
 
+// Joint spheres: quadrics or ray-cast impostors drawn in one call at the end of the frame
+bool				useImpostors = false;
+InstancedSpheres	jointSpheres;
+vector<Vector3f>	jointCenter;	// In the eye coordinate system
+vector<float>		jointRadius;
+vector<Vector3f>	jointColor;
+
 // Joint and links
 const int	nLinks = 3;
 float linkLength[nLinks] = { 0.4f,0.4f,0.4f };
@@ -94,6 +103,7 @@ int main(int argc, char* argv[])
 	// Main loop
 	while (!glfwWindowShouldClose(window))
 	{
+		beginTiming(TIMING_SIMULATE);
 		if (target)  // target  IK Ǭ. // Ǯ  ̴ .
 		{
 			// Solve the inverse kinematics problem
@@ -102,10 +112,15 @@ int main(int argc, char* argv[])
 			// If solved, then turn off the target pointer in the screen
 			if (solved) target = false;
 		}
+		endTiming(TIMING_SIMULATE);
 
+		beginTiming(TIMING_RENDER);
 		render(window);          // Draw one frames  
-		glfwSwapBuffers(window); // Swap buffers
+		endTiming(TIMING_RENDER);
+		swapBuffers(window); // Swap buffers
+		beginTiming(TIMING_UPDATE);
 		glfwPollEvents();		 // Events
+		endTiming(TIMING_UPDATE);
 	}
 
 	//Finalization
@@ -135,12 +150,21 @@ init()
 	gluQuadricOrientation(cylinder, GLU_OUTSIDE);
 	gluQuadricTexture(cylinder, GL_FALSE);
 
+	// Sphere impostors for the joints
+	if (!createSphereImpostors(jointSpheres, "sv13_sphere_impostor.glsl",
+		"sf13_sphere_impostor.glsl"))
+	{
+		cerr << "Sphere impostors are not available" << endl;
+		deleteInstancedSpheres(jointSpheres);
+	}
+
 	// Keyboard and mouse
 	cout << "Keyboard Input: [1:3] for joint selection" << endl;
 	cout << "Keyboard Input: left/right for adjusting joint angles" << endl;
 	cout << "Keyboard Input: j for Jacobian transpose method" << endl;
 	cout << "Keyboard Input: p for the pseudoinverse method" << endl;
 	cout << "Keyboard Input: d for the damped least squares method" << endl;
+	cout << "Keyboard Input: s for the sphere impostors on/off" << endl;
 	cout << "Mouse Input: desired position of the end-effector" << endl;
 }
 
@@ -149,6 +173,9 @@ void quit()
 	// Delete quadric shapes
 	gluDeleteQuadric(sphere);
 	gluDeleteQuadric(cylinder);
+
+	// Delete the sphere impostors
+	deleteInstancedSpheres(jointSpheres);
 }
 
 // Light
@@ -206,8 +233,51 @@ void drawCylinder(float radius, float height, const Vector3f& color)
 }
 
 
+// Queue a sphere centered at p in the current modelview coordinate system
+void queueJointSphere(const Vector3f& p, float radius, const Vector3f& color)
+{
+	Matrix4f	M;
+	glGetFloatv(GL_MODELVIEW_MATRIX, M.data());
+
+	jointCenter.push_back((M * p.homogeneous()).head<3>());
+	jointRadius.push_back(radius * M.col(0).head<3>().norm());
+	jointColor.push_back(color);
+}
+
+// Draw all the queued joint spheres with a single instanced call
+void flushJointSpheres()
+{
+	if (jointCenter.empty()) return;
+
+	// The centers are already in the eye coordinate system
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+
+	uploadInstances(jointSpheres, (int)jointCenter.size(), jointCenter[0].data(),
+		jointRadius.data(), jointColor[0].data());
+	drawSphereImpostors(jointSpheres);
+
+	glPopMatrix();
+
+	jointCenter.clear();
+	jointRadius.clear();
+	jointColor.clear();
+}
+
 void drawJoint(float radius, const Vector3f& color)
 {
+	if (useImpostors)
+	{
+		// Front and rear spheres as 4-vertex impostors
+		queueJointSphere(Vector3f(0, 0, radius), radius, color);
+		queueJointSphere(Vector3f(0, 0, -radius), radius, color);
+
+		// Cylinder
+		drawCylinder(radius, radius, color);
+		return;
+	}
+
 	glPushMatrix();
 
 	// Front sphere
@@ -500,6 +570,8 @@ void render(GLFWwindow* window)
 	glLoadMatrixf(T.data());
 	drawJoint(radiusJoint, Vector3f(0.95f, 0.95f, 0.0f)); // Draw the EE as a joint
 
+	// Joint spheres queued as impostors
+	flushJointSpheres();
 }
 
 
@@ -526,6 +598,12 @@ void keyboard(GLFWwindow* window, int key, int scancode, int action, int mods)
 		case GLFW_KEY_J: method = JACOBIAN_TRANSPOSE; break;
 		case GLFW_KEY_P: method = PSEUDOINVERSE; break;
 		case GLFW_KEY_D: method = DAMPED_LEAST_SQUARES; break;
+
+			// Joint spheres
+		case GLFW_KEY_S:
+			useImpostors = !useImpostors && jointSpheres.impostorProgram;
+			cout << "Sphere impostors " << (useImpostors ? "on" : "off") << endl;
+			break;
 		}
 
 		// Target off
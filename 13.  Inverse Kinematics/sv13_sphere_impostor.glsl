@@ -0,0 +1,43 @@
+#version 120
+
+// Corner of the billboard in [-1, 1]^2, drawn as a 4-vertex triangle strip
+attribute vec2	vCorner;
+
+// Per-instance attributes: glVertexAttribDivisor(location, 1)
+attribute vec3	iPosition;
+attribute float	iRadius;
+attribute vec3	iColor;
+
+// In the eye coordinate system
+varying vec3	position;		// Point on the billboard
+varying vec3	center;			// Center of the sphere
+varying float	radius;
+varying vec3	color;
+
+void
+main(void)
+{
+	center = vec3(gl_ModelViewMatrix * vec4(iPosition, 1.0));
+	radius = iRadius * length(gl_ModelViewMatrix[0].xyz);	// Uniform scaling only
+	color = iColor;
+
+	// Billboard perpendicular to the ray through the center
+	vec3	right = vec3(1, 0, 0);
+	vec3	up = vec3(0, 1, 0);
+	float	size = radius;
+
+	bool	orthographic = (gl_ProjectionMatrix[2][3] == 0.0);
+	if (!orthographic)
+	{
+		// Silhouette of the sphere seen from the eye, projected onto the billboard plane
+		float	d = length(center);
+		vec3	w = center / d;
+		right = normalize(cross(w, up));
+		up = cross(right, w);
+		size = radius * d / sqrt(max(d * d - radius * radius, 1.0E-6));
+	}
+
+	position = center + size * (vCorner.x * right + vCorner.y * up);
+
+	gl_Position = gl_ProjectionMatrix * vec4(position, 1.0);
+}
@@ -28,4 +28,33 @@ void		setupProjectionMatrix();
 
 void		drawAxes(float l, float w);
 
+// Frame timing: CPU scopes, GPU time of the frames with GL_TIME_ELAPSED queries, and an
+// overlay of the frame-time graph and histogram toggled with F1
+enum TimingScope
+{
+	TIMING_UPDATE = 0,	// Events and the frame bookkeeping
+	TIMING_SIMULATE,	// Simulation or animation
+	TIMING_RENDER,		// Issuing the draw calls
+	TIMING_SWAP,		// glfwSwapBuffers()
+	NUM_TIMING_SCOPES
+};
+
+extern bool			timingOverlay;		// --timing on the command line
+extern const char*	timingCSVFile;		// --timing-csv file on the command line
+
+void		beginTiming(TimingScope scope);
+void		endTiming(TimingScope scope);
+void		swapBuffers(GLFWwindow* window);	// Timed glfwSwapBuffers() closing the frame
+double		timingPercentile(double p, bool gpu = false);	// In milliseconds
+
+// Ends the GPU time query of the frame for the GL_TIME_ELAPSED queries of a benchmark within
+// it, leaving the frame without a GPU time. The frames after resumeGPUTiming() are timed again.
+void		suspendGPUTiming();
+void		resumeGPUTiming();
+
+// Headless rendering: --headless N renders N frames into an offscreen framebuffer of
+// --size WxH (1280x720 by default) behind an invisible window, writes PNG captures with
+// --capture prefix [--capture-every K], prints the timing statistics and closes the window
+extern int	headlessFrames;
+
 #endif	// __GL_SETUP_H_
@@ -165,15 +165,21 @@ main(int argc, char* argv[])
 	// Main loop
 	while (!glfwWindowShouldClose(window))
 	{
+		beginTiming(TIMING_SIMULATE);
 		// Update one frame if not paused
 		if (!pause) update(ModelMatrix);
+		endTiming(TIMING_SIMULATE);
 
+		beginTiming(TIMING_RENDER);
 		// Draw one frame
 		if (phong)	render(window, programPhong, vao, numTris, ModelMatrix);
 		else        render(window, programGouraud, vao, numTris, ModelMatrix);
+		endTiming(TIMING_RENDER);
 
-		glfwSwapBuffers(window);	// Swap buffers
+		swapBuffers(window);	// Swap buffers
+		beginTiming(TIMING_UPDATE);
 		glfwPollEvents();			// Events
+		endTiming(TIMING_UPDATE);
 	}
 
 	// Finalization
@@ -4,7 +4,12 @@
 
 #include "glShader.h"
 
+#include <math.h>
+#include <stddef.h>
+
+#include <algorithm>
 #include <iostream>
+#include <vector>
 using namespace std;
 
 
@@ -428,6 +433,101 @@ uploadMesh2VBO(ArrayXXi& face, MatrixXf& vertex, MatrixXf& normal, MatrixXf& tex
 	return numTris;
 }
 
+// Signed normalized x, y, z in 10 bits and w in 2 bits
+GLuint
+packSNorm2101010(float x, float y, float z, float w)
+{
+	float	v[4] = { x, y, z, w };
+	GLuint	bits[4] = { 10, 10, 10, 2 };
+
+	GLuint	packed = 0;
+	for (int i = 0, shift = 0; i < 4; shift += bits[i], i++)
+	{
+		float	scale = float((1 << (bits[i] - 1)) - 1);
+		int		c = int(floor(min(max(v[i], -1.0f), 1.0f) * scale + 0.5f));
+		packed |= (GLuint(c) & ((1u << bits[i]) - 1)) << shift;
+	}
+
+	return packed;
+}
+
+// Vertex of the interleaved VBO, 28 bytes
+struct InterleavedVertex
+{
+	GLfloat	position[3];
+	GLuint	normal;			// GL_INT_2_10_10_10_REV
+	GLfloat	texcoord[2];
+	GLuint	tangent;		// GL_INT_2_10_10_10_REV with the handedness in w
+};
+
+void
+createInterleavedVBO(GLuint& vao, GLuint& indexId, GLuint& vertexId)
+{
+	if (indexId == 0)
+	{
+		glGenVertexArrays(1, &vao);
+
+		glGenBuffers(1, &indexId);		// Buffer for triangle indices
+		glGenBuffers(1, &vertexId);		// Buffer for interleaved vertex attributes
+
+		isOK("createInterleavedVBO()", __FILE__, __LINE__);
+	}
+}
+
+// Positions at 0, normals at 1, texture coordinates at 2 and tangents at 3
+int
+uploadMesh2InterleavedVBO(ArrayXXi& face, MatrixXf& vertex, MatrixXf& normal, MatrixXf& texture,
+	MatrixXf& tangent, GLuint vao, GLuint indexId, GLuint vertexId)
+{
+	int numTris = face.cols();
+	int numVertices = vertex.cols();
+
+	vector<InterleavedVertex>	data(numVertices);
+	for (int i = 0; i < numVertices; i++)
+	{
+		InterleavedVertex&	v = data[i];
+		for (int k = 0; k < 3; k++) v.position[k] = vertex(k, i);
+		v.normal = packSNorm2101010(normal(0, i), normal(1, i), normal(2, i), 0);
+		v.texcoord[0] = texture(0, i);
+		v.texcoord[1] = texture(1, i);
+		v.tangent = packSNorm2101010(tangent(0, i), tangent(1, i), tangent(2, i), tangent(3, i));
+	}
+
+	glBindVertexArray(vao);
+
+	// Index: indices
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexId);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, numTris * 3 * sizeof(GLuint), face.data(),
+		GL_STATIC_DRAW);
+
+	// All the attributes in one buffer
+	glBindBuffer(GL_ARRAY_BUFFER, vertexId);
+	glBufferData(GL_ARRAY_BUFFER, numVertices * sizeof(InterleavedVertex), &data[0],
+		GL_STATIC_DRAW);
+
+	// Layout of the vertex array
+	GLsizei	stride = sizeof(InterleavedVertex);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride,
+		(void*)offsetof(InterleavedVertex, position));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride,
+		(void*)offsetof(InterleavedVertex, normal));
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride,
+		(void*)offsetof(InterleavedVertex, texcoord));
+	glEnableVertexAttribArray(3);
+	glVertexAttribPointer(3, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride,
+		(void*)offsetof(InterleavedVertex, tangent));
+
+	glBindVertexArray(0);
+
+	// Check the status
+	isOK("uploadMesh2InterleavedVBO()", __FILE__, __LINE__);
+
+	return numTris;
+}
+
 void
 drawVBO(GLuint vao, int numTris)
 {
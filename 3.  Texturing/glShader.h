@@ -45,6 +45,14 @@ int		uploadMesh2VBO(ArrayXXi& face, MatrixXf& vertex, MatrixXf& normal,
 int		uploadMesh2VBO(ArrayXXi& face, MatrixXf& vertex, MatrixXf& normal,
 	MatrixXf& texture, GLuint vao, GLuint indexId, GLuint vertexId,
 	GLuint normalId, GLuint texId);
+// Positions, texture coordinates and the normals and the tangents packed into
+// GL_INT_2_10_10_10_REV in a single buffer. tangent is 4 x # of vertices with the sign of
+// the bitangent in w.
+GLuint	packSNorm2101010(float x, float y, float z, float w);
+void	createInterleavedVBO(GLuint& vao, GLuint& indexId, GLuint& vertexId);
+int		uploadMesh2InterleavedVBO(ArrayXXi& face, MatrixXf& vertex, MatrixXf& normal,
+	MatrixXf& texture, MatrixXf& tangent, GLuint vao, GLuint indexId, GLuint vertexId);
+
 void	drawVBO(GLuint vao, int numTriangles);
 void	deleteVBO(GLuint& vao, GLuint& indexId, GLuint& vertexId, GLuint& normalId);
 void	deleteVBO(GLuint& vao, GLuint& indexId, GLuint& vertexId, GLuint& normalId,
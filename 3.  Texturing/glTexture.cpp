@@ -0,0 +1,643 @@
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "glTexture.h"
+#include "glShader.h"
+#include "textureFile.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+using namespace std;
+
+// SSSE3 is implied by AVX, the only switch MSVC offers above SSE2
+#if defined(__SSSE3__) || defined(__AVX__)
+#define TEXTURE_SSSE3
+#include <tmmintrin.h>
+#else
+#include <xmmintrin.h>	// _mm_malloc()
+#endif
+
+MappedFile::MappedFile()
+{
+	data = NULL;
+	size = 0;
+
+#ifdef _WIN32
+	file = INVALID_HANDLE_VALUE;
+	mapping = NULL;
+#else
+	fd = -1;
+#endif
+}
+
+bool
+mapFile(const char* filename, MappedFile& file)
+{
+#ifdef _WIN32
+	file.file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file.file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER	size;
+	GetFileSizeEx(file.file, &size);
+	file.size = size_t(size.QuadPart);
+	if (file.size == 0) return true;
+
+	file.mapping = CreateFileMappingA(file.file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (file.mapping) file.data = (const GLubyte*)MapViewOfFile(file.mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+	file.fd = open(filename, O_RDONLY);
+	if (file.fd < 0) return false;
+
+	struct stat	st;
+	fstat(file.fd, &st);
+	file.size = size_t(st.st_size);
+	if (file.size == 0) return true;
+
+	void*	data = mmap(NULL, file.size, PROT_READ, MAP_PRIVATE, file.fd, 0);
+	if (data != MAP_FAILED)
+	{
+		file.data = (const GLubyte*)data;
+		madvise(data, file.size, MADV_SEQUENTIAL);
+	}
+#endif
+
+	if (file.data == NULL)
+	{
+		unmapFile(file);
+		return false;
+	}
+
+	return true;
+}
+
+void
+unmapFile(MappedFile& file)
+{
+#ifdef _WIN32
+	if (file.data) UnmapViewOfFile(file.data);
+	if (file.mapping) CloseHandle(file.mapping);
+	if (file.file != INVALID_HANDLE_VALUE) CloseHandle(file.file);
+#else
+	if (file.data) munmap((void*)file.data, file.size);
+	if (file.fd >= 0) close(file.fd);
+#endif
+
+	file = MappedFile();
+}
+
+//
+// Staging arena
+//
+static GLubyte*	arena = NULL;
+static size_t	arenaSize = 0;
+static int		arenaAllocations = 0;
+
+GLubyte*
+stagingArena(size_t size)
+{
+	if (size > arenaSize)
+	{
+		if (arena) _mm_free(arena);
+
+		arenaSize = max(size, 2 * arenaSize);
+		arena = (GLubyte*)_mm_malloc(arenaSize, 32);
+		arenaAllocations++;
+	}
+
+	return arena;
+}
+
+void
+freeStagingArena()
+{
+	if (arena) _mm_free(arena);
+
+	arena = NULL;
+	arenaSize = 0;
+}
+
+int
+stagingAllocations()
+{
+	return arenaAllocations;
+}
+
+//
+// Channel packing, 16 texels per iteration with SSSE3
+//
+void
+packGrayToRGB(const GLubyte* gray, GLubyte* rgb, int n)
+{
+	int	i = 0;
+
+#ifdef TEXTURE_SSSE3
+	const __m128i	m0 = _mm_setr_epi8(0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 3, 4, 4, 4, 5);
+	const __m128i	m1 = _mm_setr_epi8(5, 5, 6, 6, 6, 7, 7, 7, 8, 8, 8, 9, 9, 9, 10, 10);
+	const __m128i	m2 = _mm_setr_epi8(10, 11, 11, 11, 12, 12, 12, 13, 13, 13, 14, 14, 14, 15, 15, 15);
+
+	for (; i + 16 <= n; i += 16)
+	{
+		__m128i	g = _mm_loadu_si128((const __m128i*)(gray + i));
+
+		_mm_storeu_si128((__m128i*)(rgb + 3 * i + 0), _mm_shuffle_epi8(g, m0));
+		_mm_storeu_si128((__m128i*)(rgb + 3 * i + 16), _mm_shuffle_epi8(g, m1));
+		_mm_storeu_si128((__m128i*)(rgb + 3 * i + 32), _mm_shuffle_epi8(g, m2));
+	}
+#endif
+
+	for (; i < n; i++)
+		rgb[3 * i + 0] = rgb[3 * i + 1] = rgb[3 * i + 2] = gray[i];
+}
+
+void
+packAlphaToRGBA(const GLubyte* alpha, GLubyte* rgba, int n)
+{
+	int	i = 0;
+
+#ifdef TEXTURE_SSSE3
+	// Byte k of the alpha into the byte 4k+3 with zeros elsewhere
+	const __m128i	m[4] = {
+		_mm_setr_epi8(-1, -1, -1, 0, -1, -1, -1, 1, -1, -1, -1, 2, -1, -1, -1, 3),
+		_mm_setr_epi8(-1, -1, -1, 4, -1, -1, -1, 5, -1, -1, -1, 6, -1, -1, -1, 7),
+		_mm_setr_epi8(-1, -1, -1, 8, -1, -1, -1, 9, -1, -1, -1, 10, -1, -1, -1, 11),
+		_mm_setr_epi8(-1, -1, -1, 12, -1, -1, -1, 13, -1, -1, -1, 14, -1, -1, -1, 15) };
+
+	for (; i + 16 <= n; i += 16)
+	{
+		__m128i	a = _mm_loadu_si128((const __m128i*)(alpha + i));
+
+		for (int k = 0; k < 4; k++)
+			_mm_storeu_si128((__m128i*)(rgba + 4 * i + 16 * k), _mm_shuffle_epi8(a, m[k]));
+	}
+#endif
+
+	for (; i < n; i++)
+	{
+		rgba[4 * i + 0] = 0;			// R
+		rgba[4 * i + 1] = 0;			// G
+		rgba[4 * i + 2] = 0;			// B
+		rgba[4 * i + 3] = alpha[i];		// A
+	}
+}
+
+void
+packRGBAlphaToRGBA(const GLubyte* rgb, const GLubyte* alpha, GLubyte* rgba, int n)
+{
+	int	i = 0;
+
+#ifdef TEXTURE_SSSE3
+	// 12 bytes of 4 texels into the RGB of the 16 bytes, and the alpha into the rest
+	const __m128i	mRGB = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+	const __m128i	mA[4] = {
+		_mm_setr_epi8(-1, -1, -1, 0, -1, -1, -1, 1, -1, -1, -1, 2, -1, -1, -1, 3),
+		_mm_setr_epi8(-1, -1, -1, 4, -1, -1, -1, 5, -1, -1, -1, 6, -1, -1, -1, 7),
+		_mm_setr_epi8(-1, -1, -1, 8, -1, -1, -1, 9, -1, -1, -1, 10, -1, -1, -1, 11),
+		_mm_setr_epi8(-1, -1, -1, 12, -1, -1, -1, 13, -1, -1, -1, 14, -1, -1, -1, 15) };
+
+	for (; i + 16 <= n; i += 16)
+	{
+		__m128i	c0 = _mm_loadu_si128((const __m128i*)(rgb + 3 * i + 0));
+		__m128i	c1 = _mm_loadu_si128((const __m128i*)(rgb + 3 * i + 16));
+		__m128i	c2 = _mm_loadu_si128((const __m128i*)(rgb + 3 * i + 32));
+		__m128i	a = _mm_loadu_si128((const __m128i*)(alpha + i));
+
+		// Bytes 0, 12, 24 and 36 of the 48 bytes at the front
+		__m128i	t[4] = { c0, _mm_alignr_epi8(c1, c0, 12), _mm_alignr_epi8(c2, c1, 8), _mm_srli_si128(c2, 4) };
+
+		for (int k = 0; k < 4; k++)
+		{
+			__m128i	p = _mm_or_si128(_mm_shuffle_epi8(t[k], mRGB), _mm_shuffle_epi8(a, mA[k]));
+			_mm_storeu_si128((__m128i*)(rgba + 4 * i + 16 * k), p);
+		}
+	}
+#endif
+
+	for (; i < n; i++)
+	{
+		rgba[4 * i + 0] = rgb[3 * i + 0];	// R
+		rgba[4 * i + 1] = rgb[3 * i + 1];	// G
+		rgba[4 * i + 2] = rgb[3 * i + 2];	// B
+		rgba[4 * i + 3] = alpha[i];			// A
+	}
+}
+
+//
+// Mipmaps
+//
+MipmapMode	mipmapMode = MIPMAP_CPU;
+MipFilter	mipmapFilter = MIP_KAISER;
+bool		mipmapBenchmark = false;
+
+static int
+numChannels(GLenum format)
+{
+	switch (format)
+	{
+	case GL_RED:	return 1;
+	case GL_RGB:	return 3;
+	default:		return 4;
+	}
+}
+
+// Best of a few runs of the CPU filters and glGenerateMipmap() on a scratch texture
+static void
+benchmarkMipmaps(GLenum internalFormat, GLenum format, int w, int h, const GLubyte* texel, bool wrap)
+{
+	const int	numRuns = 5;
+	double		mpixels = w * h / 1.0e6;
+
+	vector<MipLevel>	levels;
+	for (int f = 0; f < NUM_MIP_FILTERS; f++)
+	{
+		for (int srgb = 0; srgb < 2; srgb++)
+		{
+			double	best = 1.0e30;
+			for (int run = 0; run < numRuns; run++)
+			{
+				double	start = glfwGetTime();
+				buildMipChain(texel, w, h, numChannels(format), MipFilter(f), srgb != 0, wrap, levels);
+				best = min(best, glfwGetTime() - start);
+			}
+
+			cout << "Mipmap: " << w << "x" << h << " " << mipFilterName[f] << (srgb ? " sRGB" : "")
+				<< " on " << mipmapThreads() << " threads " << best * 1000.0 << " ms, "
+				<< mpixels / best << " Mpixels/s" << endl;
+		}
+	}
+
+	GLint	bound = 0;
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &bound);
+
+	GLuint	scratch = 0;
+	glGenTextures(1, &scratch);
+	glBindTexture(GL_TEXTURE_2D, scratch);
+	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, w, h, 0, format, GL_UNSIGNED_BYTE, texel);
+
+	double	best = 1.0e30;
+	for (int run = 0; run < numRuns; run++)
+	{
+		glFinish();
+		double	start = glfwGetTime();
+		glGenerateMipmap(GL_TEXTURE_2D);
+		glFinish();
+		best = min(best, glfwGetTime() - start);
+	}
+
+	cout << "Mipmap: " << w << "x" << h << " glGenerateMipmap() " << best * 1000.0 << " ms, "
+		<< mpixels / best << " Mpixels/s" << endl;
+
+	glDeleteTextures(1, &scratch);
+	glBindTexture(GL_TEXTURE_2D, bound);
+}
+
+void
+uploadTextureLayer(int w, int h, int layer, int numLayers, GLenum format, const GLubyte* texel,
+	bool srgb, bool wrap)
+{
+	if (mipmapBenchmark) benchmarkMipmaps(GL_RGBA8, format, w, h, texel, wrap);
+
+	// Levels of all the layers allocated with the first one
+	int	maxLevel = (mipmapMode == MIPMAP_NONE) ? 0 : int(log2(double(max(w, h))));
+	if (layer == 0)
+	{
+		for (int l = 0, lw = w, lh = h; l <= maxLevel; l++, lw = max(lw / 2, 1), lh = max(lh / 2, 1))
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, l, GL_RGBA8, lw, lh, numLayers, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, 0);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, maxLevel);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER,
+			maxLevel > 0 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, w, h, 1, format, GL_UNSIGNED_BYTE, texel);
+	isOK("glTexSubImage3D()", __FILE__, __LINE__);
+
+	if (mipmapMode == MIPMAP_CPU)
+	{
+		static vector<MipLevel>	levels;		// Reused by the loads
+		int	numLevels = buildMipChain(texel, w, h, numChannels(format), mipmapFilter, srgb, wrap, levels);
+
+		for (int i = 0; i < min(numLevels, maxLevel); i++)
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, i + 1, 0, 0, layer, levels[i].w, levels[i].h, 1,
+				format, GL_UNSIGNED_BYTE, &levels[i].texel[0]);
+		isOK("glTexSubImage3D()", __FILE__, __LINE__);
+	}
+	else if (mipmapMode == MIPMAP_GL && layer == numLayers - 1)
+	{
+		glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+	}
+}
+
+//
+// Loaders
+//
+static bool
+openRawTexture(const char* filename, size_t size, MappedFile& file)
+{
+	if (!mapFile(filename, file))
+	{
+		cout << "Can't open " << filename << endl;
+		return false;
+	}
+
+	if (file.size < size)
+	{
+		cout << "Error: only " << file.size << " bytes could be read from " << filename << "!" << endl;
+		unmapFile(file);
+		return false;
+	}
+
+	return true;
+}
+
+static void
+setTextureParameters(GLint wrap, GLenum target)
+{
+	glTexParameteri(target, GL_TEXTURE_WRAP_S, wrap);
+	glTexParameteri(target, GL_TEXTURE_WRAP_T, wrap);
+
+	// The minification filter is set with the mipmaps
+	glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
+static void
+reportLoad(const char* filename, const char* method, size_t bytes, double start, int allocations)
+{
+	double	t = glfwGetTime() - start;
+
+	cout << "Texture: " << filename << " " << method << " in " << t * 1000.0 << " ms, "
+		<< (t > 0 ? bytes / t / (1024.0 * 1024.0) : 0) << " MB/s, "
+		<< allocations << " allocation(s)" << endl;
+}
+
+// Wrap of the layer of a raw texture. The array wraps if any of the layers does.
+static void
+setLayerParameters(int layer, bool wrap)
+{
+	if (layer == 0 || wrap) setTextureParameters(wrap ? GL_REPEAT : GL_CLAMP_TO_EDGE, GL_TEXTURE_2D_ARRAY);
+}
+
+// RGB texture
+bool
+loadRawTexture(const char* filename, int w, int h, int n, bool srgb, int layer, int numLayers)
+{
+	// Only 3 and 1
+	if (n != 1 && n != 3)
+	{
+		cout << "Texture images with Two channels are not supported!" << endl;
+		return false;
+	}
+
+	double	start = glfwGetTime();
+	int		allocations = stagingAllocations();
+
+	MappedFile	file;
+	if (!openRawTexture(filename, size_t(w) * h * n, file)) return false;
+
+	setLayerParameters(layer, true);
+
+	if (n == 3)
+	{
+		// Straight from the mapping
+		uploadTextureLayer(w, h, layer, numLayers, GL_RGB, file.data, srgb, true);
+	}
+	else
+	{
+		GLubyte*	raw = stagingArena(size_t(w) * h * 3);
+		packGrayToRGB(file.data, raw, w * h);
+
+		uploadTextureLayer(w, h, layer, numLayers, GL_RGB, raw, srgb, true);
+	}
+
+	reportLoad(filename, n == 3 ? "mapped" : "gray to RGB", file.size, start,
+		stagingAllocations() - allocations);
+
+	unmapFile(file);
+
+	return true;
+}
+
+// Alpha texture
+bool
+loadAlphaTexture(const char* filename, int w, int h, int layer, int numLayers)
+{
+	double	start = glfwGetTime();
+	int		allocations = stagingAllocations();
+
+	MappedFile	file;
+	if (!openRawTexture(filename, size_t(w) * h, file)) return false;
+
+	GLubyte*	raw = stagingArena(size_t(w) * h * 4);
+	packAlphaToRGBA(file.data, raw, w * h);
+
+	setLayerParameters(layer, false);
+	uploadTextureLayer(w, h, layer, numLayers, GL_RGBA, raw, false, false);
+
+	reportLoad(filename, "alpha to RGBA", file.size, start, stagingAllocations() - allocations);
+
+	unmapFile(file);
+
+	return true;
+}
+
+// Color texture with the alpha from another file
+bool
+loadColorAlphaTexture(const char* filenameC, const char* filenameA, int w, int h, int layer, int numLayers)
+{
+	double	start = glfwGetTime();
+	int		allocations = stagingAllocations();
+
+	MappedFile	fileC, fileA;
+	if (!openRawTexture(filenameC, size_t(w) * h * 3, fileC)) return false;
+	if (!openRawTexture(filenameA, size_t(w) * h, fileA))
+	{
+		unmapFile(fileC);
+		return false;
+	}
+
+	GLubyte*	raw = stagingArena(size_t(w) * h * 4);
+	packRGBAlphaToRGBA(fileC.data, fileA.data, raw, w * h);
+
+	setLayerParameters(layer, false);
+	uploadTextureLayer(w, h, layer, numLayers, GL_RGBA, raw, true, false);
+
+	reportLoad(filenameC, "RGB + alpha to RGBA", fileC.size + fileA.size, start,
+		stagingAllocations() - allocations);
+
+	unmapFile(fileC);
+	unmapFile(fileA);
+
+	return true;
+}
+
+// Formats of the containers by the # of channels
+static const GLenum	internalFormatOf[5] = { 0, GL_R8, 0, GL_RGB8, GL_RGBA8 };
+static const GLenum	formatOf[5] = { 0, GL_RED, 0, GL_RGB, GL_RGBA };
+
+// Single channel read as the alpha with RGB = 0
+static void
+setAlphaSwizzle(GLenum target)
+{
+	GLint	swizzle[4] = { GL_ZERO, GL_ZERO, GL_ZERO, GL_RED };
+	glTexParameteriv(target, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+}
+
+// Layers of the same size, # of levels and alpha flag from the mapped containers
+bool
+uploadTextureArray(const MappedFile file[], const char* filename[], int numLayers, int firstLevel)
+{
+	vector<const TextureHeader*>	header(numLayers);
+	for (int i = 0; i < numLayers; i++)
+	{
+		header[i] = textureHeader(file[i].data, file[i].size);
+		if (header[i] == NULL)
+		{
+			cout << "Error: " << filename[i] << " is not a valid texture file!" << endl;
+			return false;
+		}
+
+		if (header[i]->width != header[0]->width || header[i]->height != header[0]->height
+			|| header[i]->numLevels != header[0]->numLevels
+			|| (header[i]->flags & TEXTURE_ALPHA) != (header[0]->flags & TEXTURE_ALPHA))
+		{
+			cout << "Error: " << filename[i] << " differs from " << filename[0]
+				<< " in the size, the mip levels or the alpha!" << endl;
+			return false;
+		}
+	}
+
+	// Widest format of the layers, RGB layers into RGBA with the alpha 1
+	int		channels = 0;
+	bool	wrap = false;
+	for (int i = 0; i < numLayers; i++)
+	{
+		channels = max(channels, int(header[i]->channels));
+		wrap = wrap || (header[i]->flags & TEXTURE_WRAP) != 0;
+	}
+
+	setTextureParameters(wrap ? GL_REPEAT : GL_CLAMP_TO_EDGE, GL_TEXTURE_2D_ARRAY);
+	if (header[0]->flags & TEXTURE_ALPHA) setAlphaSwizzle(GL_TEXTURE_2D_ARRAY);
+
+	firstLevel = min(max(firstLevel, 0), int(header[0]->numLevels) - 1);
+
+	// The level 0 of the first layer, once per file rather than on every reload of the residency
+	static set<string>	benchmarked;
+	if (mipmapBenchmark && firstLevel == 0 && benchmarked.insert(filename[0]).second)
+	{
+		const TextureHeader*	h = header[0];
+		benchmarkMipmaps(internalFormatOf[h->channels], formatOf[h->channels], h->width, h->height,
+			file[0].data + h->level[0].offset, (h->flags & TEXTURE_WRAP) != 0);
+	}
+	int	numLevels = (mipmapMode == MIPMAP_NONE) ? 1 : int(header[0]->numLevels) - firstLevel;
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (int l = 0; l < numLevels; l++)
+	{
+		const TextureLevel&	level = header[0]->level[firstLevel + l];
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, l, internalFormatOf[channels], level.w, level.h, numLayers, 0,
+			formatOf[channels], GL_UNSIGNED_BYTE, NULL);
+
+		for (int i = 0; i < numLayers; i++)
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, l, 0, 0, i, level.w, level.h, 1, formatOf[header[i]->channels],
+				GL_UNSIGNED_BYTE, file[i].data + header[i]->level[firstLevel + l].offset);
+	}
+	isOK("glTexSubImage3D()", __FILE__, __LINE__);
+
+	// Files without the mip levels
+	int	maxLevel = numLevels - 1;
+	if (numLevels == 1 && mipmapMode == MIPMAP_GL)
+	{
+		const TextureLevel&	level = header[0]->level[firstLevel];
+
+		glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+		maxLevel = int(log2(double(max(level.w, level.h))));
+	}
+
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, maxLevel);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER,
+		maxLevel > 0 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+
+	return true;
+}
+
+// Containers of the same size and # of levels as the layers of one texture
+bool
+loadTextureArray(const char* filename[], int numLayers)
+{
+	double	start = glfwGetTime();
+
+	vector<MappedFile>	file(numLayers);
+
+	bool	valid = true;
+	size_t	bytes = 0;
+	for (int i = 0; i < numLayers && valid; i++)
+	{
+		valid = mapFile(filename[i], file[i]);
+		if (!valid) cout << "Can't open " << filename[i] << endl;
+		bytes += file[i].size;
+	}
+
+	if (valid) valid = uploadTextureArray(&file[0], filename, numLayers);
+	if (valid)
+	{
+		cout << "Texture: " << numLayers << " layer(s)" << endl;
+		reportLoad(filename[0], "array", bytes, start, 0);
+	}
+
+	for (int i = 0; i < numLayers; i++) unmapFile(file[i]);
+
+	return valid;
+}
+
+//
+// Binding
+//
+static const int	MAX_TEXTURE_UNITS = 32;
+static GLuint	boundTexture[MAX_TEXTURE_UNITS] = { 0 };
+static int		numBinds = 0;
+
+void
+bindTexture(GLenum unit, GLenum target, GLuint texture)
+{
+	int	i = int(unit - GL_TEXTURE0);
+	if (i >= 0 && i < MAX_TEXTURE_UNITS && boundTexture[i] == texture) return;
+
+	glActiveTexture(unit);
+	glBindTexture(target, texture);
+	numBinds++;
+
+	if (i >= 0 && i < MAX_TEXTURE_UNITS) boundTexture[i] = texture;
+}
+
+void
+deleteTexture(GLuint texture)
+{
+	// The name may be reused by glGenTextures()
+	for (int i = 0; i < MAX_TEXTURE_UNITS; i++)
+		if (boundTexture[i] == texture) boundTexture[i] = 0;
+
+	glDeleteTextures(1, &texture);
+}
+
+int
+textureBinds()
+{
+	return numBinds;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#ifndef __GL_TEXTURE_H_
+#define __GL_TEXTURE_H_
+
+#include <GL/glew.h>				// OpenGL Extension Wrangler Libary
+#include <GLFW/glfw3.h>
+
+#include <stddef.h>
+
+#include "mipmap.h"
+
+// Texture ingest from memory-mapped .raw files
+//
+// The files are mapped read-only instead of being read into new[] buffers. An RGB file is
+// uploaded straight from the mapping, and the other layouts are packed into one staging
+// arena that grows geometrically and is reused by all the loads. The channel packing uses
+// SSSE3 shuffles, VEX-encoded when compiled for AVX, with a scalar fallback.
+//
+// Every load reports its time, throughput of the file bytes and # of heap allocations.
+//
+// The loaders upload into the layers of the texture bound to GL_TEXTURE_2D_ARRAY, as RGBA
+// like the drivers store RGB, and build the mip chains, on the CPU by default with a choice
+// of filters. The preprocessed containers of textureFile.h carry the mip chains and need no
+// packing; p03 loads the .raw sources with --raw instead of them.
+
+// Read-only mapping of a whole file
+struct MappedFile
+{
+	const GLubyte*	data;
+	size_t			size;
+
+#ifdef _WIN32
+	void*	file;		// HANDLE
+	void*	mapping;	// HANDLE
+#else
+	int		fd;
+#endif
+
+	MappedFile();
+};
+
+bool	mapFile(const char* filename, MappedFile& file);
+void	unmapFile(MappedFile& file);
+
+// Reusable 32-byte aligned staging memory, valid until the next call
+GLubyte*	stagingArena(size_t size);
+void		freeStagingArena();
+int			stagingAllocations();	// # of allocations of the arena so far
+
+// Channel packing of n texels
+void	packGrayToRGB(const GLubyte* gray, GLubyte* rgb, int n);
+void	packAlphaToRGBA(const GLubyte* alpha, GLubyte* rgba, int n);	// RGB = 0
+void	packRGBAlphaToRGBA(const GLubyte* rgb, const GLubyte* alpha, GLubyte* rgba, int n);
+
+// Mipmaps of the textures uploaded afterwards
+enum MipmapMode
+{
+	MIPMAP_NONE = 0,	// GL_LINEAR minification of the level 0 only
+	MIPMAP_GL,			// glGenerateMipmap()
+	MIPMAP_CPU,			// buildMipChain() with mipmapFilter
+};
+
+extern MipmapMode	mipmapMode;			// MIPMAP_CPU by default
+extern MipFilter	mipmapFilter;		// MIP_KAISER by default
+extern bool			mipmapBenchmark;	// Time all the filters against glGenerateMipmap()
+
+// Level 0 and the mip chain of the layer of numLayers of the same size into the texture
+// bound to GL_TEXTURE_2D_ARRAY, the layer 0 allocating all of them. format is GL_RED, GL_RGB
+// or GL_RGBA, srgb for the gamma-correct downsampling of the colors and wrap for the
+// textures of GL_REPEAT. glGenerateMipmap() runs after the last layer with MIPMAP_GL.
+void	uploadTextureLayer(int w, int h, int layer, int numLayers, GLenum format, const GLubyte* texel,
+	bool srgb, bool wrap);
+
+// Loaders into the layer of the texture bound to GL_TEXTURE_2D_ARRAY of the active texture
+// unit, in the order of the layers
+bool	loadRawTexture(const char* filename, int w, int h, int n, bool srgb = true,	// n = 1 or 3
+	int layer = 0, int numLayers = 1);
+bool	loadAlphaTexture(const char* filename, int w, int h, int layer = 0, int numLayers = 1);
+bool	loadColorAlphaTexture(const char* filenameC, const char* filenameA, int w, int h,
+	int layer = 0, int numLayers = 1);
+
+// Containers of the same size, # of levels and alpha flag into the layers of the texture
+// bound to GL_TEXTURE_2D_ARRAY, in the widest format of them. RGB layers in an RGBA array
+// read the alpha 1. The array wraps if any of the layers does.
+bool	loadTextureArray(const char* filename[], int numLayers);
+
+// Same from the containers mapped already, with the level firstLevel of the files as the
+// level 0 of the texture to drop the finer levels
+bool	uploadTextureArray(const MappedFile file[], const char* filename[], int numLayers,
+	int firstLevel = 0);
+
+// glActiveTexture() and glBindTexture() unless the texture is already bound to the unit by
+// bindTexture()
+void	bindTexture(GLenum unit, GLenum target, GLuint texture);
+void	deleteTexture(GLuint texture);	// glDeleteTextures() forgetting its binds
+int		textureBinds();		// # of glBindTexture() calls through bindTexture() so far
+
+#endif	// __GL_TEXTURE_H_
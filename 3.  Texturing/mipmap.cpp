@@ -0,0 +1,318 @@
+#include "mipmap.h"
+
+#ifdef _WIN32
+#define _USE_MATH_DEFINES
+#endif
+
+#include <math.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+using namespace std;
+
+const char*	mipFilterName[NUM_MIP_FILTERS] = { "box", "Kaiser", "Lanczos" };
+
+//
+// Thread pool
+//
+static mutex				poolMutex;
+static condition_variable	poolWake, poolDone;
+static vector<thread>		poolWorkers;
+
+static const function<void(int)>*	poolJob = NULL;
+static atomic<int>	poolNext(0);
+static int	poolTasks = 0;
+static int	poolBusy = 0;			// # of workers in the current job
+static int	poolGeneration = 0;		// Incremented for every job
+static bool	poolQuit = false;
+
+static void
+runPoolTasks()
+{
+	for (int i; (i = poolNext++) < poolTasks; ) (*poolJob)(i);
+}
+
+static void
+poolWorker()
+{
+	int	generation = 0;
+
+	unique_lock<mutex>	lock(poolMutex);
+	for (;;)
+	{
+		poolWake.wait(lock, [&] { return poolQuit || poolGeneration != generation; });
+		if (poolQuit) return;
+
+		generation = poolGeneration;
+		poolBusy++;
+
+		lock.unlock();
+		runPoolTasks();
+		lock.lock();
+
+		if (--poolBusy == 0) poolDone.notify_all();
+	}
+}
+
+// Joins the workers before the statics are destroyed
+static struct PoolShutdown
+{
+	~PoolShutdown()
+	{
+		{
+			lock_guard<mutex>	lock(poolMutex);
+			poolQuit = true;
+		}
+		poolWake.notify_all();
+
+		for (size_t i = 0; i < poolWorkers.size(); i++) poolWorkers[i].join();
+	}
+} poolShutdown;
+
+int
+mipmapThreads()
+{
+	return int(poolWorkers.size()) + 1;
+}
+
+// f(0), ..., f(n - 1) on the pool and the calling thread
+static void
+parallelFor(int n, const function<void(int)>& f)
+{
+	if (poolWorkers.empty())
+	{
+		int	numWorkers = max(int(thread::hardware_concurrency()) - 1, 0);
+		for (int i = 0; i < numWorkers; i++) poolWorkers.push_back(thread(poolWorker));
+	}
+
+	{
+		lock_guard<mutex>	lock(poolMutex);
+		poolJob = &f;
+		poolTasks = n;
+		poolNext = 0;
+		poolGeneration++;
+	}
+	poolWake.notify_all();
+
+	runPoolTasks();
+
+	unique_lock<mutex>	lock(poolMutex);
+	poolDone.wait(lock, [] { return poolBusy == 0; });
+}
+
+//
+// Filters
+//
+static const int	BAND_ROWS = 16;		// Rows of a task
+static const int	NUM_TAPS = 12;		// Source texels of a 2:1 decimation with 3 lobes
+static const int	FIRST_TAP = -5;		// Offset of the first tap from 2 x
+
+static double
+sinc(double x)
+{
+	if (fabs(x) < 1.0e-8) return 1;
+
+	x *= M_PI;
+	return sin(x) / x;
+}
+
+// Modified Bessel function of the first kind of order 0
+static double
+besselI0(double x)
+{
+	double	sum = 1, term = 1;
+	for (int k = 1; k < 25; k++)
+	{
+		term *= (x / (2 * k)) * (x / (2 * k));
+		sum += term;
+	}
+
+	return sum;
+}
+
+// d in the texels of the destination level
+static double
+kernel(MipFilter filter, double d)
+{
+	const double	support = 3, alpha = 4;
+
+	switch (filter)
+	{
+	case MIP_BOX:		return fabs(d) <= 0.5 ? 1 : 0;
+	case MIP_KAISER:	return fabs(d) < support ?
+		sinc(d) * besselI0(alpha * sqrt(1 - (d / support) * (d / support))) / besselI0(alpha) : 0;
+	case MIP_LANCZOS:	return fabs(d) < support ? sinc(d) * sinc(d / support) : 0;
+	default:			return 0;
+	}
+}
+
+// Normalized weights of the source texels 2x + FIRST_TAP, ..., 2x + FIRST_TAP + NUM_TAPS - 1
+static void
+decimationWeights(MipFilter filter, float weight[NUM_TAPS])
+{
+	double	sum = 0;
+	for (int k = 0; k < NUM_TAPS; k++)
+	{
+		// Center of the destination texel x at the source coordinate 2x + 1
+		double	d = (FIRST_TAP + k + 0.5 - 1) / 2.0;
+		weight[k] = float(kernel(filter, d));
+		sum += weight[k];
+	}
+
+	for (int k = 0; k < NUM_TAPS; k++) weight[k] = float(weight[k] / sum);
+}
+
+static inline int
+sourceIndex(int i, int n, bool wrap)
+{
+	if (wrap) return ((i % n) + n) % n;
+
+	return min(max(i, 0), n - 1);
+}
+
+//
+// sRGB transfer functions
+//
+static float	srgbToLinear[256];
+static unsigned char	linearToSRGB[4096];	// Indexed by linear x 4095
+
+static void
+initializeTransferTables()
+{
+	static bool	initialized = false;
+	if (initialized) return;
+
+	for (int i = 0; i < 256; i++)
+	{
+		double	c = i / 255.0;
+		srgbToLinear[i] = float(c <= 0.04045 ? c / 12.92 : pow((c + 0.055) / 1.055, 2.4));
+	}
+
+	for (int i = 0; i < 4096; i++)
+	{
+		double	l = i / 4095.0;
+		double	c = l <= 0.0031308 ? 12.92 * l : 1.055 * pow(l, 1 / 2.4) - 0.055;
+		linearToSRGB[i] = (unsigned char)(c * 255.0 + 0.5);
+	}
+
+	initialized = true;
+}
+
+static inline unsigned char
+quantize(float x, bool srgb)
+{
+	x = min(max(x, 0.0f), 1.0f);
+
+	return srgb ? linearToSRGB[int(x * 4095.0f + 0.5f)] : (unsigned char)(x * 255.0f + 0.5f);
+}
+
+int
+buildMipChain(const unsigned char* texel, int w, int h, int channels,
+	MipFilter filter, bool srgb, bool wrap, vector<MipLevel>& levels)
+{
+	initializeTransferTables();
+
+	float	weight[NUM_TAPS];
+	decimationWeights(filter, weight);
+
+	// Taps with nonzero weights, 2 for the box filter
+	int		firstTap = 0, lastTap = NUM_TAPS - 1;
+	while (weight[firstTap] == 0) firstTap++;
+	while (weight[lastTap] == 0) lastTap--;
+
+	// Channels in linear space
+	bool	linear[4];
+	for (int c = 0; c < 4; c++) linear[c] = !srgb || c == 3;
+
+	// Level 0 in floating point
+	vector<float>	src(size_t(w) * h * channels), tmp, dst;
+	vector<int>		tap;
+	parallelFor((h + BAND_ROWS - 1) / BAND_ROWS, [&](int band)
+	{
+		size_t	begin = size_t(band) * BAND_ROWS * w * channels;
+		size_t	end = min(size_t(band + 1) * BAND_ROWS, size_t(h)) * w * channels;
+		for (size_t i = begin; i < end; i++)
+			src[i] = linear[i % channels] ? texel[i] / 255.0f : srgbToLinear[texel[i]];
+	});
+
+	levels.clear();
+	while (w > 1 || h > 1)
+	{
+		int	dw = max(w / 2, 1), dh = max(h / 2, 1);
+
+		// Source texels of the taps, wrapped or clamped at the edges
+		tap.resize(size_t(dw) * NUM_TAPS);
+		for (int x = 0; x < dw; x++)
+			for (int k = firstTap; k <= lastTap; k++)
+				tap[x * NUM_TAPS + k] = sourceIndex(2 * x + FIRST_TAP + k, w, wrap) * channels;
+
+		// Horizontal pass into dw x h, unless a single column
+		tmp.resize(size_t(dw) * h * channels);
+		parallelFor((h + BAND_ROWS - 1) / BAND_ROWS, [&](int band)
+		{
+			for (int y = band * BAND_ROWS; y < min((band + 1) * BAND_ROWS, h); y++)
+			{
+				const float*	row = &src[size_t(y) * w * channels];
+				float*			out = &tmp[size_t(y) * dw * channels];
+
+				for (int x = 0; x < dw; x++)
+				{
+					for (int c = 0; c < channels; c++)
+					{
+						if (w == 1) { out[c] = row[c]; continue; }
+
+						float	sum = 0;
+						for (int k = firstTap; k <= lastTap; k++) sum += weight[k] * row[tap[x * NUM_TAPS + k] + c];
+						out[x * channels + c] = sum;
+					}
+				}
+			}
+		});
+
+		// Vertical pass into dw x dh, unless a single row
+		dst.resize(size_t(dw) * dh * channels);
+		parallelFor((dh + BAND_ROWS - 1) / BAND_ROWS, [&](int band)
+		{
+			size_t	stride = size_t(dw) * channels;
+
+			for (int y = band * BAND_ROWS; y < min((band + 1) * BAND_ROWS, dh); y++)
+			{
+				float*	out = &dst[y * stride];
+
+				if (h == 1)
+				{
+					copy(&tmp[0], &tmp[0] + stride, out);
+					continue;
+				}
+
+				fill(out, out + stride, 0.0f);
+				for (int k = firstTap; k <= lastTap; k++)
+				{
+					const float*	row = &tmp[sourceIndex(2 * y + FIRST_TAP + k, h, wrap) * stride];
+					for (size_t i = 0; i < stride; i++) out[i] += weight[k] * row[i];
+				}
+
+				// Negative lobes must not ring into the next levels
+				for (size_t i = 0; i < stride; i++) out[i] = min(max(out[i], 0.0f), 1.0f);
+			}
+		});
+
+		// Quantized level
+		levels.push_back(MipLevel());
+		MipLevel&	level = levels.back();
+		level.w = dw;
+		level.h = dh;
+		level.texel.resize(dst.size());
+		for (size_t i = 0; i < dst.size(); i++) level.texel[i] = quantize(dst[i], !linear[i % channels]);
+
+		src.swap(dst);
+		w = dw;
+		h = dh;
+	}
+
+	return int(levels.size());
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#ifndef __MIPMAP_H_
+#define __MIPMAP_H_
+
+#include <vector>
+
+// CPU mip-chain generation
+//
+// Every level is decimated by 2 from the previous one with a separable filter, in floating
+// point so that the rounding does not accumulate down the chain. The horizontal and the
+// vertical passes run on a thread pool over bands of rows. With srgb, the RGB channels are
+// filtered in linear space and encoded back, which keeps the brightness of the high-contrast
+// textures in the small levels. The alpha channel is always linear.
+//
+// No OpenGL calls here so that an offline tool can also build the chains.
+
+enum MipFilter
+{
+	MIP_BOX = 0,	// 2x2 average
+	MIP_KAISER,		// Kaiser-windowed sinc, 3 lobes and alpha 4
+	MIP_LANCZOS,	// Lanczos-3
+	NUM_MIP_FILTERS
+};
+
+extern const char*	mipFilterName[NUM_MIP_FILTERS];
+
+struct MipLevel
+{
+	int		w, h;
+	std::vector<unsigned char>	texel;	// w x h x channels
+};
+
+// Levels 1 to log2(max(w, h)) of an image of 1, 3 or 4 channels. wrap is for the textures of
+// GL_REPEAT, otherwise the edges are clamped. Returns the # of levels built.
+int		buildMipChain(const unsigned char* texel, int w, int h, int channels,
+	MipFilter filter, bool srgb, bool wrap, std::vector<MipLevel>& levels);
+
+int		mipmapThreads();	// # of threads including the caller
+
+#endif	// __MIPMAP_H_
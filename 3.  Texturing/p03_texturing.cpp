@@ -1,12 +1,21 @@
 
 #include "glSetup.h"
 #include "glShader.h"
+#include "glTexture.h"
+#include "textureManager.h"
+#include "tangent.h"
+#include "mesh.h"
 
 #include <Eigen/Dense>
 using namespace Eigen;
 
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <vector>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 using namespace std;
 
 #ifdef _WIN32
@@ -65,6 +74,7 @@ struct Program
 Program pgTexturing;	 // Program for simple Texturing
 Program pgDoubleVision;  // Program for double vision
 Program pgNormalMapping; // Program for normal mapping
+Program pgTangentMapping; // Program for normal mapping in the tangent frames of a mesh
 
 // Geometry
 struct Geometry
@@ -89,9 +99,41 @@ struct Geometry
 
 Geometry tri;	// VAO and VBO for a single triangle
 Geometry quad;  // VAO and VBO for a single quad
+Geometry bunny; // Interleaved VBO of a UV-mapped bunny with the tangent frames
 
-// Textrue
-GLuint texId[5];
+// Texture: an array of the 256 x 256 textures, and the demon head and the logo of their own sizes
+enum { TEX_SNOW, TEX_DEMON, TEX_LOGO, NUM_TEXTURES };
+TextureHandle texture[NUM_TEXTURES] = { -1, -1, -1 };
+
+// Textures of the .raw sources with --raw in place of the containers, 0 for the managed ones
+bool rawTextures = false;
+GLuint rawTexture[NUM_TEXTURES] = { 0, 0, 0 };
+
+// Texture to bind for the unit
+GLuint textureOf(int i)
+{
+	return rawTexture[i] ? rawTexture[i] : useTexture(texture[i]);
+}
+
+// Material table of the texture unit and the layer for every draw, without rebinding
+struct Material
+{
+	int	unit;	// GL_TEXTURE0 + unit bound to texture[unit]
+	int	layer;
+};
+
+enum { MAT_SNOW_COLOR, MAT_SNOW_NORMAL, MAT_SNOW_COLOR_ALPHA, MAT_DEMON, MAT_LOGO, NUM_MATERIALS };
+Material material[NUM_MATERIALS] =
+{
+	{ TEX_SNOW, 0 },	// m02_snow_color_map
+	{ TEX_SNOW, 1 },	// m02_snow_normal_map
+	{ TEX_SNOW, 2 },	// m02_snow_color_alpha_map
+	{ TEX_DEMON, 0 },
+	{ TEX_LOGO, 0 },
+};
+
+// Texture binds of the last frame
+int	frameBinds = -1;
 
 // (1) Simple texturing
 bool	simpleTexturing = false;
@@ -102,12 +144,6 @@ bool	alphaTexturing = false;
 // (3) Double vision
 bool doubleVision = true;
 
-// Texture
-static const GLubyte demonHeadImage[3 * (128 * 128)] =
-{
-  #include "m02_demon_image.h"
-};
-
 // Separation
 Vector2f leftSeparation(-0.1f, 0.0f);
 Vector2f rightSeparation(0.1f, 0.0f);
@@ -118,7 +154,13 @@ float scale = 1.0;
 
 // (5) Exercise
 bool exercise = false;
-bool loadColorAlphaTexture(const char* filenameC, const char* filenameA, int w, int h);
+
+// (6) Normal mapping of a mesh
+bool bunnyMapping = false;
+void renderNormalMappedBunny(const Vector3f& l);
+
+// Trilinear minification with the mipmaps
+bool mipmapping = true;
 void renderColorAlphaNormalMappedQuad(const Vector3f& l);
 
 
@@ -141,172 +183,154 @@ void reshapeModernOpenGL(GLFWwindow* window, int w, int h)
 	cerr << " with screen " << screenW << " x " << screenH << endl;
 }
 
-// Demon head texture
-void loadDemonHeadTexture()
+// Spherical texture coordinates about the centroid, repeated 4 x 2 times
+void sphericalTexcoords(const MatrixXf& vertex, MatrixXf& texcoord)
 {
-	// GL_CLAMP is not supported anymore!
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, 128, 128, 0, GL_RGB, GL_UNSIGNED_BYTE, demonHeadImage);
-
-	isOK("glTexImage2D()", __FILE__, __LINE__);
+	Vector3f c = vertex.rowwise().mean();
 
+	texcoord.resize(2, vertex.cols());
+	for (int i = 0; i < vertex.cols(); i++)
+	{
+		Vector3f p = vertex.col(i) - c;
+		texcoord(0, i) = 4 * float(atan2(p.z(), p.x()) / (2 * M_PI) + 0.5);
+		texcoord(1, i) = 2 * float(acos(max(min(p.y() / p.norm(), 1.0f), -1.0f)) / M_PI);
+	}
 }
 
-// RGB texture
-bool loadRawTexture(const char* filename, int w, int h, int n)
+// Tangents against the derivatives of the spherical mapping about c, away from its seam and poles
+void validateTangents(const char* name, const ArrayXXi& face, const MatrixXf& vertex, const MatrixXf& normal,
+	const MatrixXf& texcoord, const MatrixXf& tangent, const Vector3f& c)
 {
-	// Open the raw texture file
-	ifstream	is(filename, ios::binary);
-	if (is.fail())
+	// Vertices of the faces across the seam of u
+	vector<bool> seam(vertex.cols(), false);
+	for (int f = 0; f < face.cols(); f++)
 	{
-		cout << "Can't open " << filename << endl;
-		return false;
+		float u0 = texcoord(0, face(0, f)), u1 = texcoord(0, face(1, f)), u2 = texcoord(0, face(2, f));
+		if (max(max(u0, u1), u2) - min(min(u0, u1), u2) > 2)
+			for (int k = 0; k < 3; k++) seam[face(k, f)] = true;
 	}
 
-	// Allocate memory
-	GLubyte* raw = new GLubyte[w * h * 3];
-
-	// Only 3 and 1
-	if (n == 1)
-	{
-		// Read all the texels of the single channel
-		GLubyte* rawG = new GLubyte[w * h];
-		is.read((char*)rawG, w * h * n);
-
-		for (int i = 0; i < w * h; i++)
-			raw[3 * i + 0] = raw[3 * i + 1] = raw[3 * i + 2] = rawG[i]; // RGB
-
-		delete[] rawG;
-	}
-	else if (n == 3)
-	{
-		// Read all the texels of the rgb channels
-		is.read((char*)raw, w * h * n);
-	}
-	else
+	int numFlipped = 0;
+	double maxDot = 0, maxLength = 0;
+	vector<double> angles;
+	for (int i = 0; i < vertex.cols(); i++)
 	{
-		cout << "Texture images with Two channels are not supported!" << endl;
-		return false;
+		Vector3f n = normal.col(i);
+		Vector3f t = tangent.col(i).head<3>();
+		maxDot = max(maxDot, double(fabs(t.dot(n))));
+		maxLength = max(maxLength, double(fabs(t.norm() - 1)));
+
+		Vector3f p = vertex.col(i) - c;
+		float rho = Vector2f(p.x(), p.z()).norm();
+		if (seam[i] || rho < 0.05f * p.norm()) continue;
+
+		// Derivatives along the azimuth and the polar angle in the tangent plane
+		Vector3f du = Vector3f(-p.z(), 0, p.x()) / rho;
+		Vector3f dv = Vector3f(p.x() * p.y() / rho, -rho, p.z() * p.y() / rho);
+		du = (du - n * n.dot(du)).normalized();
+
+		angles.push_back(acos(min(max(double(t.dot(du)), -1.0), 1.0)) * 180 / M_PI);
+		if ((n.cross(t).dot(dv) < 0) != (tangent(3, i) < 0)) numFlipped++;
 	}
-	if (!is)		cout << "Error: only " << is.gcount() << "bytes could be read!" << endl;
+	if (angles.empty()) return;
+	sort(angles.begin(), angles.end());
 
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, w, h, 0, GL_RGB, GL_UNSIGNED_BYTE, raw);
-	isOK("glTexImage2D()", __FILE__, __LINE__);
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	// Deallocate memory
-	delete[]	raw;
-
-	return true;
+	cout << "Tangents of the " << name << ": max |T.N| = " << maxDot << ", max |1 - |T|| = " << maxLength
+		<< ", median " << angles[angles.size() / 2] << " and 99th percentile " << angles[angles.size() * 99 / 100]
+		<< " degrees from the analytic ones of " << angles.size() << " vertices, "
+		<< numFlipped << " with the wrong handedness" << endl;
 }
 
-// Alpha texture
-bool loadAlphaTexture(const char* filename, int w, int h)
+// UV-mapped bunny with the tangent frames
+void loadBunny()
 {
-	// Open the raw texture file
-	ifstream	is(filename, ios::binary);
-	if (is.fail())
-	{
-		cout << "Can't open " << filename << endl;
-		return false;
-	}
-
-	// Allocate memory
-	GLubyte* raw = new GLubyte[w * h * 4];	//RGBA
-	{
-		GLubyte* rawG = new GLubyte[w * h];
+	ArrayXXi face;
+	MatrixXf vertex, normal, texcoord, tangent, tangentMT;
+
+	readMesh("m01_bunny.off", vertex, normal, face);
+	sphericalTexcoords(vertex, texcoord);
+
+	// Single thread and all the cores, which must agree exactly
+	double start = glfwGetTime();
+	int numDegenerate = computeTangents(face, vertex, normal, texcoord, tangent, 1);
+	double single = glfwGetTime() - start;
+
+	start = glfwGetTime();
+	computeTangents(face, vertex, normal, texcoord, tangentMT);
+	double multi = glfwGetTime() - start;
+
+	cout << "Tangents: " << face.cols() << " faces, " << numDegenerate << " degenerate, "
+		<< single * 1000.0 << " ms on 1 thread, " << multi * 1000.0 << " ms on all the cores, "
+		<< ((tangent - tangentMT).cwiseAbs().maxCoeff() == 0 ? "identical" : "DIFFERENT") << endl;
+
+	// The same faces on the unit sphere, where the mapping is exact, and on the bunny, which
+	// distorts it
+	Vector3f c = vertex.rowwise().mean();
+	MatrixXf sphere = vertex.colwise() - c, sphereTangent;
+	sphere.colwise().normalize();
+	computeTangents(face, sphere, sphere, texcoord, sphereTangent);
+
+	validateTangents("sphere", face, sphere, sphere, texcoord, sphereTangent, Vector3f::Zero());
+	validateTangents("bunny", face, vertex, normal, texcoord, tangent, c);
+
+	createInterleavedVBO(bunny.vao, bunny.indexId, bunny.vertexId);
+	bunny.numTris = uploadMesh2InterleavedVBO(face, vertex, normal, texcoord, tangent,
+		bunny.vao, bunny.indexId, bunny.vertexId);
+}
 
-		// Read all the texels
-		is.read((char*)rawG, w * h);
-		if (!is)		cout << "Error: only" << is.gcount() << "bytes could be read!" << endl;
+// Budgets of the textures to cycle through, 0 for unlimited
+const size_t textureBudgets[] = { 0, 1024 * 1024, 256 * 1024 };
+int budgetIndex = 0;
 
-		for (int i = 0; i < w * h; i++)
+// --mipmap none, gl, box, kaiser or lanczos, --mipmap-benchmark, --texture-budget KB and --raw.
+// The filters of the CPU mip chains apply to the .raw sources, as the containers carry theirs.
+void parseTextureOptions(int argc, char* argv[])
+{
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--mipmap-benchmark") == 0) mipmapBenchmark = true;
+		else if (strcmp(argv[i], "--raw") == 0) rawTextures = true;
+		else if (strcmp(argv[i], "--texture-budget") == 0 && i + 1 < argc)
+			setTextureBudget(size_t(atoi(argv[++i])) * 1024);
+		else if (strcmp(argv[i], "--mipmap") == 0 && i + 1 < argc)
 		{
-			raw[4 * i + 0] = 0;			// R
-			raw[4 * i + 1] = 0;			// G
-			raw[4 * i + 2] = 0;			// B
-			raw[4 * i + 3] = rawG[i];	// A
+			const char* mode = argv[++i];
+			if (strcmp(mode, "none") == 0)			mipmapMode = MIPMAP_NONE;
+			else if (strcmp(mode, "gl") == 0)		mipmapMode = MIPMAP_GL;
+			else if (strcmp(mode, "box") == 0)		mipmapFilter = MIP_BOX;
+			else if (strcmp(mode, "kaiser") == 0)	mipmapFilter = MIP_KAISER;
+			else if (strcmp(mode, "lanczos") == 0)	mipmapFilter = MIP_LANCZOS;
+			else cerr << "Unknown --mipmap " << mode << endl;
 		}
-		delete[] rawG;
 	}
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, raw);
-
-	// Deallocate memory
-	delete[] raw;
-
-	return true;
 }
 
-bool loadColorAlphaTexture(const char* filenameC, const char* filenameA, int w, int h)
+// Trilinear or bilinear minification of all the textures to compare the aliasing
+void setMinificationFilter()
 {
-	// Open the raw texture file (color)
-	ifstream	isC(filenameC, ios::binary);
-	if (isC.fail())
-	{
-		cout << "Can't open " << filenameC << endl;
-		return false;
-	}
-
-	// Open the raw texture file (alpha)
-	ifstream	isA(filenameA, ios::binary);
-	if (isA.fail())
+	for (int i = 0; i < NUM_TEXTURES; i++)
 	{
-		cout << "Can't open " << filenameA << endl;
-		return false;
+		bindTexture(GL_TEXTURE0 + i, GL_TEXTURE_2D_ARRAY, textureOf(i));
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER,
+			mipmapping && mipmapMode != MIPMAP_NONE ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
 	}
 
-	// Allocate memory for Color & Alpha
-	GLubyte* raw = new GLubyte[w * h * 4];	//RGBA
-	{
-		// Allocate memory for color
-		GLubyte* rawC = new GLubyte[w * h * 3];
-		// Read all the texels of the rgb channels
-		isC.read((char*)rawC, w * h * 3);
-
-		// Alpha д´.
-		GLubyte* rawA = new GLubyte[w * h];
-		// Read all the texels
-		isA.read((char*)rawA, w * h);
-		if (!isA)		cout << "Error: only" << isA.gcount() << "bytes could be read!" << endl;
-
-		for (int i = 0; i < w * h; i++)
-		{
-			raw[4 * i + 0] = rawC[3*i+0];		// R
-			raw[4 * i + 1] = rawC[3 * i + 1];	// G
-			raw[4 * i + 2] = rawC[3 * i + 2];	// B
-			raw[4 * i + 3] = rawA[i];			// A
-		}
-		delete[] rawA;
-		delete[] rawC;
-	}
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, raw);
-
-	// Deallocate memory
-	delete[]	raw;
+	cout << "Mipmapping " << (mipmapping ? "on" : "off") << endl;
+}
 
-	return true;
+// Snow maps and the logo from the .raw sources through the raw loaders, with the mip chains
+// of mipmapFilter. The demon head has no .raw source and stays in its container.
+void loadRawTextures()
+{
+	glGenTextures(1, &rawTexture[TEX_SNOW]);
+	bindTexture(GL_TEXTURE0 + TEX_SNOW, GL_TEXTURE_2D_ARRAY, rawTexture[TEX_SNOW]);
+	loadRawTexture("m02_snow_color_map.raw", 256, 256, 3, true, 0, 3);
+	loadRawTexture("m02_snow_normal_map.raw", 256, 256, 3, false, 1, 3);	// Not a color
+	loadColorAlphaTexture("m02_snow_color_map.raw", "m02_snow_alpha_map.raw", 256, 256, 2, 3);
+
+	glGenTextures(1, &rawTexture[TEX_LOGO]);
+	bindTexture(GL_TEXTURE0 + TEX_LOGO, GL_TEXTURE_2D_ARRAY, rawTexture[TEX_LOGO]);
+	loadAlphaTexture("m02_logo.raw", 512, 512);
 }
 
 int main(int argc, char* argv[])
@@ -326,74 +350,22 @@ int main(int argc, char* argv[])
 	// Depth test
 	glEnable(GL_DEPTH_TEST);
 
-	// Texture
-	glGenTextures(5, texId);
-
-	// GL_TEXTURE0 for a color texture
-	{
-		// Specify the activate texture uint
-		glActiveTexture(GL_TEXTURE0 + 0);
-		isOK("glActiveTexture()", __FILE__, __LINE__);
-
-		// Bind the texture
-		glBindTexture(GL_TEXTURE_2D, texId[0]);
-		isOK("glBindTexture()", __FILE__, __LINE__);
-
-		// Raw texture
-		loadRawTexture("m02_snow_color_map.raw", 256, 256, 3);
-	}
-
-	// GL_TEXTURE1 for the demon head texture
-	{
-		// Specify the activate texture uint
-		glActiveTexture(GL_TEXTURE0 + 1);
-		isOK("glActiveTexture()", __FILE__, __LINE__);
-
-		// Bind the texture
-		glBindTexture(GL_TEXTURE_2D, texId[1]);
-		isOK("glBindTexture()", __FILE__, __LINE__);
-
-		// Demon head texture
-		loadDemonHeadTexture();
-	}
-
-	// GL_TEXTURE2 for an alpha texture
-	{
-		// Specify the activate texture unit
-		glActiveTexture(GL_TEXTURE0 + 2);
-		isOK("glActiveTexture()", __FILE__, __LINE__);
-
-		// Bind the texture
-		glBindTexture(GL_TEXTURE_2D, texId[2]);
-		isOK("glBindTexture()", __FILE__, __LINE__);
+	// Mipmap and texture options
+	parseTextureOptions(argc, argv);
 
-		loadAlphaTexture("m02_logo.raw", 512, 512);
-	}
-
-	// GL_TEXTURE3 for a normal mapp
-	{
-		// Specify the activate texture unit
-		glActiveTexture(GL_TEXTURE0 + 3);
-		isOK("glActiveTexture()", __FILE__, __LINE__);
-
-		// Bind the texture
-		glBindTexture(GL_TEXTURE_2D, texId[3]);
-		isOK("glBindTexture()", __FILE__, __LINE__);
-
-		loadRawTexture("m02_snow_normal_map.raw", 256, 256, 3);
-	}
-
-	// GL_TEXTURE4 for color-alpha mapp used in Execrise
+	// Texture
 	{
-		// Specify the activate texture unit
-		glActiveTexture(GL_TEXTURE0 + 4);
-		isOK("glActiveTexture()", __FILE__, __LINE__);
-
-		// Bind the texture
-		glBindTexture(GL_TEXTURE_2D, texId[4]);
-		isOK("glBindTexture()", __FILE__, __LINE__);
+		// Color, normal and color-alpha maps of the same size in the order of the material table
+		const char* snow[3] = { "m02_snow_color_map.tex", "m02_snow_normal_map.tex", "m02_snow_color_alpha_map.tex" };
 
-		loadColorAlphaTexture("m02_snow_color_map.raw","m02_snow_alpha_map.raw", 256, 256);
+		// Demon head and alpha textures
+		texture[TEX_DEMON] = acquireTexture("m02_demon_image.tex");
+		if (rawTextures) loadRawTextures();
+		else
+		{
+			texture[TEX_SNOW] = acquireTexture(snow, 3);
+			texture[TEX_LOGO] = acquireTexture("m02_logo.tex");
+		}
 	}
 
 	// Initialization
@@ -402,6 +374,10 @@ int main(int argc, char* argv[])
 		pgTexturing.create("sv03_texturing.glsl", "sf03_texturing.glsl");
 		pgDoubleVision.create("sv03_double_vision.glsl", "sf03_double_vision.glsl");
 		pgNormalMapping.create("sv03_texturing.glsl", "sf03_normal.glsl");
+		pgTangentMapping.create("sv03_normal_tangent.glsl", "sf03_normal_tangent.glsl");
+
+		// Bunny for the normal mapping in the tangent frames
+		loadBunny();
 
 		// Prepare a single quad
 		ArrayXXi face;
@@ -476,15 +452,20 @@ int main(int argc, char* argv[])
 	cout << "Keyboard Input : a for alpha texturing" << endl;
 	cout << "Keyboard Input : d for double vision" << endl;
 	cout << "Keyboard Input : n for normal mapping" << endl;
+	cout << "Keyboard Input : u for normal mapping of a UV-mapped bunny" << endl;
 	cout << endl;
 	cout << "Keyboard Input : r for rotation on/off" << endl;
 	cout << "Keyboard Input : i for resetting the rotation angle" << endl;
+	cout << "Keyboard Input : m for mipmapping on/off" << endl;
+	cout << "Keyboard Input : b for the texture budget of none, 1 MB or 256 KB" << endl;
+	cout << "Keyboard Input : t for the texture residency" << endl;
 
 	// Main loop
 	float previous = (float)glfwGetTime();
 	float elapsed = 0;
 	while (!glfwWindowShouldClose(window))
 	{
+		beginTiming(TIMING_UPDATE);
 		glfwPollEvents(); // Events
 
 		// Time passed during a single loop
@@ -494,7 +475,9 @@ int main(int argc, char* argv[])
 
 		// Time passed after the previous frame
 		elapsed += delta;
+		endTiming(TIMING_UPDATE);
 
+		beginTiming(TIMING_SIMULATE);
 		// Dleta with the current frame
 		if (elapsed > timeStep)
 		{
@@ -515,22 +498,31 @@ int main(int argc, char* argv[])
 
 			elapsed = 0; // Reset the elapsed time
 		}
+		endTiming(TIMING_SIMULATE);
 
+		beginTiming(TIMING_RENDER);
 		render(window);		// Draw one frame
-		glfwSwapBuffers(window);	// Swap buffers
+		endTiming(TIMING_RENDER);
+		swapBuffers(window);	// Swap buffers
 	}
 
 	// Finalization
 	{
 		// Texture
-		glDeleteTextures(5, texId); // exercise  texture 5 ÷Ƚϴ.
+		printTextureStatistics();
+		for (int i = 0; i < NUM_TEXTURES; i++) releaseTexture(texture[i]);
+		for (int i = 0; i < NUM_TEXTURES; i++) if (rawTexture[i]) deleteTexture(rawTexture[i]);
+		shutdownTextures();
+		freeStagingArena();
 
 		// Delete VBO and shaders
 		deleteVBO(tri.vao, tri.indexId, tri.vertexId, tri.normalId, tri.coordId);
 		deleteVBO(quad.vao, quad.indexId, quad.vertexId, quad.normalId, quad.coordId);
+		deleteVBO(bunny.vao, bunny.indexId, bunny.vertexId, bunny.normalId);
 		pgTexturing.destroy();
 		pgDoubleVision.destroy();
 		pgNormalMapping.destroy();
+		pgTangentMapping.destroy();
 	}
 
 	// Terminate the glfw system
@@ -555,8 +547,19 @@ void setUniformMVP(GLuint program, Matrix4f& M, Matrix4f& V, Matrix4f& P)
 	setUniform(program, "ModelViewProjectionMatrix", ModelViewProjectionMatrix);
 }
 
+// Sampler and its layer for the material, binding the texture only if not bound yet
+void setMaterial(GLuint program, const char* sampler, const char* layer, const Material& m)
+{
+	bindTexture(GL_TEXTURE0 + m.unit, GL_TEXTURE_2D_ARRAY, textureOf(m.unit));
+
+	setUniformi(program, sampler, m.unit);
+	setUniformi(program, layer, m.layer);
+}
+
 void render(GLFWwindow* window)
 {
+	int binds = textureBinds();
+
 	// Antialiasing
 	if (aaEnabled) glEnable(GL_MULTISAMPLE);
 	else           glDisable(GL_MULTISAMPLE);
@@ -582,7 +585,7 @@ void render(GLFWwindow* window)
 		setUniformMVP(pgTexturing.pg, ModelMatrix, ViewMatrix, ProjectionMatrix);
 
 		// Texture
-		setUniformi(pgTexturing.pg, "tex", 0); // 0 for GL_TEXTURE0
+		setMaterial(pgTexturing.pg, "tex", "layer", material[MAT_SNOW_COLOR]);
 
 		// Light Position
 		setUniform(pgTexturing.pg, "LightPosition", l);
@@ -609,7 +612,7 @@ void render(GLFWwindow* window)
 		setUniformMVP(pgDoubleVision.pg, ModelMatrix, ViewMatrix, ProjectionMatrix);
 
 		// Texture
-		setUniformi(pgDoubleVision.pg, "tex", 1); // 1 for GL_TEXTURE1
+		setMaterial(pgDoubleVision.pg, "tex", "layer", material[MAT_DEMON]);
 
 		// Separation
 		setUniform(pgDoubleVision.pg, "leftSeparation", leftSeparation);
@@ -639,8 +642,8 @@ void render(GLFWwindow* window)
 		setUniformMVP(pgNormalMapping.pg, ModelMatrix, ViewMatrix, ProjectionMatrix);
 
 		// Textures
-		setUniformi(pgNormalMapping.pg, "texDiffuse", 0);//÷ؽó // 0 for GL_TEXTURE0
-		setUniformi(pgNormalMapping.pg, "texNormal", 3);//븻ؽó // 3 for GL_TEXTURE3
+		setMaterial(pgNormalMapping.pg, "texDiffuse", "diffuseLayer", material[MAT_SNOW_COLOR]);
+		setMaterial(pgNormalMapping.pg, "texNormal", "normalLayer", material[MAT_SNOW_NORMAL]);
 
 		// Scale
 		setUniform(pgNormalMapping.pg, "scale", scale); // Height scale for normal mapping
@@ -677,7 +680,7 @@ void render(GLFWwindow* window)
 		isOK("glBlendFunc()", __FILE__, __LINE__);
 
 		// Texture
-		setUniformi(pgTexturing.pg, "tex", 2); // 2 for GL_TEXTURE2
+		setMaterial(pgTexturing.pg, "tex", "layer", material[MAT_LOGO]);
 
 		// Light Position
 		setUniform(pgTexturing.pg, "LightPosition", l);
@@ -699,6 +702,17 @@ void render(GLFWwindow* window)
 	// Exercise
 	if(exercise) renderColorAlphaNormalMappedQuad(l);
 
+	// Normal mapping of a mesh
+	if (bunnyMapping) renderNormalMappedBunny(l);
+
+	// Uploads of the reloaded textures and the budget for the next frame
+	updateTextures();
+
+	// Texture binds of this frame, 0 once every texture is bound to its unit
+	binds = textureBinds() - binds;
+	if (binds != frameBinds) cout << "Texture binds per frame: " << binds << endl;
+	frameBinds = binds;
+
 	// Check the status
 	isOK("render()", __FILE__, __LINE__);
 }
@@ -718,8 +732,8 @@ void renderColorAlphaNormalMappedQuad(const Vector3f& l)
 	isOK("glBlendFunc()", __FILE__, __LINE__);
 
 	// Textures
-	setUniformi(pgNormalMapping.pg, "texDiffuse", 4);//÷ؽó // 4 for GL_TEXTURE4
-	setUniformi(pgNormalMapping.pg, "texNormal", 3);//븻ؽó // 3 for GL_TEXTURE3
+	setMaterial(pgNormalMapping.pg, "texDiffuse", "diffuseLayer", material[MAT_SNOW_COLOR_ALPHA]);
+	setMaterial(pgNormalMapping.pg, "texNormal", "normalLayer", material[MAT_SNOW_NORMAL]);
 
 	// Scale
 	setUniform(pgNormalMapping.pg, "scale", scale); // Height scale for normal mapping
@@ -767,6 +781,9 @@ keyboard(GLFWwindow* window, int key, int scancode, int action, int mods)
 		// Overlay an normal-mapped quad
 		case GLFW_KEY_N:	normalMapping = !normalMapping; break;
 
+		// Normal-mapped bunny
+		case GLFW_KEY_U:	bunnyMapping = !bunnyMapping; break;
+
 			// Exercise
 		case GLFW_KEY_E:	exercise = !exercise; break;	// Ambient
 
@@ -776,9 +793,54 @@ keyboard(GLFWwindow* window, int key, int scancode, int action, int mods)
 			// Rotation initialization
 		case GLFW_KEY_I:	angle = 0; break;
 
+			// Mipmapping on/off
+		case GLFW_KEY_M:	mipmapping = !mipmapping; setMinificationFilter(); break;
+
+			// Texture budget
+		case GLFW_KEY_B:
+			budgetIndex = (budgetIndex + 1) % 3;
+			setTextureBudget(textureBudgets[budgetIndex] ? textureBudgets[budgetIndex] : SIZE_MAX);
+			printTextureStatistics();
+			break;
+
+			// Texture residency
+		case GLFW_KEY_T:	printTextureStatistics(); break;
+
 			// Height scaling
 		case GLFW_KEY_UP:	scale += 0.1f; cout << "scale = " << scale << endl;	break;
 		case GLFW_KEY_DOWN: scale -= 0.1f; cout << "scale = " << scale << endl; break;
 		}
 	}
 }
+
+void renderNormalMappedBunny(const Vector3f& l)
+{
+	// Model matrix
+	Affine3f	T;	T = Translation3f(0.0f, -0.15f, 0.0f)
+		* Matrix3f(AngleAxisf(angle, Vector3f::UnitY()))
+		* Scaling(0.5f, 0.5f, 0.5f);
+	Matrix4f	ModelMatrix = T.matrix();
+
+	// Model, view, projection matrices
+	setUniformMVP(pgTangentMapping.pg, ModelMatrix, ViewMatrix, ProjectionMatrix);
+
+	// Textures
+	setMaterial(pgTangentMapping.pg, "texDiffuse", "diffuseLayer", material[MAT_SNOW_COLOR]);
+	setMaterial(pgTangentMapping.pg, "texNormal", "normalLayer", material[MAT_SNOW_NORMAL]);
+
+	// Scale
+	setUniform(pgTangentMapping.pg, "scale", scale); // Height scale for normal mapping
+
+	// Light Position
+	setUniform(pgTangentMapping.pg, "LightPosition", l);
+
+	// Material is dependent of the object
+	setUniform(pgTangentMapping.pg, "Ka", Vector3f(0.10f, 0.10f, 0.10f));
+	setUniform(pgTangentMapping.pg, "Kd", Vector3f(0.95f, 0.95f, 0.95f));
+	setUniform(pgTangentMapping.pg, "Ks", Vector3f(0.50f, 0.50f, 0.50f));
+	setUniform(pgTangentMapping.pg, "Shininess", 128.0f);
+
+	// Draw the mesh using the program and the vertex buffer object
+	glUseProgram(pgTangentMapping.pg);
+	drawVBO(bunny.vao, bunny.numTris);
+}
@@ -2,7 +2,8 @@
 #version 400
 
 // Texture
-uniform sampler2D tex;
+uniform sampler2DArray tex;
+uniform int	layer = 0;		// Layer of the material in tex
 
 // Phong reflection model
 uniform vec3	LightPosition;					// In the view coordinate system
@@ -73,8 +74,8 @@ void
 main(void)
 {
 	// Texture
-	vec3 leftColor = texture(tex,leftTexcoord).rgb;
-	vec3 rightColor = texture(tex, rightTexcoord).rgb;
+	vec3 leftColor = texture(tex, vec3(leftTexcoord, layer)).rgb;
+	vec3 rightColor = texture(tex, vec3(rightTexcoord, layer)).rgb;
 	vec3 color = mix ( leftColor, rightColor,0.5); // interpolation
 
 	// Lighting
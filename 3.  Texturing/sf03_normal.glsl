@@ -1,8 +1,11 @@
 
 #version 400
 
-uniform sampler2D   texDiffuse;
-uniform sampler2D   texNormal;
+uniform sampler2DArray  texDiffuse;
+uniform sampler2DArray  texNormal;
+
+uniform int     diffuseLayer = 0;
+uniform int     normalLayer = 0;
 
 uniform float   scale = 1;
 
@@ -61,9 +64,9 @@ in vec2 texcoord;
 out vec4 outColor;
 
 void main() {
-    vec4    color = texture(texDiffuse, texcoord);
+    vec4    color = texture(texDiffuse, vec3(texcoord, diffuseLayer));
 
-    vec3    N = texture(texNormal, texcoord).rgb;
+    vec3    N = texture(texNormal, vec3(texcoord, normalLayer)).rgb;
             N = 2 * N - 1;
             N.x *= scale;   N.y *= scale;
             N = normalize(N);
@@ -0,0 +1,82 @@
+
+#version 400
+
+uniform sampler2DArray  texDiffuse;
+uniform sampler2DArray  texNormal;
+
+uniform int     diffuseLayer = 0;
+uniform int     normalLayer = 0;
+
+uniform float   scale = 1;
+
+uniform vec3    LightPosition;
+uniform vec3    Kd = vec3(0.95, 0.95, 0.95);
+uniform vec3    Ka = vec3(0.10, 0.10, 0.10);
+uniform vec3    Ks = vec3(0.75, 0.75, 0.75);
+uniform float   Shininess = 20.0;
+
+struct Light
+{
+    vec3    position;
+    vec3    ambient;
+    vec3    diffuse;
+    vec3    specular;
+    vec3    attenuation;
+};
+
+Light L0 = Light(
+    LightPosition,
+    vec3(1.0, 1.0, 1.0),
+    vec3(1.0, 1.0, 1.0),
+    vec3(1.0, 1.0, 1.0),
+    vec3(1.0, 0.0, 0.0)
+);
+
+vec3 phongReflectionModel(Light L0, vec3 P, vec3 N){
+    vec3    color = Ka * L0.ambient;
+
+    vec3    L = L0.position - P;
+    float   l = length(L);
+            L = normalize(L);
+
+    float   attenuation = L0.attenuation.x + L0.attenuation.y * l +L0.attenuation.z * l * l;
+    attenuation = clamp(1.0 / attenuation, 0, 1);
+
+    float   lambertian = max(dot(N, L), 0.0);
+
+    color += (attenuation * lambertian) * Kd * L0.diffuse;
+
+    if (lambertian > 0) {
+        vec3    R = normalize(-reflect(L, N));
+        vec3    V = normalize(-P);
+
+        float   specular = pow(max(dot(R, V), 0.0), Shininess);
+        color += (attenuation * specular) * Ks * L0.specular;
+    }
+
+    return color;
+}
+
+in vec3 position;
+in vec3 normal;
+in vec4 tangent;
+in vec2 texcoord;
+
+out vec4 outColor;
+
+void main() {
+    vec4    color = texture(texDiffuse, vec3(texcoord, diffuseLayer));
+
+    vec3    N = texture(texNormal, vec3(texcoord, normalLayer)).rgb;
+            N = 2 * N - 1;
+            N.x *= scale;   N.y *= scale;
+
+    // Tangent space of the vertex into the view coordinate system
+    vec3    n = normalize(normal);
+    vec3    t = normalize(tangent.xyz - n * dot(n, tangent.xyz));
+    vec3    b = tangent.w * cross(n, t);
+            N = normalize(mat3(t, b, n) * N);
+
+    outColor.rgb = phongReflectionModel(L0, position, N) * color.rgb;
+    outColor.a = color.a;
+}
@@ -2,7 +2,8 @@
 #version 400
 
 // Texture
-uniform sampler2D tex; // ̰ ؽóӿ
+uniform sampler2DArray tex; // ̰ ؽóӿ
+uniform int	layer = 0;		// Layer of the material in tex
 
 // Phong reflection model
 uniform vec3	LightPosition;					// In the view coordinate system
@@ -72,7 +73,7 @@ void
 main(void)
 {
 	// Texture
-	vec4 color = texture(tex,texcoord); // 2 ؽó ؽóǥ referenceؼ ÷ ´.
+	vec4 color = texture(tex, vec3(texcoord, layer)); // 2 ؽó ؽóǥ referenceؼ ÷ ´.
 
 	// Lighting
 	outColor.rgb = phongReflectionModel(L0, position, normalize(normal))*color.rgb; // phongReflectionModel -> intensity.
@@ -0,0 +1,28 @@
+#version 400
+
+layout (location = 0) in vec3   VertexPosition;
+layout (location = 1) in vec3   VertexNormal;
+layout (location = 2) in vec2   VertexTexcoord;
+layout (location = 3) in vec4   VertexTangent;     // Handedness in w
+
+out vec3    position;
+out vec3    normal;
+out vec4    tangent;
+out vec2    texcoord;
+
+uniform mat4    ModelViewProjectionMatrix;
+uniform mat4    ModelViewMatrix;
+uniform mat3    NormalMatrix;
+
+void main() {
+    gl_Position = ModelViewProjectionMatrix * vec4(VertexPosition, 1.0);
+
+    position = vec3(ModelViewMatrix * vec4(VertexPosition, 1.0));
+    normal = normalize(NormalMatrix * VertexNormal);
+
+    // Tangents transform as the positions, and 2 bits may decode -1 as -1/3 before GL 4.2
+    tangent.xyz = normalize(mat3(ModelViewMatrix) * VertexTangent.xyz);
+    tangent.w = sign(VertexTangent.w);
+
+    texcoord = VertexTexcoord;
+}
@@ -0,0 +1,138 @@
+#include "tangent.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <vector>
+using namespace std;
+
+static const int	GRAIN = 1024;	// Minimum faces or vertices of a thread
+
+// f(begin, end) over the ranges of [0, n) on the threads
+static void
+parallelRanges(int n, int numThreads, const function<void(int, int)>& f)
+{
+	if (numThreads <= 0) numThreads = max(int(thread::hardware_concurrency()), 1);
+	numThreads = max(min(numThreads, (n + GRAIN - 1) / GRAIN), 1);
+
+	vector<thread>	workers;
+	for (int i = 1; i < numThreads; i++)
+		workers.push_back(thread(f, int(int64_t(n) * i / numThreads), int(int64_t(n) * (i + 1) / numThreads)));
+
+	f(0, int(int64_t(n) / numThreads));
+
+	for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+}
+
+// Unit vector v projected onto the plane of the unit normal n, or zero
+static inline Vector3f
+projectOnto(const Vector3f& v, const Vector3f& n)
+{
+	Vector3f	p = v - n * n.dot(v);
+	float		l = p.norm();
+
+	return (l > 1.0e-20f) ? Vector3f(p / l) : Vector3f(Vector3f::Zero());
+}
+
+// Any unit vector perpendicular to the unit vector n
+static inline Vector3f
+perpendicular(const Vector3f& n)
+{
+	Vector3f	axis = (fabs(n.x()) < 0.9f) ? Vector3f::UnitX() : Vector3f::UnitY();
+
+	return projectOnto(axis, n);
+}
+
+int
+computeTangents(const ArrayXXi& face, const MatrixXf& vertex, const MatrixXf& normal,
+	const MatrixXf& texcoord, MatrixXf& tangent, int numThreads)
+{
+	int	numFaces = int(face.cols());
+	int	numVertices = int(vertex.cols());
+
+	// Angle-weighted tangent and bitangent of every corner
+	vector<Vector3f>	cornerT(size_t(numFaces) * 3), cornerB(size_t(numFaces) * 3);
+	vector<int>			degenerate(numFaces, 0);
+
+	parallelRanges(numFaces, numThreads, [&](int begin, int end)
+	{
+		for (int f = begin; f < end; f++)
+		{
+			Vector3f	p[3];
+			Vector2f	uv[3];
+			for (int c = 0; c < 3; c++)
+			{
+				p[c] = vertex.col(face(c, f));
+				uv[c] = texcoord.col(face(c, f));
+			}
+
+			// Derivatives of the position along u and v
+			Vector3f	e1 = p[1] - p[0], e2 = p[2] - p[0];
+			Vector2f	d1 = uv[1] - uv[0], d2 = uv[2] - uv[0];
+			float		det = d1.x() * d2.y() - d2.x() * d1.y();
+
+			Vector3f	s = e1 * d2.y() - e2 * d1.y();
+			Vector3f	t = e2 * d1.x() - e1 * d2.x();
+			if (fabs(det) < 1.0e-20f || s.squaredNorm() == 0 || t.squaredNorm() == 0)
+			{
+				degenerate[f] = 1;
+				for (int c = 0; c < 3; c++) cornerT[3 * f + c] = cornerB[3 * f + c] = Vector3f::Zero();
+				continue;
+			}
+
+			// Orientation of the UVs
+			if (det < 0) { s = -s; t = -t; }
+			s.normalize();
+			t.normalize();
+
+			for (int c = 0; c < 3; c++)
+			{
+				Vector3f	n = normal.col(face(c, f));
+				Vector3f	a = projectOnto(p[(c + 1) % 3] - p[c], n);
+				Vector3f	b = projectOnto(p[(c + 2) % 3] - p[c], n);
+				float		angle = acos(min(max(a.dot(b), -1.0f), 1.0f));
+
+				cornerT[3 * f + c] = angle * projectOnto(s, n);
+				cornerB[3 * f + c] = angle * projectOnto(t, n);
+			}
+		}
+	});
+
+	// Corners of every vertex in the order of the faces
+	vector<int>	first(numVertices + 1, 0), corner(size_t(numFaces) * 3);
+	for (int f = 0; f < numFaces; f++)
+		for (int c = 0; c < 3; c++) first[face(c, f) + 1]++;
+	for (int v = 0; v < numVertices; v++) first[v + 1] += first[v];
+
+	vector<int>	next(first.begin(), first.end() - 1);
+	for (int f = 0; f < numFaces; f++)
+		for (int c = 0; c < 3; c++) corner[next[face(c, f)]++] = 3 * f + c;
+
+	// Orthonormal tangent and the handedness of every vertex
+	tangent.resize(4, numVertices);
+	parallelRanges(numVertices, numThreads, [&](int begin, int end)
+	{
+		for (int v = begin; v < end; v++)
+		{
+			Vector3f	T = Vector3f::Zero(), B = Vector3f::Zero();
+			for (int i = first[v]; i < first[v + 1]; i++)
+			{
+				T += cornerT[corner[i]];
+				B += cornerB[corner[i]];
+			}
+
+			Vector3f	n = normal.col(v);
+			T = projectOnto(T, n);
+			if (T.squaredNorm() == 0) T = perpendicular(n);
+
+			tangent.col(v) << T, (n.cross(T).dot(B) < 0) ? -1.0f : 1.0f;
+		}
+	});
+
+	int	numDegenerate = 0;
+	for (int f = 0; f < numFaces; f++) numDegenerate += degenerate[f];
+
+	return numDegenerate;
+}
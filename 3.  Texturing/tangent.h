@@ -0,0 +1,27 @@
+#pragma once
+
+#ifndef __TANGENT_H_
+#define __TANGENT_H_
+
+#include <Eigen/Dense>
+using namespace Eigen;
+
+// Per-vertex tangent frames for normal mapping
+//
+// Follows the conventions of MikkTSpace: every corner of a face contributes the tangent of
+// the face, the derivative of the position along u, projected onto the plane of the vertex
+// normal and weighted by the angle of the corner. The sum is orthogonalized against the
+// normal and normalized, and the sign of the bitangent goes into w. A shader reconstructs
+// the bitangent as w (N x T), which handles the mirrored UVs. The vertices are not split at
+// the UV seams, so the meshes are expected to share a vertex only with the same UVs.
+//
+// The faces and then the vertices are processed in parallel, O(# of faces) in total. The
+// vertex pass gathers the corners through a vertex-to-corner table in the order of the
+// faces, so the result does not depend on the # of threads.
+
+// tangent is 4 x # of vertices. Returns the # of faces of degenerate UVs, which contribute
+// nothing. A vertex without any contribution gets a tangent perpendicular to its normal.
+int		computeTangents(const ArrayXXi& face, const MatrixXf& vertex, const MatrixXf& normal,
+	const MatrixXf& texcoord, MatrixXf& tangent, int numThreads = 0);	// 0 for all the cores
+
+#endif	// __TANGENT_H_
@@ -0,0 +1,154 @@
+//
+// texconv: offline converter of the .raw images and the C arrays into texture containers
+//
+// Not a part of the sample project. Build it with
+//   cl /O2 /EHsc texconv.cpp textureFile.cpp mipmap.cpp
+//   g++ -O2 -pthread texconv.cpp textureFile.cpp mipmap.cpp -o texconv
+//
+// Usage: texconv input w h channels output.tex [options]
+//   input            .raw bytes, or a C array of comma-separated bytes such as m02_demon_image.h
+//   --alpha file     Alpha of the same size from another .raw file, into 4 channels
+//   --alpha-only     Single channel used as the alpha with RGB = 0
+//   --linear         Not a color, e.g., a normal map (sRGB colors by default)
+//   --wrap           GL_REPEAT instead of GL_CLAMP_TO_EDGE
+//   --filter f       box, kaiser (default) or lanczos
+//   --no-mipmaps     Only the level 0
+//
+#include "textureFile.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Bytes of a .raw file, or the numbers of a C array skipping the comments
+static bool
+readImage(const char* filename, size_t size, vector<unsigned char>& data)
+{
+	ifstream	is(filename, ios::binary);
+	if (is.fail())
+	{
+		cerr << "ERROR: Can't open " << filename << endl;
+		return false;
+	}
+
+	string	ext = filename;
+	ext = ext.substr(ext.find_last_of('.') + 1);
+	if (ext == "h" || ext == "c" || ext == "inc")
+	{
+		string	text((istreambuf_iterator<char>(is)), istreambuf_iterator<char>());
+
+		data.clear();
+		for (size_t i = 0; i < text.size(); )
+		{
+			if (text.compare(i, 2, "/*") == 0)		i = min(text.find("*/", i + 2), text.size() - 2) + 2;
+			else if (text.compare(i, 2, "//") == 0)	i = min(text.find('\n', i), text.size() - 1) + 1;
+			else if (isdigit((unsigned char)text[i]))
+			{
+				char*	end = NULL;
+				data.push_back((unsigned char)strtol(&text[i], &end, 0));
+				i = end - &text[0];
+			}
+			else i++;
+		}
+	}
+	else data.assign(istreambuf_iterator<char>(is), istreambuf_iterator<char>());
+
+	if (data.size() < size)
+	{
+		cerr << "ERROR: only " << data.size() << " bytes in " << filename << " for " << size << endl;
+		return false;
+	}
+	data.resize(size);
+
+	return true;
+}
+
+int
+main(int argc, char* argv[])
+{
+	if (argc < 6)
+	{
+		cerr << "Usage: " << argv[0] << " input w h channels output.tex [--alpha file] [--alpha-only]"
+			<< " [--linear] [--wrap] [--filter box|kaiser|lanczos] [--no-mipmaps]" << endl;
+		return -1;
+	}
+
+	const char*	input = argv[1];
+	int			w = atoi(argv[2]), h = atoi(argv[3]), channels = atoi(argv[4]);
+	const char*	output = argv[5];
+
+	const char*	alphaFile = NULL;
+	bool		alphaOnly = false, mipmaps = true;
+	unsigned	flags = TEXTURE_SRGB;
+	MipFilter	filter = MIP_KAISER;
+	for (int i = 6; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--alpha") == 0 && i + 1 < argc)	alphaFile = argv[++i];
+		else if (strcmp(argv[i], "--alpha-only") == 0)			alphaOnly = true;
+		else if (strcmp(argv[i], "--linear") == 0)				flags &= ~TEXTURE_SRGB;
+		else if (strcmp(argv[i], "--wrap") == 0)				flags |= TEXTURE_WRAP;
+		else if (strcmp(argv[i], "--no-mipmaps") == 0)			mipmaps = false;
+		else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+		{
+			string	f = argv[++i];
+			if (f == "box")				filter = MIP_BOX;
+			else if (f == "kaiser")		filter = MIP_KAISER;
+			else if (f == "lanczos")	filter = MIP_LANCZOS;
+			else { cerr << "ERROR: Unknown filter " << f << endl; return -1; }
+		}
+		else { cerr << "ERROR: Unknown option " << argv[i] << endl; return -1; }
+	}
+
+	if (w <= 0 || h <= 0 || (channels != 1 && channels != 3))
+	{
+		cerr << "ERROR: Invalid size " << w << "x" << h << "x" << channels << endl;
+		return -1;
+	}
+
+	vector<unsigned char>	texel;
+	if (!readImage(input, size_t(w) * h * channels, texel)) return -1;
+
+	// Gray into the alpha with RGB = 0, which the loader swizzles
+	if (alphaOnly)
+	{
+		if (channels != 1) { cerr << "ERROR: --alpha-only for a single channel" << endl; return -1; }
+		flags = (flags & ~TEXTURE_SRGB) | TEXTURE_ALPHA;
+	}
+
+	// RGB and the alpha into RGBA
+	if (alphaFile)
+	{
+		if (channels != 3) { cerr << "ERROR: --alpha for 3 channels" << endl; return -1; }
+
+		vector<unsigned char>	alpha;
+		if (!readImage(alphaFile, size_t(w) * h, alpha)) return -1;
+
+		vector<unsigned char>	rgba(size_t(w) * h * 4);
+		for (size_t i = 0; i < size_t(w) * h; i++)
+		{
+			rgba[4 * i + 0] = texel[3 * i + 0];
+			rgba[4 * i + 1] = texel[3 * i + 1];
+			rgba[4 * i + 2] = texel[3 * i + 2];
+			rgba[4 * i + 3] = alpha[i];
+		}
+		texel.swap(rgba);
+		channels = 4;
+	}
+
+	if (!writeTextureFile(output, &texel[0], w, h, channels, flags, filter, mipmaps)) return -1;
+
+	cout << output << ": " << w << "x" << h << "x" << channels
+		<< ((flags & TEXTURE_SRGB) ? " sRGB" : "") << ((flags & TEXTURE_WRAP) ? " wrap" : "")
+		<< ((flags & TEXTURE_ALPHA) ? " alpha" : "")
+		<< (mipmaps ? string(" with the mipmaps of the ") + mipFilterName[filter] + " filter" : "") << endl;
+
+	return 0;
+}
@@ -0,0 +1,93 @@
+#include "textureFile.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <vector>
+using namespace std;
+
+static uint64_t
+align16(uint64_t offset)
+{
+	return (offset + 15) & ~uint64_t(15);
+}
+
+bool
+writeTextureFile(const char* filename, const unsigned char* texel, int w, int h, int channels,
+	unsigned flags, MipFilter filter, bool mipmaps)
+{
+	if (channels != 1 && channels != 3 && channels != 4)
+	{
+		cerr << "ERROR: " << channels << " channels are not supported" << endl;
+		return false;
+	}
+
+	vector<MipLevel>	levels;
+	if (mipmaps)
+		buildMipChain(texel, w, h, channels, filter, (flags & TEXTURE_SRGB) != 0,
+			(flags & TEXTURE_WRAP) != 0, levels);
+
+	TextureHeader	header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, TEXTURE_FILE_MAGIC, 4);
+	header.version = TEXTURE_FILE_VERSION;
+	header.width = w;
+	header.height = h;
+	header.channels = channels;
+	header.flags = flags;
+	header.numLevels = uint32_t(min(levels.size() + 1, size_t(MAX_TEXTURE_LEVELS)));
+
+	uint64_t	offset = align16(sizeof(TextureHeader));
+	for (uint32_t i = 0; i < header.numLevels; i++)
+	{
+		TextureLevel&	level = header.level[i];
+		level.w = (i == 0) ? w : levels[i - 1].w;
+		level.h = (i == 0) ? h : levels[i - 1].h;
+		level.offset = offset;
+		level.size = uint64_t(level.w) * level.h * channels;
+
+		offset = align16(offset + level.size);
+	}
+
+	ofstream	os(filename, ios::binary);
+	if (os.fail())
+	{
+		cerr << "ERROR: Can't open " << filename << endl;
+		return false;
+	}
+
+	static const char	zero[16] = { 0 };
+	os.write((const char*)&header, sizeof(header));
+	for (uint32_t i = 0; i < header.numLevels; i++)
+	{
+		const TextureLevel&	level = header.level[i];
+
+		os.write(zero, streamsize(level.offset - os.tellp()));
+		os.write((const char*)(i == 0 ? texel : &levels[i - 1].texel[0]), streamsize(level.size));
+	}
+
+	return os.good();
+}
+
+const TextureHeader*
+textureHeader(const void* data, size_t size)
+{
+	if (data == NULL || size < sizeof(TextureHeader)) return NULL;
+
+	const TextureHeader*	header = (const TextureHeader*)data;
+	if (memcmp(header->magic, TEXTURE_FILE_MAGIC, 4) != 0) return NULL;
+	if (header->version != TEXTURE_FILE_VERSION) return NULL;
+	if (header->numLevels < 1 || header->numLevels > uint32_t(MAX_TEXTURE_LEVELS)) return NULL;
+	if (header->channels != 1 && header->channels != 3 && header->channels != 4) return NULL;
+
+	for (uint32_t i = 0; i < header->numLevels; i++)
+	{
+		const TextureLevel&	level = header->level[i];
+		if (level.size != uint64_t(level.w) * level.h * header->channels) return NULL;
+		if (level.offset > size || level.size > size - level.offset) return NULL;
+	}
+
+	return header;
+}
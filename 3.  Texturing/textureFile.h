@@ -0,0 +1,58 @@
+#pragma once
+
+#ifndef __TEXTURE_FILE_H_
+#define __TEXTURE_FILE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mipmap.h"
+
+// Texture container
+//
+// A fixed-size header with the dimensions, the # of channels and the offset of every mip
+// level, followed by the levels tightly packed at offsets aligned to 16 bytes. A loader
+// maps the file and passes the levels to glTexImage2D() as they are, without any parsing
+// or conversion. The files are little-endian as written by the x86 and ARM machines.
+//
+// The files are written offline by texconv from .raw files or C arrays.
+
+static const char		TEXTURE_FILE_MAGIC[4] = { 'T', 'E', 'X', 'C' };
+static const uint32_t	TEXTURE_FILE_VERSION = 1;
+static const int		MAX_TEXTURE_LEVELS = 16;
+
+enum TextureFlags
+{
+	TEXTURE_SRGB = 1,	// Colors, downsampled in linear space
+	TEXTURE_WRAP = 2,	// GL_REPEAT instead of GL_CLAMP_TO_EDGE
+	TEXTURE_ALPHA = 4,	// Single channel used as the alpha with RGB = 0
+};
+
+struct TextureLevel
+{
+	uint32_t	w, h;
+	uint64_t	offset;		// From the beginning of the file
+	uint64_t	size;		// w x h x channels bytes
+};
+
+struct TextureHeader
+{
+	char		magic[4];
+	uint32_t	version;
+	uint32_t	width, height;
+	uint32_t	channels;	// 1, 3 or 4
+	uint32_t	flags;		// TextureFlags
+	uint32_t	numLevels;	// Including the level 0
+	uint32_t	reserved;
+
+	TextureLevel	level[MAX_TEXTURE_LEVELS];
+};
+
+// Level 0 of w x h x channels bytes, and the mipmaps with the filter unless numLevels is 1
+bool	writeTextureFile(const char* filename, const unsigned char* texel, int w, int h, int channels,
+	unsigned flags, MipFilter filter, bool mipmaps = true);
+
+// Header of a file of size bytes in memory, or NULL if it is not a valid container
+const TextureHeader*	textureHeader(const void* data, size_t size);
+
+#endif	// __TEXTURE_FILE_H_
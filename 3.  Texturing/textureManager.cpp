@@ -0,0 +1,422 @@
+#include "textureManager.h"
+#include "textureFile.h"
+#include "glTexture.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+// Unit for the uploads, out of the way of the samplers
+static const GLenum	UPLOAD_UNIT = GL_TEXTURE0 + 31;
+
+struct ManagedTexture
+{
+	string			key;
+	vector<string>	filename;	// Layers
+	int				refs;
+
+	GLuint	id;				// 0 if not resident
+	int		firstLevel;		// Finest resident level of the files
+	size_t	bytes;			// Of the resident levels
+
+	int				numLevels;		// Of the files, known after the first load
+	vector<size_t>	levelBytes;		// Of every level with all the layers
+
+	int		lastUsed;		// Frame
+	int		request;		// Sequence # of the pending load, 0 if none
+	int		requestLevel;	// firstLevel of the pending load
+
+	ManagedTexture() : refs(0), id(0), firstLevel(0), bytes(0), numLevels(0),
+		lastUsed(-1), request(0), requestLevel(0) {}
+};
+
+static vector<ManagedTexture>		textures;
+static map<string, TextureHandle>	handles;
+
+static size_t	budget = SIZE_MAX;
+static int		frame = 0;
+static int		sequence = 0;
+
+// Statistics
+static int		numLoads = 0;
+static int		numDrops = 0;
+static int		numEvictions = 0;
+
+//
+// Loader thread
+//
+struct LoadRequest
+{
+	TextureHandle	texture;
+	int				sequence;
+	int				firstLevel;
+	vector<string>	filename;
+};
+
+struct LoadResult
+{
+	TextureHandle		texture;
+	int					sequence;
+	int					firstLevel;
+	vector<MappedFile>	file;
+	bool				ok;
+};
+
+static mutex				loaderMutex;
+static condition_variable	loaderWake;
+static thread				loader;
+static deque<LoadRequest>	requests;
+static vector<LoadResult>	results;
+static bool					loaderQuit = false;
+
+// Mapping of the layers with every page touched, so that the uploads do not wait for the disk
+static bool
+mapLayers(const vector<string>& filename, vector<MappedFile>& file)
+{
+	file.assign(filename.size(), MappedFile());
+
+	for (size_t i = 0; i < filename.size(); i++)
+	{
+		if (!mapFile(filename[i].c_str(), file[i]))
+		{
+			cout << "Can't open " << filename[i] << endl;
+			for (size_t j = 0; j < i; j++) unmapFile(file[j]);
+			return false;
+		}
+
+		volatile GLubyte	sum = 0;
+		for (size_t k = 0; k < file[i].size; k += 4096) sum += file[i].data[k];
+	}
+
+	return true;
+}
+
+static void
+loaderThread()
+{
+	unique_lock<mutex>	lock(loaderMutex);
+	for (;;)
+	{
+		loaderWake.wait(lock, [] { return loaderQuit || !requests.empty(); });
+		if (loaderQuit) return;
+
+		LoadRequest	request = requests.front();
+		requests.pop_front();
+
+		lock.unlock();
+		LoadResult	result;
+		result.texture = request.texture;
+		result.sequence = request.sequence;
+		result.firstLevel = request.firstLevel;
+		result.ok = mapLayers(request.filename, result.file);
+		lock.lock();
+
+		results.push_back(result);
+	}
+}
+
+static void
+requestLoad(TextureHandle h, int firstLevel)
+{
+	ManagedTexture&	t = textures[h];
+	t.request = ++sequence;
+	t.requestLevel = firstLevel;
+
+	LoadRequest	request = { h, t.request, firstLevel, t.filename };
+	{
+		lock_guard<mutex>	lock(loaderMutex);
+		if (!loader.joinable()) loader = thread(loaderThread);
+		requests.push_back(request);
+	}
+	loaderWake.notify_one();
+}
+
+//
+// Residency
+//
+
+// Bytes of the texture from the level firstLevel of the files
+static size_t
+textureCost(const ManagedTexture& t, int firstLevel)
+{
+	if (t.levelBytes.empty()) return 0;
+	if (mipmapMode == MIPMAP_NONE) return t.levelBytes[firstLevel];
+
+	size_t	bytes = 0;
+	for (int l = firstLevel; l < t.numLevels; l++) bytes += t.levelBytes[l];
+
+	// Generated by glGenerateMipmap()
+	if (t.numLevels == 1 && mipmapMode == MIPMAP_GL) bytes = bytes * 4 / 3;
+
+	return bytes;
+}
+
+// Texture of the mapped layers replacing the resident one
+static void
+applyLoad(LoadResult& result)
+{
+	ManagedTexture&	t = textures[result.texture];
+	if (result.sequence != t.request) return;
+	t.request = 0;
+
+	// The resident levels are kept, and the next use or drop requests the load again.
+	if (!result.ok)
+	{
+		cout << "Texture: failed to load " << t.key << " from level " << result.firstLevel << endl;
+		return;
+	}
+
+	// Level costs from the headers of the first load
+	if (t.levelBytes.empty())
+	{
+		const TextureHeader*	header = textureHeader(result.file[0].data, result.file[0].size);
+		if (header == NULL) return;
+
+		int	channels = 0;
+		for (size_t i = 0; i < result.file.size(); i++)
+		{
+			const TextureHeader*	layer = textureHeader(result.file[i].data, result.file[i].size);
+			if (layer) channels = max(channels, int(layer->channels));
+		}
+
+		t.numLevels = int(header->numLevels);
+		t.levelBytes.resize(t.numLevels);
+		for (int l = 0; l < t.numLevels; l++)
+			t.levelBytes[l] = size_t(header->level[l].w) * header->level[l].h * result.file.size()
+				* (channels == 1 ? 1 : 4);
+	}
+
+	vector<const char*>	filename(t.filename.size());
+	for (size_t i = 0; i < t.filename.size(); i++) filename[i] = t.filename[i].c_str();
+
+	GLuint	id = 0;
+	glGenTextures(1, &id);
+	bindTexture(UPLOAD_UNIT, GL_TEXTURE_2D_ARRAY, id);
+	if (!uploadTextureArray(&result.file[0], &filename[0], int(filename.size()), result.firstLevel))
+	{
+		deleteTexture(id);
+		return;
+	}
+
+	if (t.id) deleteTexture(t.id);
+	t.id = id;
+	t.firstLevel = min(result.firstLevel, t.numLevels - 1);
+	t.bytes = textureCost(t, t.firstLevel);
+
+	numLoads++;
+}
+
+// Resident bytes after the pending loads
+static size_t
+projectedBytes()
+{
+	size_t	bytes = 0;
+	for (size_t i = 0; i < textures.size(); i++)
+	{
+		const ManagedTexture&	t = textures[i];
+		if (t.request)	bytes += textureCost(t, t.requestLevel);
+		else if (t.id)	bytes += t.bytes;
+	}
+
+	return bytes;
+}
+
+// Drops of the levels and deletions of the least recently used textures
+static void
+enforceBudget()
+{
+	size_t	total = projectedBytes();
+	while (total > budget)
+	{
+		// Released textures first, and then the least recently used
+		int	victim = -1;
+		for (size_t i = 0; i < textures.size(); i++)
+		{
+			const ManagedTexture&	t = textures[i];
+			if (t.id == 0 || t.request || t.lastUsed >= frame) continue;
+
+			if (victim < 0) { victim = int(i); continue; }
+
+			const ManagedTexture&	v = textures[victim];
+			if ((t.refs > 0) < (v.refs > 0) || ((t.refs > 0) == (v.refs > 0) && t.lastUsed < v.lastUsed))
+				victim = int(i);
+		}
+		if (victim < 0) break;
+
+		ManagedTexture&	t = textures[victim];
+		if (mipmapMode != MIPMAP_NONE && t.firstLevel + 1 < t.numLevels)
+		{
+			requestLoad(victim, t.firstLevel + 1);
+			total -= t.bytes - textureCost(t, t.firstLevel + 1);
+			numDrops++;
+		}
+		else
+		{
+			deleteTexture(t.id);
+			t.id = 0;
+			total -= t.bytes;
+			t.bytes = 0;
+			numEvictions++;
+		}
+	}
+}
+
+//
+// Interface
+//
+TextureHandle
+acquireTexture(const char* filename[], int numLayers)
+{
+	string	key;
+	for (int i = 0; i < numLayers; i++) key += (i ? "|" : "") + string(filename[i]);
+
+	map<string, TextureHandle>::iterator	it = handles.find(key);
+	if (it != handles.end())
+	{
+		textures[it->second].refs++;
+		return it->second;
+	}
+
+	TextureHandle	h = TextureHandle(textures.size());
+	handles[key] = h;
+
+	textures.push_back(ManagedTexture());
+	ManagedTexture&	t = textures.back();
+	t.key = key;
+	t.filename.assign(filename, filename + numLayers);
+	t.refs = 1;
+
+	// The first load on this thread so that the texture is ready for the first frame
+	LoadResult	result;
+	result.texture = h;
+	result.sequence = t.request = ++sequence;
+	result.firstLevel = 0;
+	result.ok = mapLayers(t.filename, result.file);
+	applyLoad(result);
+	for (size_t i = 0; i < result.file.size(); i++) unmapFile(result.file[i]);
+
+	t.request = 0;
+
+	return h;
+}
+
+TextureHandle
+acquireTexture(const char* filename)
+{
+	return acquireTexture(&filename, 1);
+}
+
+void
+releaseTexture(TextureHandle h)
+{
+	if (h < 0 || h >= int(textures.size()) || textures[h].refs == 0) return;
+
+	// Kept resident until the budget needs its memory
+	textures[h].refs--;
+}
+
+GLuint
+useTexture(TextureHandle h)
+{
+	if (h < 0 || h >= int(textures.size())) return 0;
+
+	ManagedTexture&	t = textures[h];
+	t.lastUsed = frame;
+
+	// Back to the full resolution
+	if ((t.id == 0 || t.firstLevel > 0) && !(t.request && t.requestLevel == 0)) requestLoad(h, 0);
+
+	return t.id;
+}
+
+void
+updateTextures()
+{
+	vector<LoadResult>	loaded;
+	{
+		lock_guard<mutex>	lock(loaderMutex);
+		loaded.swap(results);
+	}
+
+	for (size_t i = 0; i < loaded.size(); i++)
+	{
+		applyLoad(loaded[i]);
+		for (size_t j = 0; j < loaded[i].file.size(); j++) unmapFile(loaded[i].file[j]);
+	}
+
+	enforceBudget();
+
+	frame++;
+}
+
+void
+setTextureBudget(size_t bytes)
+{
+	budget = bytes;
+}
+
+size_t
+textureBudget()
+{
+	return budget;
+}
+
+size_t
+residentTextureBytes()
+{
+	size_t	bytes = 0;
+	for (size_t i = 0; i < textures.size(); i++) bytes += textures[i].bytes;
+
+	return bytes;
+}
+
+void
+printTextureStatistics()
+{
+	int	resident = 0;
+	for (size_t i = 0; i < textures.size(); i++) resident += (textures[i].id != 0);
+
+	cout << "Textures: " << resident << " of " << textures.size() << " resident in "
+		<< residentTextureBytes() / 1024 << " KB";
+	if (budget != SIZE_MAX) cout << " of the budget " << budget / 1024 << " KB";
+	cout << ", " << numLoads << " load(s), " << numDrops << " level drop(s), "
+		<< numEvictions << " eviction(s)" << endl;
+
+	for (size_t i = 0; i < textures.size(); i++)
+	{
+		const ManagedTexture&	t = textures[i];
+		cout << "  " << t.key << ": " << t.refs << " ref(s), ";
+		if (t.id)	cout << "from level " << t.firstLevel << " in " << t.bytes / 1024 << " KB" << endl;
+		else		cout << "evicted" << endl;
+	}
+}
+
+void
+shutdownTextures()
+{
+	{
+		lock_guard<mutex>	lock(loaderMutex);
+		loaderQuit = true;
+	}
+	loaderWake.notify_all();
+	if (loader.joinable()) loader.join();
+
+	for (size_t i = 0; i < results.size(); i++)
+		for (size_t j = 0; j < results[i].file.size(); j++) unmapFile(results[i].file[j]);
+	results.clear();
+	requests.clear();
+
+	for (size_t i = 0; i < textures.size(); i++)
+		if (textures[i].id) deleteTexture(textures[i].id);
+	textures.clear();
+	handles.clear();
+}
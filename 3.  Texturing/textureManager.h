@@ -0,0 +1,48 @@
+#pragma once
+
+#ifndef __TEXTURE_MANAGER_H_
+#define __TEXTURE_MANAGER_H_
+
+#include <GL/glew.h>				// OpenGL Extension Wrangler Libary
+#include <GLFW/glfw3.h>
+
+#include <stddef.h>
+
+// Texture residency manager
+//
+// Textures of the containers are shared by their paths with reference counts and created as
+// GL_TEXTURE_2D_ARRAY by uploadTextureArray(). The cost of a texture is the bytes of its
+// resident levels and layers, with RGB counted as RGBA as the drivers store it.
+//
+// Over the budget, the textures not used in the current frame are reduced in the order of
+// the least recent use, the released ones first. A texture drops its finest level at a
+// time down to a single level, and is deleted after that. Using a reduced or deleted texture
+// requests it back at the full resolution.
+//
+// The files are mapped and paged in by a loader thread, and uploaded by updateTextures() on
+// the thread of the OpenGL context. A texture keeps its reduced levels until then, and
+// useTexture() returns 0 for a deleted one in the meantime.
+
+typedef int	TextureHandle;
+
+// Containers of the same size as the layers, or a single one
+TextureHandle	acquireTexture(const char* filename[], int numLayers);
+TextureHandle	acquireTexture(const char* filename);
+void			releaseTexture(TextureHandle texture);
+
+// Texture to bind, marked as used in the current frame
+GLuint	useTexture(TextureHandle texture);
+
+// Once a frame after the draws: uploads of the loaded textures and the budget
+void	updateTextures();
+
+void	setTextureBudget(size_t bytes);		// Unlimited by default
+size_t	textureBudget();
+size_t	residentTextureBytes();
+
+void	printTextureStatistics();
+
+// Deletes all the textures and joins the loader thread
+void	shutdownTextures();
+
+#endif	// __TEXTURE_MANAGER_H_
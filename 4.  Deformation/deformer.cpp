@@ -0,0 +1,469 @@
+#include "deformer.h"
+#include "glShader.h"
+
+#include <math.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <thread>
+using namespace std;
+
+#ifdef __AVX2__
+#define DEFORMER_AVX2
+#include <immintrin.h>
+#endif
+
+const char*	deformerName[NUM_DEFORMER_TYPES] = { "twist", "wave", "bend", "taper", "noise" };
+
+// Functions of the deformers in the vertex shader
+static const char*	deformerFunction[NUM_DEFORMER_TYPES] =
+{
+	"deformTwist", "deformWave", "deformBend", "deformTaper", "deformNoise"
+};
+
+struct DeformerProgram
+{
+	GLuint	pg, vs, fs;
+};
+
+static map<string, DeformerProgram>	programs;
+
+string
+deformerSignature(const DeformerStack& stack)
+{
+	if (stack.empty()) return "none";
+
+	string	signature;
+	for (size_t i = 0; i < stack.size(); i++)
+		signature += (i ? "+" : "") + string(deformerName[stack[i].type]);
+
+	return signature;
+}
+
+string
+deformerDefines(const DeformerStack& stack)
+{
+	int	n = min(int(stack.size()), MAX_DEFORMERS);
+
+	string	defines = "#define MAX_DEFORMERS " + to_string(MAX_DEFORMERS) + "\n";
+	defines += "#define NUM_DEFORMERS " + to_string(n) + "\n";
+	defines += "#define DEFORMER_STACK(p, J)";
+	for (int i = 0; i < n; i++)
+		defines += string(" ") + deformerFunction[stack[i].type] + "(" + to_string(i) + ", p, J);";
+
+	return defines + "\n";
+}
+
+GLuint
+deformerProgram(const DeformerStack& stack, const char* vertexShaderFile,
+	const char* fragmentShaderFile)
+{
+	string	key = deformerSignature(stack) + "|" + vertexShaderFile + "|"
+		+ (fragmentShaderFile ? fragmentShaderFile : "feedback");
+
+	map<string, DeformerProgram>::iterator	it = programs.find(key);
+	if (it != programs.end()) return it->second.pg;
+
+	if (int(stack.size()) > MAX_DEFORMERS)
+		cout << "Error: only the first " << MAX_DEFORMERS << " deformers of "
+			<< deformerSignature(stack) << endl;
+
+	double	start = glfwGetTime();
+
+	DeformerProgram	p = { 0, 0, 0 };
+	if (fragmentShaderFile)
+		createShaders(vertexShaderFile, fragmentShaderFile, p.pg, p.vs, p.fs,
+			deformerDefines(stack).c_str());
+	else
+	{
+		// Vertex shader alone with the outputs into the transform feedback buffer
+		p.vs = createShaderFromFile(GL_VERTEX_SHADER, vertexShaderFile, deformerDefines(stack).c_str());
+		p.pg = glCreateProgram();
+		glAttachShader(p.pg, p.vs);
+
+		const char*	varyings[2] = { "position", "normal" };
+		glTransformFeedbackVaryings(p.pg, 2, varyings, GL_INTERLEAVED_ATTRIBS);
+		glLinkProgram(p.pg);
+		printProgramInfoLog(p.pg);
+	}
+	programs[key] = p;
+
+	cout << "Deformers: " << deformerSignature(stack) << " compiled in "
+		<< (glfwGetTime() - start) * 1000.0 << " ms, " << programs.size() << " variant(s)" << endl;
+
+	return p.pg;
+}
+
+void
+setDeformerParameters(GLuint program, const DeformerStack& stack)
+{
+	int	n = min(int(stack.size()), MAX_DEFORMERS);
+	if (n == 0) return;
+
+	GLfloat	param[4 * MAX_DEFORMERS];
+	for (int i = 0; i < n; i++)
+		for (int k = 0; k < 4; k++) param[4 * i + k] = stack[i].param[k];
+
+	int	location = getUniformLocation(program, "deformerParam");
+	if (location < 0) return;
+
+	glProgramUniform4fv(program, location, n, param);
+	isOK("setDeformerParameters()", __FILE__, __LINE__);
+}
+
+int
+numDeformerPrograms()
+{
+	return int(programs.size());
+}
+
+void
+deleteDeformerPrograms()
+{
+	for (map<string, DeformerProgram>::iterator it = programs.begin(); it != programs.end(); it++)
+	{
+		GLuint	shader[2] = { it->second.vs, it->second.fs };
+		deleteShaders(it->second.pg, shader, 2);
+	}
+	programs.clear();
+}
+
+//
+// Deformers on the CPU
+//
+// The same arithmetic as sv04_deformers.glsl, written once for float and for 8 floats in
+// AVX2 registers. Every parameter is the same for all the points, so the branches on the
+// parameters stay scalar.
+//
+static inline float	sqrtv(float x) { return sqrtf(x); }
+static inline float	floorv(float x) { return floorf(x); }
+static inline float	selectv(bool m, float a, float b) { return m ? a : b; }
+static inline void	sincosv(float x, float& s, float& c) { s = sinf(x); c = cosf(x); }
+
+#ifdef DEFORMER_AVX2
+struct Float8
+{
+	__m256	v;
+
+	Float8() {}
+	Float8(__m256 x) : v(x) {}
+	Float8(float x) : v(_mm256_set1_ps(x)) {}
+};
+
+static inline Float8	operator+(Float8 a, Float8 b) { return _mm256_add_ps(a.v, b.v); }
+static inline Float8	operator-(Float8 a, Float8 b) { return _mm256_sub_ps(a.v, b.v); }
+static inline Float8	operator*(Float8 a, Float8 b) { return _mm256_mul_ps(a.v, b.v); }
+static inline Float8	operator/(Float8 a, Float8 b) { return _mm256_div_ps(a.v, b.v); }
+static inline Float8	operator-(Float8 a) { return _mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f)); }
+static inline Float8&	operator+=(Float8& a, Float8 b) { return a = a + b; }
+static inline Float8&	operator*=(Float8& a, Float8 b) { return a = a * b; }
+
+// Comparisons are masks of all the bits
+static inline Float8	operator>(Float8 a, Float8 b) { return _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ); }
+
+static inline Float8	sqrtv(Float8 x) { return _mm256_sqrt_ps(x.v); }
+static inline Float8	floorv(Float8 x) { return _mm256_floor_ps(x.v); }
+static inline Float8	selectv(Float8 m, Float8 a, Float8 b) { return _mm256_blendv_ps(b.v, a.v, m.v); }
+
+// Sine and cosine of the Cephes polynomials with the reduction to [-pi/4, pi/4] in 3 parts,
+// within a few ulps for |x| < 8192
+static inline void
+sincosv(Float8 x, Float8& s, Float8& c)
+{
+	const __m256	signMask = _mm256_set1_ps(-0.0f);
+
+	__m256	signSin = _mm256_and_ps(x.v, signMask);
+	__m256	a = _mm256_andnot_ps(signMask, x.v);
+
+	// Octant j rounded up to even, and the remainder
+	__m256i	j = _mm256_cvttps_epi32(_mm256_mul_ps(a, _mm256_set1_ps(1.27323954473516f)));
+	j = _mm256_and_si256(_mm256_add_epi32(j, _mm256_set1_epi32(1)), _mm256_set1_epi32(~1));
+	__m256	y = _mm256_cvtepi32_ps(j);
+
+	a = _mm256_sub_ps(a, _mm256_mul_ps(y, _mm256_set1_ps(0.78515625f)));
+	a = _mm256_sub_ps(a, _mm256_mul_ps(y, _mm256_set1_ps(2.4187564849853515625e-4f)));
+	a = _mm256_sub_ps(a, _mm256_mul_ps(y, _mm256_set1_ps(3.77489497744594108e-8f)));
+
+	__m256	flipSin = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(j, _mm256_set1_epi32(4)), 29));
+	__m256	flipCos = _mm256_castsi256_ps(_mm256_slli_epi32(
+		_mm256_andnot_si256(_mm256_sub_epi32(j, _mm256_set1_epi32(2)), _mm256_set1_epi32(4)), 29));
+	__m256	swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(
+		_mm256_and_si256(j, _mm256_set1_epi32(2)), _mm256_set1_epi32(2)));
+
+	Float8	z = _mm256_mul_ps(a, a);
+	Float8	r = a;
+	Float8	pc = ((Float8(2.443315711809948e-5f) * z - 1.388731625493765e-3f) * z + 4.166664568298827e-2f)
+		* z * z - Float8(0.5f) * z + 1.0f;
+	Float8	ps = ((Float8(-1.9515295891e-4f) * z + 8.3321608736e-3f) * z - 1.6666654611e-1f) * z * r + r;
+
+	s = _mm256_xor_ps(_mm256_blendv_ps(ps.v, pc.v, swap), _mm256_xor_ps(signSin, flipSin));
+	c = _mm256_xor_ps(_mm256_blendv_ps(pc.v, ps.v, swap), flipCos);
+}
+#endif
+
+// Twist about the z axis with the derivative of the rotation along the gradient of the angle
+template<class F> static inline void
+twistPoint(const Vector4f& param, F p[3], F J[9])
+{
+	F	r = sqrtv(p[0] * p[0] + p[1] * p[1]);
+	F	s, c;
+	sincosv(F(param.x()) * r, s, c);
+
+	F	qx = c * p[0] - s * p[1];
+	F	qy = s * p[0] + c * p[1];
+
+	F	gx = selectv(r > F(0.0f), F(param.x()) * p[0] / r, F(0.0f));
+	F	gy = selectv(r > F(0.0f), F(param.x()) * p[1] / r, F(0.0f));
+
+	// Jk[column][row] = (c, s, 0) + (-qy, qx, 0) gx and (-s, c, 0) + (-qy, qx, 0) gy
+	F	j00 = c - qy * gx, j01 = s + qx * gx;
+	F	j10 = -s - qy * gy, j11 = c + qx * gy;
+	for (int k = 0; k < 3; k++)
+	{
+		F	a = J[3 * k + 0], b = J[3 * k + 1];
+		J[3 * k + 0] = j00 * a + j10 * b;
+		J[3 * k + 1] = j01 * a + j11 * b;
+	}
+
+	p[0] = qx;
+	p[1] = qy;
+}
+
+// Displacement along z by the height h with the gradient (gx, gy) of h
+template<class F> static inline void
+displacePoint(F h, F gx, F gy, F p[3], F J[9])
+{
+	for (int k = 0; k < 3; k++) J[3 * k + 2] += gx * J[3 * k + 0] + gy * J[3 * k + 1];
+	p[2] += h;
+}
+
+template<class F> static inline void
+wavePoint(const Vector4f& param, F p[3], F J[9])
+{
+	F	A = param.x(), Fr = param.y(), phase = param.z();
+	F	r = sqrtv(p[0] * p[0] + p[1] * p[1]);
+	F	s, c;
+	sincosv(Fr * r + phase, s, c);
+
+	F	g = A * Fr * c / r;
+	displacePoint(A * s, selectv(r > F(0.0f), g * p[0], F(0.0f)), selectv(r > F(0.0f), g * p[1], F(0.0f)), p, J);
+}
+
+template<class F> static inline void
+bendPoint(const Vector4f& param, F p[3], F J[9])
+{
+	float	k = param.x();
+	F		s, c;
+	sincosv(F(k) * p[0], s, c);
+
+	F	j00 = (F(1.0f) - F(k) * p[2]) * c, j02 = (F(1.0f) - F(k) * p[2]) * s;
+	for (int i = 0; i < 3; i++)
+	{
+		F	a = J[3 * i + 0], b = J[3 * i + 2];
+		J[3 * i + 0] = j00 * a - s * b;
+		J[3 * i + 2] = j02 * a + c * b;
+	}
+
+	bool	straight = fabs(k) < 1.0e-6f;
+	F		x = (straight ? p[0] : s / F(k)) - p[2] * s;
+	F		z = (straight ? F(0.0f) : (F(1.0f) - c) / F(k)) + p[2] * c;
+	p[0] = x;
+	p[2] = z;
+}
+
+template<class F> static inline void
+taperPoint(const Vector4f& param, F p[3], F J[9])
+{
+	F	t = param.x();
+	F	scale = F(1.0f) + t * p[1];
+
+	F	j10 = t * p[0], j12 = t * p[2];
+	for (int k = 0; k < 3; k++)
+	{
+		F	a = J[3 * k + 0], b = J[3 * k + 1], c = J[3 * k + 2];
+		J[3 * k + 0] = scale * a + j10 * b;
+		J[3 * k + 2] = j12 * b + scale * c;
+	}
+
+	p[0] *= scale;
+	p[2] *= scale;
+}
+
+// Hash of the lattice cell (x, y) in [0, 1), from the PCG hash of Jarzynski and Olano in
+// integers. The 24 bits of the result convert to float exactly, so that the CPU, the AVX2
+// path and the shader agree bit for bit whatever the compiler contracts into FMAs.
+static inline uint32_t
+pcgHash(uint32_t v)
+{
+	uint32_t	state = v * 747796405u + 2891336453u;
+	uint32_t	word = ((state >> ((state >> 28) + 4)) ^ state) * 277803737u;
+	return (word >> 22) ^ word;
+}
+
+static inline float
+hashPoint(float x, float y)
+{
+	uint32_t	h = pcgHash(uint32_t(int(x)) + pcgHash(uint32_t(int(y))));
+	return float(h >> 8) * (1.0f / 16777216.0f);
+}
+
+#ifdef DEFORMER_AVX2
+static inline __m256i
+pcgHash(__m256i v)
+{
+	__m256i	state = _mm256_add_epi32(_mm256_mullo_epi32(v, _mm256_set1_epi32(747796405)),
+		_mm256_set1_epi32(int(2891336453u)));
+	__m256i	shift = _mm256_add_epi32(_mm256_srli_epi32(state, 28), _mm256_set1_epi32(4));
+	__m256i	word = _mm256_mullo_epi32(_mm256_xor_si256(_mm256_srlv_epi32(state, shift), state),
+		_mm256_set1_epi32(277803737));
+	return _mm256_xor_si256(_mm256_srli_epi32(word, 22), word);
+}
+
+static inline Float8
+hashPoint(Float8 x, Float8 y)
+{
+	__m256i	h = pcgHash(_mm256_add_epi32(_mm256_cvttps_epi32(x.v), pcgHash(_mm256_cvttps_epi32(y.v))));
+	return _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(h, 8)), _mm256_set1_ps(1.0f / 16777216.0f));
+}
+#endif
+
+template<class F> static inline void
+noisePoint(const Vector4f& param, F p[3], F J[9])
+{
+	F	a = param.x(), f = param.y();
+	F	x = f * p[0] + param.z(), y = f * p[1] + param.w();
+
+	F	ix = floorv(x), iy = floorv(y);
+	F	fx = x - ix, fy = y - iy;
+
+	F	ux = fx * fx * fx * (fx * (fx * 6.0f - 15.0f) + 10.0f);
+	F	uy = fy * fy * fy * (fy * (fy * 6.0f - 15.0f) + 10.0f);
+	F	dux = F(30.0f) * fx * fx * (fx * (fx - 2.0f) + 1.0f);
+	F	duy = F(30.0f) * fy * fy * (fy * (fy - 2.0f) + 1.0f);
+
+	F	h00 = hashPoint(ix, iy), h10 = hashPoint(ix + 1.0f, iy);
+	F	h01 = hashPoint(ix, iy + 1.0f), h11 = hashPoint(ix + 1.0f, iy + 1.0f);
+
+	F	k1 = h10 - h00, k2 = h01 - h00, k4 = h00 - h10 - h01 + h11;
+	F	n = h00 + k1 * ux + k2 * uy + k4 * ux * uy;
+
+	displacePoint(a * (F(2.0f) * n - 1.0f), F(2.0f) * a * f * dux * (k1 + k4 * uy),
+		F(2.0f) * a * f * duy * (k2 + k4 * ux), p, J);
+}
+
+// Deformed point p and normal n, normalized
+template<class F> static inline void
+deformPoint(const DeformerStack& stack, int numDeformers, F p[3], F n[3])
+{
+	F	J[9] = { 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f };
+	for (int i = 0; i < numDeformers; i++)
+	{
+		switch (stack[i].type)
+		{
+		case DEFORMER_TWIST:	twistPoint(stack[i].param, p, J);	break;
+		case DEFORMER_WAVE:		wavePoint(stack[i].param, p, J);	break;
+		case DEFORMER_BEND:		bendPoint(stack[i].param, p, J);	break;
+		case DEFORMER_TAPER:	taperPoint(stack[i].param, p, J);	break;
+		case DEFORMER_NOISE:	noisePoint(stack[i].param, p, J);	break;
+		default:													break;
+		}
+	}
+	if (n == NULL) return;
+
+	// Inverse transpose of J of the columns a, b and c is [b x c, c x a, a x b] / det(J)
+	const F*	a = J;
+	const F*	b = J + 3;
+	const F*	c = J + 6;
+	F	bc[3] = { b[1] * c[2] - b[2] * c[1], b[2] * c[0] - b[0] * c[2], b[0] * c[1] - b[1] * c[0] };
+	F	ca[3] = { c[1] * a[2] - c[2] * a[1], c[2] * a[0] - c[0] * a[2], c[0] * a[1] - c[1] * a[0] };
+	F	ab[3] = { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] };
+	F	det = a[0] * bc[0] + a[1] * bc[1] + a[2] * bc[2];
+
+	F	m[3];
+	for (int k = 0; k < 3; k++) m[k] = (n[0] * bc[k] + n[1] * ca[k] + n[2] * ab[k]) / det;
+
+	F	l = sqrtv(m[0] * m[0] + m[1] * m[1] + m[2] * m[2]);
+	for (int k = 0; k < 3; k++) n[k] = m[k] / l;
+}
+
+static const int	GRAIN = 4096;	// Minimum points of a thread
+
+// f(begin, end) over the ranges of [0, n) on the threads, in multiples of 8 but the last
+static void
+parallelRanges(int n, int numThreads, const function<void(int, int)>& f)
+{
+	if (numThreads <= 0) numThreads = max(int(thread::hardware_concurrency()), 1);
+	numThreads = max(min(numThreads, (n + GRAIN - 1) / GRAIN), 1);
+
+	vector<thread>	workers;
+	for (int i = 1; i < numThreads; i++)
+	{
+		int	begin = int(int64_t(n) * i / numThreads) & ~7;
+		int	end = (i + 1 < numThreads) ? int(int64_t(n) * (i + 1) / numThreads) & ~7 : n;
+		workers.push_back(thread(f, begin, end));
+	}
+
+	f(0, (numThreads > 1) ? int(int64_t(n) / numThreads) & ~7 : n);
+
+	for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+}
+
+void
+deformPoints(const DeformerStack& stack, int n, float* x, float* y, float* z,
+	float* nx, float* ny, float* nz, int numThreads)
+{
+	int		numDeformers = min(int(stack.size()), MAX_DEFORMERS);
+	bool	normals = nx && ny && nz;
+
+	parallelRanges(n, numThreads, [&](int begin, int end)
+	{
+		int	i = begin;
+#ifdef DEFORMER_AVX2
+		for (; i + 8 <= end; i += 8)
+		{
+			Float8	p[3] = { _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), _mm256_loadu_ps(z + i) };
+			if (normals)
+			{
+				Float8	m[3] = { _mm256_loadu_ps(nx + i), _mm256_loadu_ps(ny + i), _mm256_loadu_ps(nz + i) };
+				deformPoint(stack, numDeformers, p, m);
+
+				_mm256_storeu_ps(nx + i, m[0].v);
+				_mm256_storeu_ps(ny + i, m[1].v);
+				_mm256_storeu_ps(nz + i, m[2].v);
+			}
+			else deformPoint(stack, numDeformers, p, (Float8*)NULL);
+
+			_mm256_storeu_ps(x + i, p[0].v);
+			_mm256_storeu_ps(y + i, p[1].v);
+			_mm256_storeu_ps(z + i, p[2].v);
+		}
+#endif
+		for (; i < end; i++)
+		{
+			float	p[3] = { x[i], y[i], z[i] };
+			if (normals)
+			{
+				float	m[3] = { nx[i], ny[i], nz[i] };
+				deformPoint(stack, numDeformers, p, m);
+
+				nx[i] = m[0]; ny[i] = m[1]; nz[i] = m[2];
+			}
+			else deformPoint(stack, numDeformers, p, (float*)NULL);
+
+			x[i] = p[0]; y[i] = p[1]; z[i] = p[2];
+		}
+	});
+}
+
+bool
+deformerSIMD()
+{
+#ifdef DEFORMER_AVX2
+	return true;
+#else
+	return false;
+#endif
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#ifndef __DEFORMER_H_
+#define __DEFORMER_H_
+
+#include <GL/glew.h>				// OpenGL Extension Wrangler Libary
+#include <GLFW/glfw3.h>
+
+#include <Eigen/Dense>
+using namespace Eigen;
+
+#include <string>
+#include <vector>
+
+// Composable deformers
+//
+// A stack is an ordered list of deformers applied to the undeformed points one after
+// another. Its program is specialized at the compile time: the vertex shader gets the calls
+// of the deformers of the stack through #define, and nothing of the others. The programs are
+// cached by the signature of the stack, the names of the deformers in the order, so that
+// changing the parameters or going back to a previous stack does not compile again.
+//
+// Every deformer chains its analytic Jacobian, and the normals are transformed by the
+// inverse transpose of the product.
+
+enum DeformerType
+{
+	DEFORMER_TWIST = 0,		// param.x: twisting angle per unit distance from the z axis
+	DEFORMER_WAVE,			// param.xyz: amplitude, spatial frequency and phase of a radial wave
+	DEFORMER_BEND,			// param.x: curvature of the bend along x about the y axis
+	DEFORMER_TAPER,			// param.x: scaling of x and z per unit y
+	DEFORMER_NOISE,			// param.xy: amplitude and spatial frequency, zw: offset
+	NUM_DEFORMER_TYPES
+};
+
+extern const char*	deformerName[NUM_DEFORMER_TYPES];
+
+const int	MAX_DEFORMERS = 8;
+
+struct Deformer
+{
+	DeformerType	type;
+	Vector4f		param;
+
+	Deformer(DeformerType t, const Vector4f& p = Vector4f::Zero()) : type(t), param(p) {}
+};
+
+typedef std::vector<Deformer>	DeformerStack;
+
+// "twist+wave", or "none" for the empty stack
+std::string	deformerSignature(const DeformerStack& stack);
+
+// Program of the shaders specialized for the signature of the stack, created at the first use.
+// Without the fragment shader, the vertex shader alone captures position and normal
+// interleaved into the transform feedback buffer.
+GLuint	deformerProgram(const DeformerStack& stack, const char* vertexShaderFile,
+	const char* fragmentShaderFile);
+
+// #define of the calls of the deformers in the order of the stack for the vertex shader
+std::string	deformerDefines(const DeformerStack& stack);
+
+// Parameters of the deformers of the stack into the program of its signature
+void	setDeformerParameters(GLuint program, const DeformerStack& stack);
+
+int		numDeformerPrograms();
+void	deleteDeformerPrograms();
+
+// The stack on the CPU for the collision, picking and export: the same deformation and
+// normals as the vertex shader on the n points of the SoA arrays, in place, with the normals
+// normalized. nx, ny and nz may be NULL for the positions only. The points are split into
+// the ranges of the threads, and 8 points go together in AVX2 when built with it, e.g.,
+// -mavx2 or /arch:AVX2.
+void	deformPoints(const DeformerStack& stack, int n, float* x, float* y, float* z,
+	float* nx, float* ny, float* nz, int numThreads = 0);	// 0 for all the cores
+
+bool	deformerSIMD();		// Built with AVX2
+
+#endif	// __DEFORMER_H_
@@ -4,7 +4,10 @@
 
 #include "glShader.h"
 
+#include <string.h>
+
 #include <iostream>
+#include <string>
 using namespace std;
 
 
@@ -96,7 +99,7 @@ printProgramInfoLog(GLuint obj)
 }
 
 GLuint
-createShaderFromFile(GLenum shaderType, const char* filename)
+createShaderFromFile(GLenum shaderType, const char* filename, const char* defines)
 {
 	// Create the vertex shader
 	GLuint	shader = glCreateShader(shaderType);
@@ -112,8 +115,23 @@ createShaderFromFile(GLenum shaderType, const char* filename)
 	const char* shaderSource = readShader(filename);
 	if (shaderSource == NULL)	return	0;
 
-	// Set the shader source
-	glShaderSource(shader, 1, &shaderSource, NULL);
+	// Set the shader source with the defines after the #version line, and #line for the
+	// line numbers of the file in the compile errors
+	if (defines && defines[0])
+	{
+		const char* version = strstr(shaderSource, "#version");
+		const char* body = version ? strchr(version, '\n') : NULL;
+		body = body ? body + 1 : shaderSource;
+
+		int line = 1;
+		for (const char* c = shaderSource; c < body; c++)	line += (*c == '\n');
+
+		string header(shaderSource, body);
+		string source = string(defines) + "\n#line " + to_string(line) + "\n";
+		const char* part[3] = { header.c_str(), source.c_str(), body };
+		glShaderSource(shader, 3, part, NULL);
+	}
+	else glShaderSource(shader, 1, &shaderSource, NULL);
 
 	// Delete the string read from the shader file
 	delete[]	shaderSource;
@@ -133,11 +151,11 @@ createShaderFromFile(GLenum shaderType, const char* filename)
 // Create the shaders and the program
 void
 createShaders(const char* vertexShaderFileName, const char* fragmentShaderFileName,
-	GLuint& program, GLuint& vertexShader, GLuint& fragmentShader)
+	GLuint& program, GLuint& vertexShader, GLuint& fragmentShader, const char* defines)
 {
 	// Create ther vertex and fragment shaders
-	vertexShader = createShaderFromFile(GL_VERTEX_SHADER, vertexShaderFileName);
-	fragmentShader = createShaderFromFile(GL_FRAGMENT_SHADER, fragmentShaderFileName);
+	vertexShader = createShaderFromFile(GL_VERTEX_SHADER, vertexShaderFileName, defines);
+	fragmentShader = createShaderFromFile(GL_FRAGMENT_SHADER, fragmentShaderFileName, defines);
 
 	// Create the program with the vertex and fragment shaders
 	program = glCreateProgram();
@@ -158,6 +176,33 @@ deleteShaders(GLuint program, GLuint vertexShader, GLuint fragmentShader)
 	if (program)		glDeleteShader(program);
 }
 
+// Create the program with the tessellation control and evaluation shaders in between
+void
+createShaders(const char* vertexShaderFileName, const char* tessControlShaderFileName,
+	const char* tessEvaluationShaderFileName, const char* fragmentShaderFileName,
+	GLuint& program, GLuint shader[4])
+{
+	shader[0] = createShaderFromFile(GL_VERTEX_SHADER, vertexShaderFileName);
+	shader[1] = createShaderFromFile(GL_TESS_CONTROL_SHADER, tessControlShaderFileName);
+	shader[2] = createShaderFromFile(GL_TESS_EVALUATION_SHADER, tessEvaluationShaderFileName);
+	shader[3] = createShaderFromFile(GL_FRAGMENT_SHADER, fragmentShaderFileName);
+
+	program = glCreateProgram();
+
+	for (int i = 0; i < 4; i++)	glAttachShader(program, shader[i]);
+
+	glLinkProgram(program);
+	printProgramInfoLog(program);
+}
+
+void
+deleteShaders(GLuint program, GLuint shader[], int numShaders)
+{
+	for (int i = 0; i < numShaders; i++)
+		if (shader[i]) glDeleteShader(shader[i]);
+	if (program)	glDeleteProgram(program);
+}
+
 // Uniform parameter
 int
 getUniformLocation(GLuint program, const char* name)
@@ -13,15 +13,22 @@ using namespace Eigen;
 bool	isOK(const char* message = NULL, const char* file = NULL, int line = -1,
 	bool exitOnError = true, bool report = true);
 
-// Create and delete the shaders and the program
+// Create and delete the shaders and the program. defines such as "#define X 1\n" go right
+// after the #version line of every shader.
 void	createShaders(const char* vertexShaderFile, const char* fragmentShaderFile,
-	GLuint& program, GLuint& vertexShader, GLuint& fragmentShader);
+	GLuint& program, GLuint& vertexShader, GLuint& fragmentShader, const char* defines = NULL);
 char* readShader(const char* filename);
-GLuint	createShaderFromFile(GLenum shaderType, const char* filename);
+GLuint	createShaderFromFile(GLenum shaderType, const char* filename, const char* defines = NULL);
 void	printShaderInfoLog(GLuint obj, const char* shaderFilename);
 void	printProgramInfoLog(GLuint obj);
 void	deleteShaders(GLuint program, GLuint vertexShader, GLuint fragmentShader);
 
+// Vertex, tessellation control, tessellation evaluation and fragment shaders in shader[]
+void	createShaders(const char* vertexShaderFile, const char* tessControlShaderFile,
+	const char* tessEvaluationShaderFile, const char* fragmentShaderFile,
+	GLuint& program, GLuint shader[4]);
+void	deleteShaders(GLuint program, GLuint shader[], int numShaders);
+
 // Get the location of a uniform parameter
 int getUniformLocation(GLuint program, const char* name);
 int getUniformLocation(GLuint program, const std::string& name);
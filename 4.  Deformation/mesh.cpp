@@ -113,3 +113,29 @@ readMesh(const char* filename, MatrixXf& vertex, ArrayXXi& face,
 
 	return nEdges;
 }
+
+// Regular grid of n x n quads
+void
+createGrid(int n, MatrixXf& vertex, MatrixXf& normal, ArrayXXi& face)
+{
+	int	m = n + 1;	// Vertices a row
+
+	vertex.resize(3, m * m);
+	for (int j = 0; j < m; j++)
+		for (int i = 0; i < m; i++)
+			vertex.col(j * m + i) << float(i) / n - 0.5f, float(j) / n - 0.5f, 0;
+
+	normal.resize(3, m * m);
+	normal.colwise() = Vector3f::UnitZ();
+
+	face.resize(3, 2 * n * n);
+	for (int j = 0; j < n; j++)
+	{
+		for (int i = 0; i < n; i++)
+		{
+			int	v = j * m + i, f = 2 * (j * n + i);
+			face.col(f) << v, v + 1, v + m;
+			face.col(f + 1) << v + m, v + 1, v + m + 1;
+		}
+	}
+}
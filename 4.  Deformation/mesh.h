@@ -12,4 +12,8 @@ int readMesh(const char* fname, MatrixXf& vertex, MatrixXf& normal, ArrayXXi& fa
 int readMesh(const char* fname, MatrixXf& vertex, ArrayXXi& face,
 	MatrixXf& faceNormal, MatrixXf& normal);
 
+// n x n quads on [-0.5, 0.5]^2 at z = 0 in the layout of m01_plane*.off: the vertices row by
+// row with x fastest, and 2 triangles a quad
+void createGrid(int n, MatrixXf& vertex, MatrixXf& normal, ArrayXXi& face);
+
 #endif	// _MESH_H_
\ No newline at end of file
@@ -1,11 +1,17 @@
 #include "glSetup.h"
 #include "glShader.h"
 #include "mesh.h"
+#include "deformer.h"
 
 #include <Eigen/Dense>
 using namespace Eigen;
 
 #include <iostream>
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
 using namespace std;
 
 #ifdef _WIN32
@@ -18,6 +24,9 @@ using namespace std;
 void update();
 void render(GLFWwindow* window);
 void keyboard(GLFWwindow* window, int key, int scancode, int action, int mods);
+void compareTessellation();
+void verifyDeformers();
+void comparePasses();
 
 // Camera configuation
 Vector3f eye(0, 0, 1.75);
@@ -48,23 +57,39 @@ float frequency = 40.0; // Spatial frequence in the wave deformer
 // Program and shaders
 struct Program
 {
-	GLuint vs; // Vertex shader
-	GLuint fs; // Fragment shader
-	GLuint pg; // Program
+	GLuint vs;  // Vertex shader
+	GLuint tcs; // Tessellation control shader
+	GLuint tes; // Tessellation evaluation shader
+	GLuint fs;  // Fragment shader
+	GLuint pg;  // Program
 
-	Program() { vs = 0; fs = 0; pg = 0; }
+	Program() { vs = 0; tcs = 0; tes = 0; fs = 0; pg = 0; }
 
 	void create(const char* vertexShaderFileName, const char* fragmentShaderFileName)
 	{
 		createShaders(vertexShaderFileName, fragmentShaderFileName, pg, vs, fs);
 	}
 
-	void destroy() { deleteShaders(pg, vs, fs); }
+	void create(const char* vertexShaderFileName, const char* tessControlShaderFileName,
+		const char* tessEvaluationShaderFileName, const char* fragmentShaderFileName)
+	{
+		GLuint shader[4];
+		createShaders(vertexShaderFileName, tessControlShaderFileName,
+			tessEvaluationShaderFileName, fragmentShaderFileName, pg, shader);
+		vs = shader[0]; tcs = shader[1]; tes = shader[2]; fs = shader[3];
+	}
+
+	void destroy()
+	{
+		GLuint shader[4] = { vs, tcs, tes, fs };
+		deleteShaders(pg, shader, 4);
+	}
 };
 
-Program pgTwWa;
-Program pgTwist;	// Program for the twist deformer
-Program pgWave;		// Program for the wave deformer
+Program pgTess;		// Program for the adaptive subdivision of the twist and wave deformers
+
+// Stack of the deformers in the vertex shader, with the programs specialized for the stacks
+DeformerStack	deformers;
 
 // Geometry
 struct Geometry
@@ -86,16 +111,33 @@ struct Geometry
 	}
 };
 
-Geometry	plane[4];	// VAO and VBO for nxn planar meshes
+// Planar mesh of gridN x gridN quads, generated in the vertex shader or by createGrid()
+const int	maxGridN = 2048;
+int			gridN = 256;
 
-const char* planeFileName[4] = {
-	"m01_plane32.off", // level 0
-	"m01_plane64.off", // level 1
-	"m01_plane128.off", // level 2
-	"m01_plane256.off" // level 3
-};
+bool		proceduralGrid = true;
+GLuint		gridVAO = 0;	// Empty vertex array for the procedural grid
+
+Geometry	plane;			// VAO and VBO of createGrid()
+int			planeN = 0;		// Resolution of plane
+
+// Adaptive subdivision of patchN x patchN quad patches in the tessellation shaders, with the
+// edge levels of the spatial frequency of the deformers and the edge lengths on the screen
+bool		tessellation = false;
+int			patchN = 16;
+
+// Passes over the deformed plane: the shading, a wireframe overlay and a vertex overlay.
+// With capture, the vertices are deformed once a frame into a transform feedback buffer,
+// and the passes draw the buffer with a pass-through vertex shader.
+int			numPasses = 1;
+bool		capture = false;
 
-int level = 3;
+const Vector3f	passColor[3] = { Vector3f(0.75f, 0.75f, 0.75f), Vector3f(0.05f, 0.05f, 0.05f),
+	Vector3f(0.80f, 0.10f, 0.10f) };
+
+Program		pgPass;			// Pass-through vertex shader of the captured plane
+Geometry	captured;		// vertexId: interleaved positions and normals, indexId: triangles
+int			capturedN = 0;	// Resolution of captured
 
 // Wireframe view
 bool wireframe = false;
@@ -125,6 +167,41 @@ void reshapeModernOpenGL(GLFWwindow* window, int w, int h)
 	cerr << " with screen " << screenW << " x " << screenH << endl;
 }
 
+// --grid n for the resolution up to maxGridN
+void parseGridOptions(int argc, char* argv[])
+{
+	for (int i = 1; i < argc; i++)
+		if (strcmp(argv[i], "--grid") == 0 && i + 1 < argc)
+			gridN = max(1, min(atoi(argv[++i]), maxGridN));
+}
+
+void setGridResolution(int n)
+{
+	gridN = max(1, min(n, maxGridN));
+	cout << "Grid: " << gridN << " x " << gridN << " " << (proceduralGrid ? "procedural" : "indexed VBO")
+		<< ", " << 2 * gridN * gridN << " triangles" << endl;
+}
+
+// Indexed VBO of the current resolution on the CPU
+void updatePlane()
+{
+	if (proceduralGrid || planeN == gridN) return;
+
+	ArrayXXi	face;
+	MatrixXf	vertex;
+	MatrixXf	normal;
+
+	double start = glfwGetTime();
+	createGrid(gridN, vertex, normal, face);
+
+	createVBO(plane.vao, plane.indexId, plane.vertexId, plane.normalId);
+	plane.numTris = uploadMesh2VBO(face, vertex, normal,
+		plane.vao, plane.indexId, plane.vertexId, plane.normalId);
+	planeN = gridN;
+
+	cout << "Grid: generated and uploaded in " << (glfwGetTime() - start) * 1000.0 << " ms" << endl;
+}
+
 int main(int argc, char* argv[])
 {
 	// Initialize the OpenGL system: true for modern OpenGL
@@ -143,27 +220,21 @@ int main(int argc, char* argv[])
 
 	// Initialization
 	{
-		// Create shaders for the twist and wave deformers
-	    // fragmentShader ̴ ̿
-		pgTwWa.create("sv04_wave_twist.glsl", "sf02_Phong.glsl");
+		// Twist and then wave, compiled at the first draw
+		deformers.push_back(Deformer(DEFORMER_TWIST));
+		deformers.push_back(Deformer(DEFORMER_WAVE));
 
-		// Mesh !
-		ArrayXXi	face;
-		MatrixXf	vertex;
-		MatrixXf	normal;
+		// Planar mesh without any files, in the vertex shader by default
+		glGenVertexArrays(1, &gridVAO);
+		parseGridOptions(argc, argv);
+		setGridResolution(gridN);
 
-		for (int i = 0; i < 4; i++)
-		{
-			// Create VBO and VBO for a nxn planar mesh
-			createVBO(plane[i].vao, plane[i].indexId, plane[i].vertexId, plane[i].normalId);
-
-			// Load the mesh
-			readMesh(planeFileName[i], vertex, normal, face);
+		// Passes over the captured plane
+		pgPass.create("sv04_passthrough.glsl", "sf02_Phong.glsl");
 
-			// Upload the data into the buffers
-			plane[i].numTris = uploadMesh2VBO(face, vertex, normal,
-				plane[i].vao, plane[i].indexId, plane[i].vertexId, plane[i].normalId);
-		}
+		// Adaptive subdivision of the same deformers
+		pgTess.create("sv04_patch.glsl", "stc04_wave_twist.glsl", "ste04_wave_twist.glsl",
+			"sf02_Phong.glsl");
 	}
 
 	// Usage
@@ -180,28 +251,47 @@ int main(int argc, char* argv[])
 	cout << "Keyboard Input : 2 for the 64 x 64 planar mesh" << endl;
 	cout << "Keyboard Input : 3 for the 128 x 128 planar mesh" << endl;
 	cout << "Keyboard Input : 4 for the 256 x 256 planar mesh" << endl;
+	cout << "Keyboard Input : left/right to halve/double the resolution up to 2048 x 2048" << endl;
+	cout << "Keyboard Input : g to toggle the procedural grid and the indexed VBO" << endl;
+	cout << endl;
+	cout << "Keyboard Input : a to toggle the adaptive subdivision of twist and wave in the tessellation shaders" << endl;
+	cout << "Keyboard Input : 5/6/7/8/9 to add/remove twist/wave/bend/taper/noise to the deformer stack" << endl;
+	cout << "Keyboard Input : v to verify the CPU deformers against the GPU and time them" << endl;
+	cout << "Keyboard Input : p for 1/2/3 passes of the shading and the wireframe/vertex overlays" << endl;
+	cout << "Keyboard Input : f to toggle the capture of the deformed plane for the passes" << endl;
+	cout << "Keyboard Input : m to measure the passes with and without the capture" << endl;
+	cout << "Keyboard Input : c to compare the triangles and the GPU time with the 256 x 256 mesh" << endl;
 
 	// Main loop
 	while (!glfwWindowShouldClose(window))
 	{
+		beginTiming(TIMING_SIMULATE);
 		// Update one frame if not paused
 		if (!pause)update();
+		endTiming(TIMING_SIMULATE);
 
+		beginTiming(TIMING_RENDER);
 		// Draw one frame
 		render(window);
+		endTiming(TIMING_RENDER);
 
-		glfwSwapBuffers(window); // Swap buffers
+		swapBuffers(window); // Swap buffers
+		beginTiming(TIMING_UPDATE);
 		glfwPollEvents(); // Events
+		endTiming(TIMING_UPDATE);
 	}
 
 	// Finalization
 	{
 		// Delete VBO and shaders
-		for (int i = 0; i < 4; i++)
-			deleteVBO(plane[i].vao, plane[i].indexId, plane[i].vertexId, plane[i].normalId);
+		deleteVBO(plane.vao, plane.indexId, plane.vertexId, plane.normalId);
+		glDeleteVertexArrays(1, &gridVAO);
 
-		pgTwist.destroy();
-		pgWave.destroy();
+		deleteVBO(captured.vao, captured.indexId, captured.vertexId, captured.normalId);
+
+		pgTess.destroy();
+		pgPass.destroy();
+		deleteDeformerPrograms();
 	}
 
 	// Terminate the glfw system
@@ -232,6 +322,398 @@ void setUniformMVP(GLuint program, Matrix4f& M, Matrix4f& V, Matrix4f& P)
 	setUniform(program, "ModelViewProjectionMatrix", ModelViewProjectionMatrix);
 }
 
+void setSceneUniforms(GLuint program, int pass = 0)
+{
+	// Modeling matrix
+	Affine3f T; T = Matrix3f(AngleAxisf(-float(M_PI) / 3.0f, Vector3f::UnitX()))
+		* Scaling(1.5f, 1.5f, 1.5f);
+	Matrix4f	ModelMatrix = T.matrix();
+
+	// Model, view, projection matrices
+	setUniformMVP(program, ModelMatrix, ViewMatrix, ProjectionMatrix);
+
+	// Light position 
+	Vector3f	l = ViewMatrix.block<3, 3>(0, 0) * light2 + ViewMatrix.block<3, 1>(0, 3);
+	setUniform(program, "LightPosition", l);
+
+	setUniform(program, "Ka", Vector3f(0.10f, 0.10f, 0.10f));
+	setUniform(program, "Kd", passColor[pass]);
+	setUniform(program, "Ks", Vector3f(0.10f, 0.10f, 0.10f));
+	setUniform(program, "Shininess", 128.0f);
+}
+
+// Parameters of the deformers, animated by tau
+void updateDeformers()
+{
+	for (size_t i = 0; i < deformers.size(); i++)
+	{
+		Vector4f& p = deformers[i].param;
+		switch (deformers[i].type)
+		{
+		case DEFORMER_TWIST:	p << tau, 0, 0, 0;					break;
+		case DEFORMER_WAVE:		p << 0.03f, frequency, 4 * tau, 0;	break;
+		case DEFORMER_BEND:		p << 1.5f, 0, 0, 0;					break;
+		case DEFORMER_TAPER:	p << 0.8f, 0, 0, 0;					break;
+		case DEFORMER_NOISE:	p << 0.04f, 6.0f, tau, 0;			break;
+		default:												break;
+		}
+	}
+}
+
+// Deformer added at the end of the stack, or removed from it
+void toggleDeformer(DeformerType type)
+{
+	DeformerStack::iterator it = deformers.begin();
+	while (it != deformers.end() && it->type != type) it++;
+
+	if (it != deformers.end())	deformers.erase(it);
+	else						deformers.push_back(Deformer(type));
+
+	cout << "Deformers: " << deformerSignature(deformers) << endl;
+}
+
+// Deformed plane with the program of the vertex shader or the tessellation shaders
+void drawPlane(bool adaptive, int pass = 0)
+{
+	GLuint program = adaptive ? pgTess.pg
+		: deformerProgram(deformers, "sv04_deformers.glsl", "sf02_Phong.glsl");
+	setSceneUniforms(program, pass);
+
+	if (adaptive)
+	{
+		// twisting value = ð ǹ
+		setUniform(program, "twisting", tau);
+
+		// Phase
+		setUniform(program, "phase", 4 * tau);
+
+		// Spatial frequency
+		setUniform(program, "F", frequency);
+	}
+	else
+	{
+		updateDeformers();
+		setDeformerParameters(program, deformers);
+	}
+
+	// Draw the mesh using the program and the vertex buffer object
+	glUseProgram(program);
+	if (adaptive)
+	{
+		// 4 corners for each of the n x n patches
+		setUniformi(program, "patchN", patchN);
+		setUniform(program, "Viewport", Vector2f(float(windowW), float(windowH)));
+		glPatchParameteri(GL_PATCH_VERTICES, 4);
+		glBindVertexArray(gridVAO);
+		glDrawArrays(GL_PATCHES, 0, 4 * patchN * patchN);
+		glBindVertexArray(0);
+	}
+	else if (proceduralGrid)
+	{
+		// A triangle strip of 2 (n + 1) vertices for each of the n rows
+		setUniformi(program, "gridN", gridN);
+		glBindVertexArray(gridVAO);
+		glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 2 * (gridN + 1), gridN);
+		glBindVertexArray(0);
+	}
+	else
+	{
+		updatePlane();
+		setUniformi(program, "gridN", 0);
+		drawVBO(plane.vao, plane.numTris);
+	}
+}
+
+// Buffers of the captured plane for the current resolution: the (n + 1)^2 vertices written
+// by the transform feedback, and the triangles of createGrid()
+void updateCapturedPlane()
+{
+	if (capturedN == gridN) return;
+
+	ArrayXXi	face;
+	MatrixXf	vertex;
+	MatrixXf	normal;
+	createGrid(gridN, vertex, normal, face);
+
+	if (captured.vao == 0)
+	{
+		glGenVertexArrays(1, &captured.vao);
+		glGenBuffers(1, &captured.indexId);
+		glGenBuffers(1, &captured.vertexId);
+	}
+	glBindVertexArray(captured.vao);
+
+	glBindBuffer(GL_ARRAY_BUFFER, captured.vertexId);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 6 * vertex.cols(), NULL, GL_DYNAMIC_COPY);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 6, 0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 6, (void*)(sizeof(GLfloat) * 3));
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, captured.indexId);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * face.size(), face.data(), GL_STATIC_DRAW);
+
+	glBindVertexArray(0);
+	isOK("updateCapturedPlane()", __FILE__, __LINE__);
+
+	captured.numTris = int(face.cols());
+	capturedN = gridN;
+}
+
+// The deformer stack over the vertices of the plane into the captured plane, in the object
+// coordinates with the identity matrices
+void capturePlane()
+{
+	updateCapturedPlane();
+	updateDeformers();
+
+	GLuint program = deformerProgram(deformers, "sv04_deformers.glsl", NULL);
+	Matrix4f I = Matrix4f::Identity();
+	setUniformMVP(program, I, I, I);
+	setDeformerParameters(program, deformers);
+	setUniformi(program, "gridN", gridN);
+	setUniformi(program, "gridVertices", 1);
+
+	glUseProgram(program);
+	glEnable(GL_RASTERIZER_DISCARD);
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, captured.vertexId);
+	glBindVertexArray(gridVAO);
+
+	glBeginTransformFeedback(GL_POINTS);
+	glDrawArrays(GL_POINTS, 0, (gridN + 1) * (gridN + 1));
+	glEndTransformFeedback();
+
+	glBindVertexArray(0);
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+	glDisable(GL_RASTERIZER_DISCARD);
+}
+
+void drawCapturedPlane(int pass)
+{
+	setSceneUniforms(pgPass.pg, pass);
+
+	glUseProgram(pgPass.pg);
+	glBindVertexArray(captured.vao);
+	glDrawElements(GL_TRIANGLES, 3 * captured.numTris, GL_UNSIGNED_INT, 0);
+	glBindVertexArray(0);
+}
+
+// The passes over the plane, deformed once by the capture or again in every pass. The
+// adaptive subdivision is not captured.
+void drawPasses(bool capturing, int passes)
+{
+	bool reuse = capturing && !tessellation;
+	if (reuse) capturePlane();
+
+	for (int pass = 0; pass < passes; pass++)
+	{
+		// The shading behind the overlays
+		if (pass == 0 && passes > 1)
+		{
+			glEnable(GL_POLYGON_OFFSET_FILL);
+			glPolygonOffset(1.0f, 1.0f);
+		}
+		if (pass == 1) glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+		if (pass == 2)
+		{
+			glPolygonMode(GL_FRONT_AND_BACK, GL_POINT);
+			glPointSize(3.0f);
+		}
+
+		if (reuse)	drawCapturedPlane(pass);
+		else		drawPlane(tessellation, pass);
+
+		glDisable(GL_POLYGON_OFFSET_FILL);
+		glPolygonMode(GL_FRONT_AND_BACK, wireframe ? GL_LINE : GL_FILL);
+	}
+}
+
+// GPU time of 1, 2 and 3 passes over the plane deformed again in every pass and deformed
+// once by the capture, over the frames drawn back to back
+void comparePasses()
+{
+	const int	numFrames = 60;
+
+	GLuint query;
+	glGenQueries(1, &query);
+
+	// No other GL_TIME_ELAPSED query may be active, e.g., the one of the frame.
+	suspendGPUTiming();
+
+	ViewMatrix = lookAt<float>(eye, center, up);
+
+	for (int passes = 1; passes <= 3; passes++)
+	{
+		double	ms[2] = { 0, 0 };
+		for (int m = 0; m < 2; m++)
+		{
+			for (int f = 0; f < numFrames; f++)
+			{
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+				glBeginQuery(GL_TIME_ELAPSED, query);
+				drawPasses(m == 1, passes);
+				glEndQuery(GL_TIME_ELAPSED);
+
+				GLuint64	ns = 0;
+				glGetQueryObjectui64v(query, GL_QUERY_RESULT, &ns);
+				ms[m] += ns * 1.0e-6 / numFrames;
+			}
+		}
+
+		cout << "Passes: " << passes << " over " << gridN << " x " << gridN << ", deformed in every pass "
+			<< ms[0] << " ms, captured once " << ms[1] << " ms on the GPU ("
+			<< 100.0 * ms[1] / max(ms[0], 1.0e-9) << "%)" << endl;
+	}
+
+	glDeleteQueries(1, &query);
+	resumeGPUTiming();
+}
+
+// Deformer stack on the CPU against the transform feedback of the vertex shader on the
+// 256 x 256 plane, and the throughput of the CPU in vertices per second
+void verifyDeformers()
+{
+	updateDeformers();
+
+	ArrayXXi	face;
+	MatrixXf	vertex, normal;
+	createGrid(256, vertex, normal, face);
+	int n = int(vertex.cols());
+
+	// Vertex shader of the stack with the outputs captured in the object coordinates
+	GLuint program = deformerProgram(deformers, "sv04_deformers.glsl", NULL);
+	setUniformi(program, "gridN", 0);
+	setUniformi(program, "gridVertices", 0);
+
+	Matrix4f I = Matrix4f::Identity();
+	setUniformMVP(program, I, I, I);
+	setDeformerParameters(program, deformers);
+
+	Geometry mesh;
+	createVBO(mesh.vao, mesh.indexId, mesh.vertexId, mesh.normalId);
+	uploadMesh2VBO(face, vertex, normal, mesh.vao, mesh.indexId, mesh.vertexId, mesh.normalId);
+
+	GLuint feedback;
+	glGenBuffers(1, &feedback);
+	glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, feedback);
+	glBufferData(GL_TRANSFORM_FEEDBACK_BUFFER, sizeof(GLfloat) * 6 * n, NULL, GL_STATIC_READ);
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, feedback);
+
+	glUseProgram(program);
+	glEnable(GL_RASTERIZER_DISCARD);
+	glBindVertexArray(mesh.vao);
+	glBeginTransformFeedback(GL_POINTS);
+	glDrawArrays(GL_POINTS, 0, n);
+	glEndTransformFeedback();
+	glBindVertexArray(0);
+	glDisable(GL_RASTERIZER_DISCARD);
+
+	vector<GLfloat>	gpu(6 * size_t(n));
+	glGetBufferSubData(GL_TRANSFORM_FEEDBACK_BUFFER, 0, sizeof(GLfloat) * gpu.size(), &gpu[0]);
+	isOK("verifyDeformers()", __FILE__, __LINE__);
+
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+	glDeleteBuffers(1, &feedback);
+	deleteVBO(mesh.vao, mesh.indexId, mesh.vertexId, mesh.normalId);
+
+	// Columns of x, y and z
+	MatrixXf	p0 = vertex.transpose(), n0 = normal.transpose();
+	MatrixXf	p = p0, m = n0;
+	deformPoints(deformers, n, &p(0, 0), &p(0, 1), &p(0, 2), &m(0, 0), &m(0, 1), &m(0, 2));
+
+	float	positionError = 0, normalError = 0;
+	for (int i = 0; i < n; i++)
+	{
+		Vector3f	gp(gpu[6 * i + 0], gpu[6 * i + 1], gpu[6 * i + 2]);
+		Vector3f	gn(gpu[6 * i + 3], gpu[6 * i + 4], gpu[6 * i + 5]);
+
+		positionError = max(positionError, (gp - Vector3f(p.row(i))).norm());
+		normalError = max(normalError, acos(min(gn.dot(Vector3f(m.row(i))), 1.0f)));
+	}
+
+	cout << "Deformers: " << deformerSignature(deformers) << " on " << n << " vertices, "
+		<< "CPU vs transform feedback: " << positionError << " in the positions, "
+		<< normalError * 180.0f / float(M_PI) << " degrees in the normals" << endl;
+
+	// Throughput from the undeformed points every time, on a thread and on all the cores
+	int numCores = max(int(thread::hardware_concurrency()), 1);
+	int numThreads[2] = { 1, numCores };
+	for (int t = 0; t < (numCores > 1 ? 2 : 1); t++)
+	{
+		const int	numRepeats = 20;
+
+		double seconds = 0;
+		for (int r = 0; r < numRepeats; r++)
+		{
+			p = p0;
+			m = n0;
+
+			double start = glfwGetTime();
+			deformPoints(deformers, n, &p(0, 0), &p(0, 1), &p(0, 2), &m(0, 0), &m(0, 1), &m(0, 2),
+				numThreads[t]);
+			seconds += glfwGetTime() - start;
+		}
+
+		cout << "Deformers: CPU " << (deformerSIMD() ? "AVX2" : "scalar") << " on " << numThreads[t]
+			<< " thread(s): " << n * numRepeats / seconds / 1.0e6 << " M vertices/s" << endl;
+	}
+}
+
+// Triangles and GPU time of the fixed 256 x 256 grid and the adaptive subdivision, over
+// the frames drawn back to back with the current deformation
+void compareTessellation()
+{
+	const int	numFrames = 60;
+
+	GLuint query[2];
+	glGenQueries(2, query);
+
+	// No other GL_TIME_ELAPSED query may be active, e.g., the one of the frame.
+	suspendGPUTiming();
+
+	int		savedGridN = gridN;
+	bool	savedProcedural = proceduralGrid;
+	gridN = 256;
+	proceduralGrid = true;
+
+	ViewMatrix = lookAt<float>(eye, center, up);
+
+	const char*	name[2] = { "fixed 256 x 256", "adaptive" };
+	GLuint64	triangles[2] = { 0, 0 };
+	double		ms[2] = { 0, 0 };
+	for (int m = 0; m < 2; m++)
+	{
+		for (int f = 0; f < numFrames; f++)
+		{
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			glBeginQuery(GL_PRIMITIVES_GENERATED, query[0]);
+			glBeginQuery(GL_TIME_ELAPSED, query[1]);
+			drawPlane(m == 1);
+			glEndQuery(GL_TIME_ELAPSED);
+			glEndQuery(GL_PRIMITIVES_GENERATED);
+
+			GLuint64	n = 0, ns = 0;
+			glGetQueryObjectui64v(query[0], GL_QUERY_RESULT, &n);
+			glGetQueryObjectui64v(query[1], GL_QUERY_RESULT, &ns);
+			triangles[m] = n;
+			ms[m] += ns * 1.0e-6 / numFrames;
+		}
+	}
+
+	gridN = savedGridN;
+	proceduralGrid = savedProcedural;
+	glDeleteQueries(2, query);
+	resumeGPUTiming();
+
+	for (int m = 0; m < 2; m++)
+		cout << "Tessellation: " << name[m] << ": " << triangles[m] << " triangles, "
+			<< ms[m] << " ms on the GPU" << endl;
+	cout << "Tessellation: " << 100.0 * triangles[1] / max(triangles[0], GLuint64(1))
+		<< "% of the triangles in " << 100.0 * ms[1] / max(ms[0], 1.0e-9) << "% of the time" << endl;
+}
+
 void render(GLFWwindow* window)
 {
 	// Antialiasing
@@ -251,38 +733,7 @@ void render(GLFWwindow* window)
 
 	if (example == 1)
 	{
-		// Modeling matrix
-		Affine3f T; T = Matrix3f(AngleAxisf(-float(M_PI) / 3.0f, Vector3f::UnitX()))
-			* Scaling(1.5f, 1.5f, 1.5f);
-		Matrix4f	ModelMatrix = T.matrix();
-
-		// Model, view, projection matrices
-		setUniformMVP(pgTwWa.pg, ModelMatrix, ViewMatrix, ProjectionMatrix);
-
-		// Light position 
-		Vector3f	l = ViewMatrix.block<3, 3>(0, 0) * light2 + ViewMatrix.block<3, 1>(0, 3);
-		setUniform(pgTwWa.pg, "LightPosition", l);
-
-		// Draw objects: only the bunny in this case
-		{
-			setUniform(pgTwWa.pg, "Ka", Vector3f(0.10f, 0.10f, 0.10f));
-			setUniform(pgTwWa.pg, "Kd", Vector3f(0.75f, 0.75f, 0.75f));
-			setUniform(pgTwWa.pg, "Ks", Vector3f(0.10f, 0.10f, 0.10f));
-			setUniform(pgTwWa.pg, "Shininess", 128.0f);
-
-			// twisting value = ð ǹ
-			setUniform(pgTwWa.pg, "twisting", tau);
-
-			// Phase
-			setUniform(pgTwWa.pg, "phase", 4 * tau);
-
-			// Spatial frequency
-			setUniform(pgTwWa.pg, "F", frequency);
-
-			// Draw the mesh using the program and the vertex buffer object
-			glUseProgram(pgTwWa.pg);
-			drawVBO(plane[level].vao, plane[level].numTris);
-		}
+		drawPasses(capture, numPasses);
 	}
 
 	// Check the status
@@ -310,15 +761,50 @@ keyboard(GLFWwindow* window, int key, int scancode, int action, int mods)
 		case GLFW_KEY_T:		example = (example + 1) % 2; break;
 
 			// Level
-		case GLFW_KEY_1: level = 0;		break;
-		case GLFW_KEY_2: level = 1;		break;
-		case GLFW_KEY_3: level = 2;		break;
-		case GLFW_KEY_4: level = 3;		break;
+		case GLFW_KEY_1: setGridResolution(32);		break;
+		case GLFW_KEY_2: setGridResolution(64);		break;
+		case GLFW_KEY_3: setGridResolution(128);	break;
+		case GLFW_KEY_4: setGridResolution(256);	break;
+
+			// Deformer stack
+		case GLFW_KEY_5: toggleDeformer(DEFORMER_TWIST);	break;
+		case GLFW_KEY_6: toggleDeformer(DEFORMER_WAVE);		break;
+		case GLFW_KEY_7: toggleDeformer(DEFORMER_BEND);		break;
+		case GLFW_KEY_8: toggleDeformer(DEFORMER_TAPER);	break;
+		case GLFW_KEY_9: toggleDeformer(DEFORMER_NOISE);	break;
+
+			// Resolution
+		case GLFW_KEY_LEFT:		setGridResolution(gridN / 2);	break;
+		case GLFW_KEY_RIGHT:	setGridResolution(gridN * 2);	break;
+
+			// Procedural grid or indexed VBO
+		case GLFW_KEY_G:	proceduralGrid = !proceduralGrid; setGridResolution(gridN); break;
 
 			// Spatial frequency in the wave deformer
 		case GLFW_KEY_UP:	frequency += 1;	break;
 		case GLFW_KEY_DOWN: frequency -= 1;	break;
 
+			// Adaptive subdivision
+		case GLFW_KEY_A:
+			tessellation = !tessellation;
+			cout << "Tessellation: " << (tessellation ? "adaptive" : "off") << endl;
+			break;
+		case GLFW_KEY_C:	compareTessellation(); break;
+
+			// Passes over the deformed plane
+		case GLFW_KEY_P:
+			numPasses = numPasses % 3 + 1;
+			cout << "Passes: " << numPasses << endl;
+			break;
+		case GLFW_KEY_F:
+			capture = !capture;
+			cout << "Capture: " << (capture ? "on" : "off") << endl;
+			break;
+		case GLFW_KEY_M:	comparePasses(); break;
+
+			// CPU deformers
+		case GLFW_KEY_V:	verifyDeformers(); break;
+
 			// Drawing in wireframe on/off
 		case GLFW_KEY_W:	wireframe = !wireframe; break;
 		}
@@ -0,0 +1,85 @@
+#version 400
+
+layout (vertices = 4) out;
+
+in vec3		planePosition[];
+out vec3	patchPosition[];
+
+uniform mat4	ModelViewProjectionMatrix;
+uniform vec2	Viewport;			// In pixels
+
+// Twisting
+uniform float	twisting = 0.0;
+
+// Waving
+uniform float	A = 0.03;
+uniform float	F = 40.0;
+
+// Subdivision
+uniform float	tolerance = 0.0005;			// Chordal error in the object coordinates
+uniform float	pixelsPerSegment = 4.0;		// Shortest segment on the screen
+uniform float	maxLevel = 64.0;			// Up to gl_MaxTessGenLevel
+
+// Total variation of the distance from the origin along the edge a-b
+float
+radialVariation(vec2 a, vec2 b)
+{
+	vec2	d = b - a;
+	float	t = clamp(-dot(a, d) / max(dot(d, d), 1.0e-20), 0.0, 1.0);
+	float	c = length(a + t * d);
+
+	return abs(length(a) - c) + abs(c - length(b));
+}
+
+// Length of the edge a-b on the screen in pixels
+float
+screenLength(vec3 a, vec3 b)
+{
+	vec4	pa = ModelViewProjectionMatrix * vec4(a, 1.0);
+	vec4	pb = ModelViewProjectionMatrix * vec4(b, 1.0);
+	if (pa.w <= 0.0 || pb.w <= 0.0) return pixelsPerSegment * maxLevel;
+
+	return length((pa.xy / pa.w - pb.xy / pb.w) * 0.5 * Viewport);
+}
+
+// Segments of the edge a-b: a sine of the amplitude A and the frequency F sampled every h
+// deviates from its chord by A (F h)^2 / 8, and a twisted edge at the radius r bends by
+// r (twisting h)^2 / 8 for the radial extent h. Both keep within the tolerance, and no
+// segment gets shorter than pixelsPerSegment on the screen.
+float
+edgeLevel(vec3 a, vec3 b)
+{
+	// The same arithmetic for the edge shared by the two patches to avoid the cracks
+	if (a.x > b.x || (a.x == b.x && a.y > b.y)) { vec3 t = a; a = b; b = t; }
+
+	float	variation = radialVariation(a.xy, b.xy);
+	float	r = max(length(a.xy), length(b.xy));
+
+	float	wave = F * variation * sqrt(A / (8.0 * tolerance));
+	float	twist = abs(twisting) * variation * sqrt(r / (8.0 * tolerance));
+
+	float	level = min(max(wave, twist), screenLength(a, b) / pixelsPerSegment);
+
+	return clamp(level, 1.0, maxLevel);
+}
+
+void
+main(void)
+{
+	patchPosition[gl_InvocationID] = planePosition[gl_InvocationID];
+
+	if (gl_InvocationID == 0)
+	{
+		vec3	p0 = planePosition[0], p1 = planePosition[1];
+		vec3	p2 = planePosition[2], p3 = planePosition[3];
+
+		// Edges at u = 0, v = 0, u = 1 and v = 1
+		gl_TessLevelOuter[0] = edgeLevel(p0, p3);
+		gl_TessLevelOuter[1] = edgeLevel(p0, p1);
+		gl_TessLevelOuter[2] = edgeLevel(p1, p2);
+		gl_TessLevelOuter[3] = edgeLevel(p3, p2);
+
+		gl_TessLevelInner[0] = max(gl_TessLevelOuter[1], gl_TessLevelOuter[3]);
+		gl_TessLevelInner[1] = max(gl_TessLevelOuter[0], gl_TessLevelOuter[2]);
+	}
+}
@@ -1,8 +1,8 @@
-
 #version 400
 
-layout (location = 0) in vec3 VertexPosition;
-layout (location = 1) in vec3 VertexNormal;
+layout (quads, fractional_even_spacing, ccw) in;
+
+in vec3		patchPosition[];
 
 out vec3	position;
 out vec3	normal;
@@ -20,29 +20,30 @@ uniform float	A = 0.03;
 uniform float	F = 40.0;
 uniform float	phase = 0.0;
 
-
-
 void
 main(void)
 {
-	// ----- Wave   // z ٲ x,y ״
-	// Vertex position
+	// Point of the patch on the plane
+	float	u = gl_TessCoord.x, v = gl_TessCoord.y;
+	vec3	VertexPosition = mix(mix(patchPosition[0], patchPosition[1], u),
+		mix(patchPosition[3], patchPosition[2], u), v);
+	vec3	VertexNormal = vec3(0.0, 0.0, 1.0);
+
+	// ----- Wave
 	float l = length(VertexPosition.xy);
 	float z = VertexPosition.z + A*sin(F*l + phase);
 
-	// ---- Twist 	// x,y ٲ z  ״
-	// New position due to twisting
+	// ---- Twist
 	// The twisting angle is proportional to the distance from the origin.
-	float angle = twisting * length(VertexPosition.xy); // 2 ͸ .
+	float angle = twisting * l;
 	float cosLength = cos(angle);
 	float sinLength = sin(angle);
 	float x = cosLength * VertexPosition.x - sinLength * VertexPosition.y;
 	float y = sinLength * VertexPosition.x + cosLength * VertexPosition.y;
 	vec4	newVertexPosition = vec4(x,y,z,1.0);
 
-
 	// Jacobian of the wave deformation
-	float eps = 0.0001; // ԽǷ, ԽǷ 0 ָ  . Normal vector  .
+	float eps = 0.0001;
 	mat3  Jt;	//Jacobian matrix transpose. Note that Jt[column][row] in GLSL.
 
 	Jt[0][0] = cosLength; 	Jt[0][1] = -sinLength; 	Jt[0][2] = 0;
@@ -53,7 +54,6 @@ main(void)
 
 	// Inverse transpose of the Jacobian matrix (already transposed)
 	vec3	newVertexNormal = inverse(Jt)*VertexNormal;
-	
 
 	// Position for the rasterization
 	gl_Position = ModelViewProjectionMatrix*newVertexPosition;
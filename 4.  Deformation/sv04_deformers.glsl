@@ -0,0 +1,198 @@
+#version 400
+
+// Stack of deformers specialized at the compile time: the program of a stack gets
+//   #define MAX_DEFORMERS 8
+//   #define NUM_DEFORMERS n
+//   #define DEFORMER_STACK(p, J) deformTwist(0, p, J); deformWave(1, p, J); ...
+// so that only the deformers of the stack are compiled, with the constant indices of their
+// parameters. Every deformer moves the point p and multiplies its Jacobian to the left of J,
+// and the normal is transformed by the inverse transpose of the whole Jacobian.
+#ifndef MAX_DEFORMERS
+#define MAX_DEFORMERS 8
+#endif
+
+#ifndef DEFORMER_STACK
+#define DEFORMER_STACK(p, J)
+#endif
+
+layout (location = 0) in vec3 VertexPositionIn;
+layout (location = 1) in vec3 VertexNormalIn;
+
+out vec3	position;
+out vec3	normal;
+
+// Transformation matrices : GLSL employ column-major matrices.
+uniform mat4	ModelViewProjectionMatrix;
+uniform mat4	ModelViewMatrix;
+uniform mat3	NormalMatrix;
+
+// Parameters of the deformers in the order of the stack
+uniform vec4	deformerParam[MAX_DEFORMERS];
+
+// Procedural grid of gridN x gridN quads on [-0.5, 0.5]^2, drawn as an instanced triangle
+// strip a row without any vertex arrays. 0 for the vertex arrays.
+uniform int		gridN = 0;
+
+// The (gridN + 1)^2 vertices of the grid row by row, as points for the transform feedback
+uniform bool	gridVertices = false;
+
+// Twist about the z axis by the angle of x times the distance from the axis
+void
+deformTwist(int i, inout vec3 p, inout mat3 J)
+{
+	float	r = length(p.xy);
+	float	angle = deformerParam[i].x * r;
+	float	c = cos(angle), s = sin(angle);
+
+	vec3	q = vec3(c * p.x - s * p.y, s * p.x + c * p.y, p.z);
+
+	// Rotation, and the derivative of the rotation along the gradient of the angle
+	vec2	g = (r > 0.0) ? deformerParam[i].x * p.xy / r : vec2(0.0);
+	vec3	dq = vec3(-q.y, q.x, 0.0);
+
+	mat3	Jk = mat3(1.0);		// Jk[column][row]
+	Jk[0] = vec3(c, s, 0.0) + dq * g.x;
+	Jk[1] = vec3(-s, c, 0.0) + dq * g.y;
+
+	p = q;
+	J = Jk * J;
+}
+
+// Radial wave of the amplitude x, the spatial frequency y and the phase z along z
+void
+deformWave(int i, inout vec3 p, inout mat3 J)
+{
+	float	A = deformerParam[i].x, F = deformerParam[i].y, phase = deformerParam[i].z;
+	float	r = length(p.xy);
+
+	vec2	g = (r > 0.0) ? A * F * cos(F * r + phase) * p.xy / r : vec2(0.0);
+
+	mat3	Jk = mat3(1.0);
+	Jk[0].z = g.x;
+	Jk[1].z = g.y;
+
+	p.z += A * sin(F * r + phase);
+	J = Jk * J;
+}
+
+// Bend along x about an axis parallel to y at the distance 1/x, i.e., of the curvature x
+void
+deformBend(int i, inout vec3 p, inout mat3 J)
+{
+	float	k = deformerParam[i].x;
+	float	angle = k * p.x;
+	float	c = cos(angle), s = sin(angle);
+	bool	straight = abs(k) < 1.0e-6;
+
+	mat3	Jk = mat3(1.0);
+	Jk[0] = vec3((1.0 - k * p.z) * c, 0.0, (1.0 - k * p.z) * s);
+	Jk[2] = vec3(-s, 0.0, c);
+
+	p = vec3((straight ? p.x : s / k) - p.z * s, p.y, (straight ? 0.0 : (1.0 - c) / k) + p.z * c);
+	J = Jk * J;
+}
+
+// Scaling of x and z by 1 + x y along y
+void
+deformTaper(int i, inout vec3 p, inout mat3 J)
+{
+	float	t = deformerParam[i].x;
+	float	scale = 1.0 + t * p.y;
+
+	mat3	Jk = mat3(scale);
+	Jk[1] = vec3(t * p.x, 1.0, t * p.z);
+
+	p.xz *= scale;
+	J = Jk * J;
+}
+
+// PCG hash of Jarzynski and Olano, the same integers as hashPoint() of deformer.cpp
+uint
+pcg(uint v)
+{
+	uint	state = v * 747796405u + 2891336453u;
+	uint	word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+	return (word >> 22u) ^ word;
+}
+
+// Hash of the lattice cell p in [0, 1), exact in float
+float
+hash(vec2 p)
+{
+	uvec2	q = uvec2(ivec2(p));
+	return float(pcg(q.x + pcg(q.y)) >> 8u) * (1.0 / 16777216.0);
+}
+
+// Value noise with its gradient in yz, from the quintic interpolation of the hashed corners
+
+vec3
+valueNoise(vec2 x)
+{
+	vec2	i = floor(x);
+	vec2	f = fract(x);
+
+	vec2	u = f * f * f * (f * (f * 6.0 - 15.0) + 10.0);
+	vec2	du = 30.0 * f * f * (f * (f - 2.0) + 1.0);
+
+	float	a = hash(i);
+	float	b = hash(i + vec2(1.0, 0.0));
+	float	c = hash(i + vec2(0.0, 1.0));
+	float	d = hash(i + vec2(1.0, 1.0));
+
+	float	k1 = b - a, k2 = c - a, k4 = a - b - c + d;
+
+	return vec3(a + k1 * u.x + k2 * u.y + k4 * u.x * u.y, du * (vec2(k1, k2) + k4 * u.yx));
+}
+
+// Displacement along z of the amplitude x, the spatial frequency y and the offset zw
+void
+deformNoise(int i, inout vec3 p, inout mat3 J)
+{
+	float	a = deformerParam[i].x, f = deformerParam[i].y;
+	vec3	n = valueNoise(f * p.xy + deformerParam[i].zw);
+
+	mat3	Jk = mat3(1.0);
+	Jk[0].z = 2.0 * a * f * n.y;
+	Jk[1].z = 2.0 * a * f * n.z;
+
+	p.z += a * (2.0 * n.x - 1.0);
+	J = Jk * J;
+}
+
+void
+main(void)
+{
+	vec3	VertexPosition = VertexPositionIn;
+	vec3	VertexNormal = VertexNormalIn;
+	if (gridN > 0)
+	{
+		// Top and bottom of the column by turns in the row of the instance
+		int	column = gl_VertexID >> 1;
+		int	row = gl_InstanceID + 1 - (gl_VertexID & 1);
+		if (gridVertices)
+		{
+			column = gl_VertexID % (gridN + 1);
+			row = gl_VertexID / (gridN + 1);
+		}
+
+		VertexPosition = vec3(vec2(column, row) / float(gridN) - 0.5, 0.0);
+		VertexNormal = vec3(0.0, 0.0, 1.0);
+	}
+
+	// Deformers of the stack with their Jacobians chained
+	vec3	p = VertexPosition;
+	mat3	J = mat3(1.0);
+	DEFORMER_STACK(p, J)
+
+	vec4	newVertexPosition = vec4(p, 1.0);
+
+	// Inverse transpose of the Jacobian matrix
+	vec3	newVertexNormal = transpose(inverse(J)) * VertexNormal;
+
+	// Position for the rasterization
+	gl_Position = ModelViewProjectionMatrix*newVertexPosition;
+
+	// Position and normal in the view coordinates system for the fragment shader
+	position = vec3(ModelViewMatrix * newVertexPosition);
+	normal = normalize(NormalMatrix* newVertexNormal);
+}
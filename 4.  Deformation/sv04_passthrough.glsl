@@ -0,0 +1,27 @@
+#version 400
+
+// Deformed positions and normals in the object coordinates, e.g., captured by the transform
+// feedback of sv04_deformers.glsl
+layout (location = 0) in vec3 VertexPosition;
+layout (location = 1) in vec3 VertexNormal;
+
+out vec3	position;
+out vec3	normal;
+
+// Transformation matrices : GLSL employ column-major matrices.
+uniform mat4	ModelViewProjectionMatrix;
+uniform mat4	ModelViewMatrix;
+uniform mat3	NormalMatrix;
+
+void
+main(void)
+{
+	vec4	p = vec4(VertexPosition, 1.0);
+
+	// Position for the rasterization
+	gl_Position = ModelViewProjectionMatrix * p;
+
+	// Position and normal in the view coordinates system for the fragment shader
+	position = vec3(ModelViewMatrix * p);
+	normal = normalize(NormalMatrix * VertexNormal);
+}
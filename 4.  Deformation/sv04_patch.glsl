@@ -0,0 +1,19 @@
+#version 400
+
+// Corners of the quad patches of a patchN x patchN grid on [-0.5, 0.5]^2, 4 vertices a patch
+// in the order (0,0), (1,0), (1,1), (0,1) without any vertex arrays
+uniform int		patchN = 16;
+
+out vec3	planePosition;
+
+void
+main(void)
+{
+	int	quad = gl_VertexID >> 2;
+	int	corner = gl_VertexID & 3;
+
+	int	column = quad % patchN + ((corner == 1 || corner == 2) ? 1 : 0);
+	int	row = quad / patchN + (corner >> 1);
+
+	planePosition = vec3(vec2(column, row) / float(patchN) - 0.5, 0.0);
+}
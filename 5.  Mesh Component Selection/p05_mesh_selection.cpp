@@ -122,6 +122,7 @@ int main(int argc, char* argv[])
 	float elapsed = 0;
 	while (!glfwWindowShouldClose(window))
 	{
+		beginTiming(TIMING_UPDATE);
 		glfwPollEvents();	// Evenets
 
 		// Time passed during a single loop
@@ -131,7 +132,9 @@ int main(int argc, char* argv[])
 
 		// Time passed after the previous frame
 		elapsed += delta;
+		endTiming(TIMING_UPDATE);
 
+		beginTiming(TIMING_SIMULATE);
 		// Dela with the current frame
 		if (elapsed > timeStep)
 		{
@@ -139,9 +142,12 @@ int main(int argc, char* argv[])
 
 			elapsed = 0; // Rest the elapsed time;
 		}
+		endTiming(TIMING_SIMULATE);
 
+		beginTiming(TIMING_RENDER);
 		render(window, false);
-		glfwSwapBuffers(window);
+		endTiming(TIMING_RENDER);
+		swapBuffers(window);
 	}
 
 	glfwDestroyWindow(window);
@@ -1,5 +1,7 @@
 #include "glSetup.h"
 #include "mesh.h"
+#include "rotation.h"
+#include "rotationDrift.h"
 
 #include <Eigen/Dense>
 using namespace Eigen;
@@ -12,6 +14,8 @@ using namespace std;
 #endif
 
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
 
 void init(const char* filename);
 void setupLight();
@@ -52,9 +56,30 @@ int main(int argc, char* argv[])
 
 	// Filename for deformable body configuration
 	const char* filename;
-	if (argc >= 2) filename = argv[1];
+	if (argc >= 2 && argv[1][0] != '-') filename = argv[1];
 	else           filename = defaultMeshFileName;
 
+	// Drift of the incremental rotations without a window:
+	// --drift-benchmark updates [--drift-samples n] [--drift-csv file]
+	long long	driftUpdates = 0;
+	int			driftSamples = 1000;
+	const char*	driftCSV = NULL;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--drift-benchmark") == 0 && i + 1 < argc)	driftUpdates = atoll(argv[++i]);
+		else if (strcmp(argv[i], "--drift-samples") == 0 && i + 1 < argc)	driftSamples = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--drift-csv") == 0 && i + 1 < argc)		driftCSV = argv[++i];
+	}
+	if (driftUpdates > 0)
+	{
+		vector<DriftResult>	result;
+		runDriftBenchmark(driftUpdates, driftSamples, result);
+		printDriftSummary(result);
+
+		if (driftCSV && !writeDriftCSV(driftCSV, result)) return -1;
+		return 0;
+	}
+
 	// Orthographic viewing
 	perspectiveView = false;
 
@@ -85,11 +110,17 @@ int main(int argc, char* argv[])
 	// Main loop
 	while (!glfwWindowShouldClose(window))
 	{
+		beginTiming(TIMING_SIMULATE);
 		if (!pause) update();
+		endTiming(TIMING_SIMULATE);
 
+		beginTiming(TIMING_RENDER);
 		render(window);			 // Draw one frame
-		glfwSwapBuffers(window); // Swap buffers
+		endTiming(TIMING_RENDER);
+		swapBuffers(window); // Swap buffers
+		beginTiming(TIMING_UPDATE);
 		glfwPollEvents();		 // Events
+		endTiming(TIMING_UPDATE);
 	}
 
 	// Terminate the glfw system
@@ -144,6 +175,7 @@ void init(const char* filename)
 	cout << "Keyboard Input: i for basic/incremental rotation" << endl;
 	cout << "Keyboard Input: a for acceleration in incremental rotation" << endl;
 	cout << "Keyboard Input: x for axes on/off" << endl;
+	cout << "Keyboard Input: b for the rotation benchmark" << endl;
 }
 
 void basicRotation()
@@ -158,11 +190,8 @@ void basicRotation()
 		AngleAxisf aa(angleInc * frame, axis); // axis .  Ӹ /1200, 2400Ӹ ѹ , ȸ ٲ.
 		Matrix3f   R(aa);
 
-		for (int i = 0; i < vertexO.cols(); i++)
-		{
-			vertexR.col(i) = R * vertexO.col(i); // Vertex position
-			normalR.col(i) = R * normalO.col(i); // Normal vector
-		}
+		rotateVertices(R, vertexO, vertexR); // Vertex position
+		rotateVertices(R, normalO, normalR); // Normal vector
 	}
 
 	// Quaternion - (3) 귮 ʹϾ  . Roation ȸŰ°  ȿ.
@@ -171,21 +200,9 @@ void basicRotation()
 		q.w() = cos(angleInc * frame / 2.0f);
 		q.vec() = axis * sin(angleInc * frame / 2.0f);
 
-		Quaternionf P; P.w() = 0;
-		Quaternionf P_new;
-
-		for (int i = 0; i < vertexO.cols(); i++)
-		{
-			// Vertexx position
-			P.vec() = vertexO.col(i);
-			P_new = q * P * q.conjugate(); // q.conjugate() = q.inverse() Unit̶ .
-			vertexQ.col(i) = P_new.vec();
-
-			// Normal vector
-			P.vec() = normalO.col(i);
-			P_new = q * P * q.inverse();
-			normalQ.col(i) = P_new.vec();
-		}
+		// Converted into a matrix once instead of q P q* for every vertex
+		rotateVertices(q, vertexO, vertexQ); // Vertex position
+		rotateVertices(q, normalO, normalQ); // Normal vector
 	}
 
 	// Transformation - (1)
@@ -281,6 +298,54 @@ void incrementalRotation()
 	}
 }
 
+// Vertices a second of the rotations of n vertices tiled from the mesh: the matrix and the
+// quaternion sandwich a vertex at a time, and the batches on a thread and on all the cores
+void benchmarkRotation(int n = 1 << 20)
+{
+	const int	runs = 10;
+
+	MatrixXf	in(3, n), out(3, n);
+	for (int i = 0; i < n; i++) in.col(i) = vertexO.col(i % vertexO.cols());
+
+	AngleAxisf	aa(0.7f, Vector3f(1, 2, 3).normalized());
+	Matrix3f	R(aa);
+	Quaternionf	q(aa);
+
+	cout << endl << "Rotation: " << n << " vertices, " << (rotationSIMD() ? "AVX2" : "no SIMD") << endl;
+
+	double start = glfwGetTime();
+	for (int r = 0; r < runs; r++)
+		for (int i = 0; i < n; i++) out.col(i) = R * in.col(i);
+	double seconds = (glfwGetTime() - start) / runs;
+	cout << "  Matrix per vertex: " << n / seconds * 1.0e-6 << " M vertices/s" << endl;
+
+	Quaternionf P; P.w() = 0;
+	start = glfwGetTime();
+	for (int r = 0; r < runs; r++)
+	{
+		for (int i = 0; i < n; i++)
+		{
+			P.vec() = in.col(i);
+			out.col(i) = (q * P * q.conjugate()).vec();
+		}
+	}
+	seconds = (glfwGetTime() - start) / runs;
+	cout << "  Quaternion per vertex: " << n / seconds * 1.0e-6 << " M vertices/s" << endl;
+
+	for (int path = 0; path < NUM_ROTATION_PATHS; path++)
+	{
+		for (int t = 1; t >= 0; t--)
+		{
+			start = glfwGetTime();
+			for (int r = 0; r < runs; r++) rotateVertices(q, in, out, RotationPath(path), t);
+			seconds = (glfwGetTime() - start) / runs;
+
+			cout << "  Batched " << rotationPathName[path] << " on " << (t ? "1 thread" : "all the cores")
+				<< ": " << n / seconds * 1.0e-6 << " M vertices/s" << endl;
+		}
+	}
+}
+
 void update()
 {
 	if (incremental) incrementalRotation();
@@ -405,6 +470,9 @@ void keyboard(GLFWwindow* window, int key, int scancode, int action, int mods)
 			// Axes on/off
 		case GLFW_KEY_X: axes = !axes; break;
 
+			// Benchmark
+		case GLFW_KEY_B: benchmarkRotation(); break;
+
 			//Play on/off
 		case GLFW_KEY_SPACE: pause = !pause; break;
 		}
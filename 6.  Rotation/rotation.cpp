@@ -0,0 +1,147 @@
+#include "rotation.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <vector>
+using namespace std;
+
+#ifdef __AVX2__
+#define ROTATION_AVX2
+#include <immintrin.h>
+#endif
+
+const char*	rotationPathName[NUM_ROTATION_PATHS] = { "GEMM", "SIMD" };
+
+static const int	GRAIN = 16384;	// Minimum vertices of a thread
+
+// f(begin, end) over the ranges of [0, n) on the threads, in multiples of 8 but the last
+static void
+parallelRanges(int n, int numThreads, const function<void(int, int)>& f)
+{
+	if (numThreads <= 0) numThreads = max(int(thread::hardware_concurrency()), 1);
+	numThreads = max(min(numThreads, (n + GRAIN - 1) / GRAIN), 1);
+
+	vector<thread>	workers;
+	for (int i = 1; i < numThreads; i++)
+	{
+		int	begin = int(int64_t(n) * i / numThreads) & ~7;
+		int	end = (i + 1 < numThreads) ? int(int64_t(n) * (i + 1) / numThreads) & ~7 : n;
+		workers.push_back(thread(f, begin, end));
+	}
+
+	f(0, (numThreads > 1) ? int(int64_t(n) / numThreads) & ~7 : n);
+
+	for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+}
+
+// Columns [begin, end) one at a time
+static void
+rotateScalar(const Matrix3f& R, const float* in, float* out, int begin, int end)
+{
+	for (int i = begin; i < end; i++)
+	{
+		const float*	p = in + 3 * i;
+		float*			q = out + 3 * i;
+		for (int r = 0; r < 3; r++) q[r] = R(r, 0) * p[0] + R(r, 1) * p[1] + R(r, 2) * p[2];
+	}
+}
+
+#ifdef ROTATION_AVX2
+// 8 interleaved vertices [x0 y0 z0 x1 ... z7] into x, y and z, and back. The 128-bit halves
+// hold the vertices 0-3 and 4-7, so that the in-lane shuffles do all the work.
+static inline void
+loadXYZ(const float* p, __m256& x, __m256& y, __m256& z)
+{
+	__m256	m03 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p)), _mm_loadu_ps(p + 12), 1);
+	__m256	m14 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p + 4)), _mm_loadu_ps(p + 16), 1);
+	__m256	m25 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p + 8)), _mm_loadu_ps(p + 20), 1);
+
+	__m256	xy = _mm256_shuffle_ps(m14, m25, _MM_SHUFFLE(2, 1, 3, 2));
+	__m256	yz = _mm256_shuffle_ps(m03, m14, _MM_SHUFFLE(1, 0, 2, 1));
+
+	x = _mm256_shuffle_ps(m03, xy, _MM_SHUFFLE(2, 0, 3, 0));
+	y = _mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+	z = _mm256_shuffle_ps(yz, m25, _MM_SHUFFLE(3, 0, 3, 1));
+}
+
+static inline void
+storeXYZ(float* p, __m256 x, __m256 y, __m256 z)
+{
+	__m256	xy = _mm256_shuffle_ps(x, y, _MM_SHUFFLE(2, 0, 2, 0));
+	__m256	yz = _mm256_shuffle_ps(y, z, _MM_SHUFFLE(3, 1, 3, 1));
+	__m256	zx = _mm256_shuffle_ps(z, x, _MM_SHUFFLE(3, 1, 2, 0));
+
+	__m256	m03 = _mm256_shuffle_ps(xy, zx, _MM_SHUFFLE(2, 0, 2, 0));
+	__m256	m14 = _mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+	__m256	m25 = _mm256_shuffle_ps(zx, yz, _MM_SHUFFLE(3, 1, 3, 1));
+
+	_mm_storeu_ps(p, _mm256_castps256_ps128(m03));
+	_mm_storeu_ps(p + 4, _mm256_castps256_ps128(m14));
+	_mm_storeu_ps(p + 8, _mm256_castps256_ps128(m25));
+	_mm_storeu_ps(p + 12, _mm256_extractf128_ps(m03, 1));
+	_mm_storeu_ps(p + 16, _mm256_extractf128_ps(m14, 1));
+	_mm_storeu_ps(p + 20, _mm256_extractf128_ps(m25, 1));
+}
+#endif
+
+static void
+rotateSIMD(const Matrix3f& R, const float* in, float* out, int begin, int end)
+{
+	int	i = begin;
+#ifdef ROTATION_AVX2
+	__m256	m[9];
+	for (int r = 0; r < 3; r++)
+		for (int c = 0; c < 3; c++) m[3 * r + c] = _mm256_set1_ps(R(r, c));
+
+	for (; i + 8 <= end; i += 8)
+	{
+		__m256	x, y, z;
+		loadXYZ(in + 3 * i, x, y, z);
+
+		__m256	u = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m[0], x), _mm256_mul_ps(m[1], y)), _mm256_mul_ps(m[2], z));
+		__m256	v = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m[3], x), _mm256_mul_ps(m[4], y)), _mm256_mul_ps(m[5], z));
+		__m256	w = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m[6], x), _mm256_mul_ps(m[7], y)), _mm256_mul_ps(m[8], z));
+
+		storeXYZ(out + 3 * i, u, v, w);
+	}
+#endif
+	rotateScalar(R, in, out, i, end);
+}
+
+void
+rotateVertices(const Matrix3f& R, const MatrixXf& in, MatrixXf& out, RotationPath path, int numThreads)
+{
+	int	n = int(in.cols());
+	out.resize(3, n);
+
+	parallelRanges(n, numThreads, [&](int begin, int end)
+	{
+		if (path == ROTATION_GEMM)	out.middleCols(begin, end - begin).noalias() = R * in.middleCols(begin, end - begin);
+		else						rotateSIMD(R, in.data(), out.data(), begin, end);
+	});
+}
+
+void
+rotateVertices(const Quaternionf& q, const MatrixXf& in, MatrixXf& out, RotationPath path, int numThreads)
+{
+	rotateVertices(q.normalized().toRotationMatrix(), in, out, path, numThreads);
+}
+
+void
+rotateVertices(const AngleAxisf& aa, const MatrixXf& in, MatrixXf& out, RotationPath path, int numThreads)
+{
+	rotateVertices(aa.toRotationMatrix(), in, out, path, numThreads);
+}
+
+bool
+rotationSIMD()
+{
+#ifdef ROTATION_AVX2
+	return true;
+#else
+	return false;
+#endif
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#ifndef __ROTATION_H_
+#define __ROTATION_H_
+
+#include <Eigen/Dense>
+using namespace Eigen;
+
+// Batch rotation of 3 x N vertex arrays
+//
+// A rotation given as a quaternion, a matrix or an angle-axis is converted into a 3x3 matrix
+// once, and the whole array goes through it in blocks of columns on the threads, instead of
+// a quaternion sandwich q P q* of two full products per vertex. Normals are rotated by the
+// same matrix, as the inverse transpose of a rotation is itself.
+//
+// ROTATION_GEMM multiplies the blocks by Eigen's matrix product. ROTATION_SIMD transposes 8
+// interleaved vertices into x, y and z registers, rotates them as SoA with 9 multiplies and
+// 6 adds, and transposes them back, when built with AVX2, e.g., -mavx2 or /arch:AVX2, and
+// falls back to the scalar loop otherwise.
+
+enum RotationPath
+{
+	ROTATION_GEMM = 0,
+	ROTATION_SIMD,
+	NUM_ROTATION_PATHS
+};
+
+extern const char*	rotationPathName[NUM_ROTATION_PATHS];
+
+// out = R in, resized to the size of in. out must not be in.
+void	rotateVertices(const Matrix3f& R, const MatrixXf& in, MatrixXf& out,
+	RotationPath path = ROTATION_SIMD, int numThreads = 0);		// 0 for all the cores
+
+void	rotateVertices(const Quaternionf& q, const MatrixXf& in, MatrixXf& out,
+	RotationPath path = ROTATION_SIMD, int numThreads = 0);		// Normalized first
+void	rotateVertices(const AngleAxisf& aa, const MatrixXf& in, MatrixXf& out,
+	RotationPath path = ROTATION_SIMD, int numThreads = 0);
+
+bool	rotationSIMD();		// Built with AVX2
+
+#endif	// __ROTATION_H_
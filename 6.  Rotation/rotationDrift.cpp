@@ -0,0 +1,219 @@
+#include "rotationDrift.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+using namespace std;
+
+const char*	driftRepresentationName[NUM_DRIFT_REPRESENTATIONS] =
+{
+	"matrix", "matrix_determinant", "matrix_gram_schmidt", "matrix_polar",
+	"quaternion", "quaternion_normalized"
+};
+
+void
+orthonormalizeGramSchmidt(Matrix3f& R)
+{
+	Vector3f	x = R.col(0).normalized();
+	Vector3f	y = (R.col(1) - x * x.dot(R.col(1))).normalized();
+
+	R.col(0) = x;
+	R.col(1) = y;
+	R.col(2) = x.cross(y);
+}
+
+void
+orthonormalizePolar(Matrix3f& R)
+{
+	for (int i = 0; i < 8; i++)
+	{
+		Matrix3f	next = 0.5f * (R + R.inverse().transpose());
+		float		change = (next - R).squaredNorm();
+
+		R = next;
+		if (change < 1.0e-12f) break;
+	}
+}
+
+// Errors of the matrix of a representation after the updates
+static void
+measure(const Matrix3f& M, const Matrix3d& reference, long long update, DriftSample& s)
+{
+	Matrix3d	A = M.cast<double>();
+
+	s.update = update;
+	s.orthogonality = max(max(fabs(A.col(0).dot(A.col(1))), fabs(A.col(1).dot(A.col(2)))),
+		fabs(A.col(2).dot(A.col(0))));
+	s.unitNorm = (A.colwise().norm().array() - 1).abs().maxCoeff();
+	s.determinant = fabs(A.determinant() - 1);
+	s.deviation = (A - reference).norm();
+}
+
+static double
+seconds()
+{
+	return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// The updates up to every sample, a segment of the same increment at a time, so that the
+// inner loops are only the updates and the normalizations
+static void
+runRepresentation(DriftRepresentation rep, int axisPeriod, const vector<Matrix3f>& increment,
+	const vector<Quaternionf>& qIncrement, const vector<long long>& sampleAt,
+	const vector<Matrix3d>& reference, DriftResult& result)
+{
+	Matrix3f	R = Matrix3f::Identity();
+	Quaternionf	q = Quaternionf::Identity();
+
+	result.representation = rep;
+	result.sample.resize(sampleAt.size());
+
+	double		start = seconds();
+	long long	u = 0;
+	for (size_t k = 0; k < sampleAt.size(); k++)
+	{
+		while (u < sampleAt[k])
+		{
+			size_t		s = size_t(u / axisPeriod);
+			long long	end = min(sampleAt[k], (long long)(s + 1) * axisPeriod);
+
+			const Matrix3f&		M = increment[s];
+			const Quaternionf&	p = qIncrement[s];
+			switch (rep)
+			{
+			case DRIFT_MATRIX:
+				for (; u < end; u++) R = M * R;
+				break;
+			case DRIFT_MATRIX_DETERMINANT:
+				for (; u < end; u++)
+				{
+					R = M * R;
+					R /= pow(fabs(R.determinant()), 1.0f / 3.0f);
+				}
+				break;
+			case DRIFT_MATRIX_GRAM_SCHMIDT:
+				for (; u < end; u++)
+				{
+					R = M * R;
+					orthonormalizeGramSchmidt(R);
+				}
+				break;
+			case DRIFT_MATRIX_POLAR:
+				for (; u < end; u++)
+				{
+					R = M * R;
+					orthonormalizePolar(R);
+				}
+				break;
+			case DRIFT_QUATERNION:
+				for (; u < end; u++) q = p * q;
+				break;
+			default:
+				for (; u < end; u++)
+				{
+					q = p * q;
+					q.normalize();
+				}
+				break;
+			}
+		}
+
+		measure((rep >= DRIFT_QUATERNION) ? q.toRotationMatrix() : R, reference[k], u, result.sample[k]);
+	}
+
+	result.nsPerUpdate = (seconds() - start) * 1.0e9 / max(u, 1LL);
+}
+
+void
+runDriftBenchmark(long long numUpdates, int numSamples, vector<DriftResult>& result,
+	float angle, int axisPeriod)
+{
+	numSamples = int(max(min((long long)numSamples, numUpdates), 1LL));
+
+	// The same axes for all the representations
+	mt19937								random(2400);
+	uniform_real_distribution<float>	uniform(-1, 1);
+
+	size_t				numSegments = size_t((numUpdates + axisPeriod - 1) / axisPeriod);
+	vector<Matrix3f>	increment(numSegments);
+	vector<Quaternionf>	qIncrement(numSegments);
+	vector<Vector3d>	axis(numSegments);
+	for (size_t s = 0; s < numSegments; s++)
+	{
+		Vector3f	a;
+		do a = Vector3f(uniform(random), uniform(random), uniform(random));
+		while (a.squaredNorm() < 1.0e-4f);
+		a.normalize();
+
+		increment[s] = Matrix3f(AngleAxisf(angle, a));
+		qIncrement[s] = Quaternionf(AngleAxisf(angle, a));
+		axis[s] = a.cast<double>();
+	}
+
+	vector<long long>	sampleAt(numSamples);
+	for (int k = 0; k < numSamples; k++) sampleAt[k] = numUpdates * (k + 1) / numSamples;
+
+	// Reference of the same rotations in double
+	vector<Matrix3d>	reference(numSamples);
+	Quaterniond			r = Quaterniond::Identity();
+	long long			u = 0;
+	for (int k = 0; k < numSamples; k++)
+	{
+		for (; u < sampleAt[k]; u++)
+		{
+			r = Quaterniond(AngleAxisd(angle, axis[size_t(u / axisPeriod)])) * r;
+			r.normalize();
+		}
+		reference[k] = r.toRotationMatrix();
+	}
+
+	result.resize(NUM_DRIFT_REPRESENTATIONS);
+	for (int i = 0; i < NUM_DRIFT_REPRESENTATIONS; i++)
+		runRepresentation(DriftRepresentation(i), axisPeriod, increment, qIncrement, sampleAt,
+			reference, result[i]);
+}
+
+void
+printDriftSummary(const vector<DriftResult>& result)
+{
+	if (result.empty() || result[0].sample.empty()) return;
+
+	cout << "Drift: " << result[0].sample.back().update << " updates" << endl;
+	for (size_t i = 0; i < result.size(); i++)
+	{
+		const DriftSample&	s = result[i].sample.back();
+		cout << "  " << driftRepresentationName[result[i].representation] << ": "
+			<< result[i].nsPerUpdate << " ns/update, orthogonality " << s.orthogonality
+			<< ", unit norm " << s.unitNorm << ", determinant " << s.determinant
+			<< ", deviation " << s.deviation << endl;
+	}
+}
+
+bool
+writeDriftCSV(const char* filename, const vector<DriftResult>& result)
+{
+	ofstream	os(filename);
+	if (os.fail())
+	{
+		cout << "Can't open " << filename << endl;
+		return false;
+	}
+
+	os << "representation,update,ns_per_update,orthogonality,unit_norm,determinant,deviation" << endl;
+	for (size_t i = 0; i < result.size(); i++)
+	{
+		for (size_t k = 0; k < result[i].sample.size(); k++)
+		{
+			const DriftSample&	s = result[i].sample[k];
+			os << driftRepresentationName[result[i].representation] << "," << s.update << ","
+				<< result[i].nsPerUpdate << "," << s.orthogonality << "," << s.unitNorm << ","
+				<< s.determinant << "," << s.deviation << endl;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#ifndef __ROTATION_DRIFT_H_
+#define __ROTATION_DRIFT_H_
+
+#include <Eigen/Dense>
+using namespace Eigen;
+
+#include <vector>
+
+// Drift of the orientations updated incrementally
+//
+// Every representation accumulates the same sequence of small rotations in float, as
+// incrementalRotation() does, and is compared against the same sequence accumulated in
+// double. The errors are measured on the matrix of the representation:
+//   orthogonality	max |ci . cj| of the columns i != j
+//   unit norm		max | |ci| - 1 | of the columns
+//   determinant	|det - 1|
+//   deviation		Frobenius norm of the difference from the reference rotation
+// The cost is the wall time of the updates and the normalizations divided by their number,
+// with the error measurements at the samples included, which are a tiny fraction of them.
+
+enum DriftRepresentation
+{
+	DRIFT_MATRIX = 0,				// R, never normalized
+	DRIFT_MATRIX_DETERMINANT,		// Rn, divided by the cube root of its determinant
+	DRIFT_MATRIX_GRAM_SCHMIDT,		// Columns re-orthonormalized
+	DRIFT_MATRIX_POLAR,				// Orthogonal factor of the polar decomposition
+	DRIFT_QUATERNION,				// q, never normalized
+	DRIFT_QUATERNION_NORMALIZED,	// q, normalized
+	NUM_DRIFT_REPRESENTATIONS
+};
+
+extern const char*	driftRepresentationName[NUM_DRIFT_REPRESENTATIONS];
+
+struct DriftSample
+{
+	long long	update;		// # of the updates so far
+	double		orthogonality, unitNorm, determinant, deviation;
+};
+
+struct DriftResult
+{
+	DriftRepresentation			representation;
+	double						nsPerUpdate;
+	std::vector<DriftSample>	sample;
+};
+
+// Columns orthonormalized in the order x, y and z = x cross y
+void	orthonormalizeGramSchmidt(Matrix3f& R);
+
+// Nearest rotation by the Newton iteration R = (R + R^-T) / 2, which converges in a step or
+// two for a matrix that is nearly orthogonal
+void	orthonormalizePolar(Matrix3f& R);
+
+// numUpdates rotations by the angle about an axis drawn at every axisPeriod updates, with
+// numSamples samples of the errors evenly spaced
+void	runDriftBenchmark(long long numUpdates, int numSamples, std::vector<DriftResult>& result,
+	float angle = 3.14159265f / 1200, int axisPeriod = 2400);
+
+// Final errors and the cost of every representation
+void	printDriftSummary(const std::vector<DriftResult>& result);
+
+// A row per sample: representation, update, ns_per_update and the errors
+bool	writeDriftCSV(const char* filename, const std::vector<DriftResult>& result);
+
+#endif	// __ROTATION_DRIFT_H_
@@ -0,0 +1,280 @@
+#include "animationTrack.h"
+
+#include <math.h>
+
+#include <algorithm>
+using namespace std;
+
+const char*	interpolationName[NUM_INTERPOLATIONS] =
+{
+	"Normalized linear interpolation of quaternions",
+	"Spherical linear interpolation",
+	"Spherical quadrangle interpolation (squad)",
+};
+
+static long long	numSeeks = 0;
+
+static void
+addKey(KeyChannel& c, float time, const float* v)
+{
+	size_t	k = size_t(lower_bound(c.time.begin(), c.time.end(), time) - c.time.begin());
+	if (k == c.time.size() || c.time[k] != time)
+	{
+		c.time.insert(c.time.begin() + k, time);
+		for (int d = 0; d < c.dimension; d++) c.value[d].insert(c.value[d].begin() + k, v[d]);
+	}
+	else
+	{
+		for (int d = 0; d < c.dimension; d++) c.value[d][k] = v[d];
+	}
+
+	c.prepared = false;
+	c.cursor = 0;
+}
+
+void
+addPositionKey(AnimationTrack& track, float time, const Vector3f& p)
+{
+	addKey(track.position, time, p.data());
+}
+
+void
+addRotationKey(AnimationTrack& track, float time, const Quaternionf& q)
+{
+	Quaternionf	n = q.normalized();
+	addKey(track.rotation, time, n.coeffs().data());	// x, y, z, w
+}
+
+void
+addScaleKey(AnimationTrack& track, float time, const Vector3f& s)
+{
+	addKey(track.scale, time, s.data());
+}
+
+float
+trackDuration(const AnimationTrack& track)
+{
+	float	duration = 0;
+	if (!track.position.time.empty())	duration = max(duration, track.position.time.back());
+	if (!track.rotation.time.empty())	duration = max(duration, track.rotation.time.back());
+	if (!track.scale.time.empty())		duration = max(duration, track.scale.time.back());
+
+	return duration;
+}
+
+//
+// Quaternions
+//
+static inline Quaternionf
+rotationKey(const vector<float> v[4], int k)
+{
+	return Quaternionf(v[3][k], v[0][k], v[1][k], v[2][k]);
+}
+
+// Logarithm of a unit quaternion, a pure quaternion of the half angle times the axis
+static inline Vector3f
+logUnit(const Quaternionf& q)
+{
+	float	s = q.vec().norm();
+	if (s < 1.0e-7f) return q.vec();
+
+	return q.vec() * (atan2(s, q.w()) / s);
+}
+
+static inline Quaternionf
+expPure(const Vector3f& v)
+{
+	float	a = v.norm();
+	if (a < 1.0e-7f) return Quaternionf(1, v.x(), v.y(), v.z()).normalized();
+
+	Quaternionf	q;
+	q.w() = cos(a);
+	q.vec() = v * (sin(a) / a);
+	return q;
+}
+
+// Slerp without flipping b, as the keys are already in the same hemisphere
+static inline Quaternionf
+slerp(const Quaternionf& a, const Quaternionf& b, float u)
+{
+	float	c = a.dot(b);
+	float	wa = 1 - u, wb = u;
+
+	// Nearly the same: sin(theta) ~ 0, and the linear interpolation is exact enough
+	if (c < 0.9995f)
+	{
+		float	theta = acos(max(c, -1.0f));
+		float	s = 1 / sin(theta);
+		wa = sin(wa * theta) * s;
+		wb = sin(wb * theta) * s;
+	}
+
+	Quaternionf	q;
+	q.coeffs() = wa * a.coeffs() + wb * b.coeffs();
+	return q.normalized();
+}
+
+static inline void
+setRotationKey(vector<float> v[4], int k, const Quaternionf& q)
+{
+	v[0][k] = q.x();
+	v[1][k] = q.y();
+	v[2][k] = q.z();
+	v[3][k] = q.w();
+}
+
+// Hemispheres of the keys in the order, and the inner points of squad. With L+ and L- the
+// logarithms of q_i^-1 q_i+1 and q_i^-1 q_i-1, the tangent (L+ - L-) / 2 of the uniform
+// squad is split in the ratio of the durations h of the intervals around the key, so that
+// the angular velocity is continuous in time rather than in the parameter:
+//   outgoing a_i = q_i exp((T_out - L+) / 2),	T_out = (L+ - L-) h_i / (h_i-1 + h_i)
+//   incoming b_i = q_i exp((-L- - T_in) / 2),	T_in = (L+ - L-) h_i-1 / (h_i-1 + h_i)
+// which are the s_i = q_i exp(-(L+ + L-) / 4) of both the sides for the uniform keys.
+static void
+prepareRotations(KeyChannel& c)
+{
+	int	n = int(c.time.size());
+	for (int k = 1; k < n; k++)
+	{
+		if (rotationKey(c.value, k).dot(rotationKey(c.value, k - 1)) < 0)
+			for (int d = 0; d < 4; d++) c.value[d][k] = -c.value[d][k];
+	}
+
+	for (int d = 0; d < 4; d++)
+	{
+		c.controlOut[d].resize(n);
+		c.controlIn[d].resize(n);
+	}
+	for (int k = 0; k < n; k++)
+	{
+		Quaternionf	q = rotationKey(c.value, k), a = q, b = q;
+		if (k > 0 && k < n - 1)
+		{
+			Quaternionf	inverse = q.conjugate();
+			Vector3f	next = logUnit(inverse * rotationKey(c.value, k + 1));
+			Vector3f	previous = logUnit(inverse * rotationKey(c.value, k - 1));
+
+			float	h0 = c.time[k] - c.time[k - 1], h1 = c.time[k + 1] - c.time[k];
+			float	w = (h0 + h1 > 0) ? h1 / (h0 + h1) : 0.5f;
+
+			a = q * expPure((w * (next - previous) - next) / 2);
+			b = q * expPure((-previous - (1 - w) * (next - previous)) / 2);
+		}
+
+		setRotationKey(c.controlOut, k, a);
+		setRotationKey(c.controlIn, k, b);
+	}
+}
+
+//
+// Sampling
+//
+
+// Key k with time[k] <= t < time[k + 1] in [0, # of keys - 2], from the cursor
+static inline int
+findKey(KeyChannel& c, float t)
+{
+	const vector<float>&	time = c.time;
+	int						last = int(time.size()) - 2;
+	int						k = min(c.cursor, last);
+
+	// The same or the next key in playing forward
+	if ((k == 0 || t >= time[k]) && (k == last || t < time[k + 1])) return k;
+	if (k < last && t >= time[k + 1] && (k + 1 == last || t < time[k + 2])) return c.cursor = k + 1;
+
+	numSeeks++;
+	k = int(upper_bound(time.begin(), time.end(), t) - time.begin()) - 1;
+	return c.cursor = min(max(k, 0), last);
+}
+
+// Interval of the time and the parameter in it, or false for a single key
+static inline bool
+locate(KeyChannel& c, float t, int& k, float& u)
+{
+	if (c.time.size() < 2)
+	{
+		k = 0;
+		u = 0;
+		return false;
+	}
+
+	k = findKey(c, t);
+
+	float	dt = c.time[k + 1] - c.time[k];
+	u = (dt > 0) ? min(max((t - c.time[k]) / dt, 0.0f), 1.0f) : 0.0f;
+	return true;
+}
+
+static inline Vector3f
+sampleVector(KeyChannel& c, float t, const Vector3f& empty)
+{
+	if (c.time.empty()) return empty;
+
+	int		k;
+	float	u;
+	if (!locate(c, t, k, u)) return Vector3f(c.value[0][0], c.value[1][0], c.value[2][0]);
+
+	Vector3f	v;
+	for (int d = 0; d < 3; d++) v[d] = c.value[d][k] + (c.value[d][k + 1] - c.value[d][k]) * u;
+	return v;
+}
+
+static inline Quaternionf
+sampleRotation(KeyChannel& c, float t, Interpolation method)
+{
+	if (c.time.empty()) return Quaternionf::Identity();
+	if (!c.prepared)
+	{
+		prepareRotations(c);
+		c.prepared = true;
+	}
+
+	int		k;
+	float	u;
+	if (!locate(c, t, k, u)) return rotationKey(c.value, 0);
+
+	Quaternionf	a = rotationKey(c.value, k), b = rotationKey(c.value, k + 1);
+	switch (method)
+	{
+	case INTERPOLATION_LINEAR:
+	{
+		Quaternionf	q;
+		q.coeffs() = (1 - u) * a.coeffs() + u * b.coeffs();
+		return q.normalized();
+	}
+	case INTERPOLATION_SLERP:
+		return slerp(a, b, u);
+	default:
+		return slerp(slerp(a, b, u), slerp(rotationKey(c.controlOut, k), rotationKey(c.controlIn, k + 1), u),
+			2 * u * (1 - u));
+	}
+}
+
+void
+sampleTrack(AnimationTrack& track, float t, Interpolation method, Vector3f& p, Quaternionf& q, Vector3f& s)
+{
+	p = sampleVector(track.position, t, Vector3f::Zero());
+	q = sampleRotation(track.rotation, t, method);
+	s = sampleVector(track.scale, t, Vector3f::Ones());
+}
+
+Matrix4f
+sampleTrack(AnimationTrack& track, float t, Interpolation method)
+{
+	Vector3f	p, s;
+	Quaternionf	q;
+	sampleTrack(track, t, method, p, q, s);
+
+	Matrix4f	T;
+	T.setIdentity();
+	T.block<3, 3>(0, 0) = q.toRotationMatrix() * s.asDiagonal();
+	T.block<3, 1>(0, 3) = p;
+
+	return T;
+}
+
+long long
+trackSeeks()
+{
+	return numSeeks;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#ifndef __ANIMATION_TRACK_H_
+#define __ANIMATION_TRACK_H_
+
+#include <Eigen/Dense>
+using namespace Eigen;
+
+#include <vector>
+
+// Keyframe animation tracks
+//
+// A track has position, rotation and scale channels of any number of keys each. A channel
+// keeps the times and the components of its keys in separate arrays, x, y, z and w. The
+// positions and the scales are interpolated linearly, and the rotations by one of the
+// methods below between the keys around the time.
+//
+// Every channel caches the key of its last sample. Playing forward finds the key at the
+// cursor or the next one in O(1), and only a seek, e.g., a jump back to the start of a loop,
+// searches the times in O(log # of keys).
+//
+// The rotation keys are flipped into the hemisphere of the previous key before the first
+// sample, as q and -q are the same rotation, so that every method takes the shorter arc.
+//
+// Squad is C1 in the parameter u of every interval with the inner points of the uniform keys.
+// Here the tangent at a key is split between its two intervals in the ratio of their
+// durations instead, so that the angular velocity is continuous in time for the uneven keys
+// as well. The angular acceleration still jumps at the keys, so that the angular velocities
+// by the finite differences of step h on either side of a key differ by O(h).
+
+enum Interpolation
+{
+	INTERPOLATION_LINEAR = 0,	// Normalized linear interpolation of the quaternions
+	INTERPOLATION_SLERP,		// Spherical linear interpolation
+	INTERPOLATION_SQUAD,		// Spherical quadrangle interpolation, see below
+	NUM_INTERPOLATIONS
+};
+
+extern const char*	interpolationName[NUM_INTERPOLATIONS];
+
+struct KeyChannel
+{
+	int					dimension;		// 3 for the positions and scales, 4 for the rotations
+	std::vector<float>	time;			// Increasing
+	std::vector<float>	value[4];		// x, y, z and w of the keys
+	std::vector<float>	controlOut[4];	// Inner points of squad for the rotations, leaving
+	std::vector<float>	controlIn[4];	// and reaching the keys
+	bool				prepared;		// Hemispheres and control points up to date
+	int					cursor;			// Key of the last sample
+
+	KeyChannel(int d = 3) : dimension(d), prepared(false), cursor(0) {}
+};
+
+struct AnimationTrack
+{
+	KeyChannel	position, rotation, scale;
+
+	AnimationTrack() : position(3), rotation(4), scale(3) {}
+};
+
+// Keys in any order of the times. A key at the time of an existing one replaces it.
+void	addPositionKey(AnimationTrack& track, float time, const Vector3f& p);
+void	addRotationKey(AnimationTrack& track, float time, const Quaternionf& q);
+void	addScaleKey(AnimationTrack& track, float time, const Vector3f& s);
+
+// Time of the last key of all the channels
+float	trackDuration(const AnimationTrack& track);
+
+// Values at the time, clamped to the first and last keys. An empty channel gives the
+// origin, the identity and the unit scale.
+void		sampleTrack(AnimationTrack& track, float t, Interpolation method,
+	Vector3f& p, Quaternionf& q, Vector3f& s);
+Matrix4f	sampleTrack(AnimationTrack& track, float t, Interpolation method);	// T R S
+
+// # of the searches of the times for the seeks so far
+long long	trackSeeks();
+
+#endif	// __ANIMATION_TRACK_H_
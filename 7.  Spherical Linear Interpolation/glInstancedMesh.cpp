@@ -0,0 +1,137 @@
+#include "glInstancedMesh.h"
+
+#include <vector>
+using namespace std;
+
+// Attribute locations shared with the instanced mesh shaders. The model matrix takes
+// 4 locations, a column each.
+enum
+{
+	VERTEX_POSITION = 0,
+	VERTEX_NORMAL = 1,
+	INSTANCE_MODEL = 2,
+	INSTANCE_COLOR = 6,
+};
+
+static const int	INSTANCE_FLOATS = 20;		// 16 for the matrix and 4 for the color
+
+// Per-instance attributes of the instances from first on, advancing once per instance.
+// Offsetting the pointers replaces the base instance of GL 4.2.
+static void
+setupInstanceAttributes(const InstancedMesh& s, int first)
+{
+	GLsizei	stride = INSTANCE_FLOATS * sizeof(GLfloat);
+	size_t	base = size_t(first) * stride;
+
+	glBindBuffer(GL_ARRAY_BUFFER, s.instanceId);
+	for (int c = 0; c < 4; c++)
+	{
+		glEnableVertexAttribArray(INSTANCE_MODEL + c);
+		glVertexAttribPointer(INSTANCE_MODEL + c, 4, GL_FLOAT, GL_FALSE, stride,
+			(const GLvoid*)(base + 4 * c * sizeof(GLfloat)));
+		glVertexAttribDivisor(INSTANCE_MODEL + c, 1);
+	}
+
+	glEnableVertexAttribArray(INSTANCE_COLOR);
+	glVertexAttribPointer(INSTANCE_COLOR, 4, GL_FLOAT, GL_FALSE, stride,
+		(const GLvoid*)(base + 16 * sizeof(GLfloat)));
+	glVertexAttribDivisor(INSTANCE_COLOR, 1);
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+bool
+createInstancedMesh(InstancedMesh& s, ArrayXXi& face, MatrixXf& vertex, MatrixXf& normal,
+	const char* vertexShaderFile, const char* fragmentShaderFile)
+{
+	if (!GLEW_VERSION_3_3 && !GLEW_ARB_instanced_arrays)	return	false;
+
+	// Shaders with the attribute locations bound before linking
+	s.vertexShader = createShaderFromFile(GL_VERTEX_SHADER, vertexShaderFile);
+	s.fragmentShader = createShaderFromFile(GL_FRAGMENT_SHADER, fragmentShaderFile);
+	if (s.vertexShader == 0 || s.fragmentShader == 0)	return	false;
+
+	s.program = glCreateProgram();
+	glAttachShader(s.program, s.vertexShader);
+	glAttachShader(s.program, s.fragmentShader);
+
+	glBindAttribLocation(s.program, VERTEX_POSITION, "vPosition");
+	glBindAttribLocation(s.program, VERTEX_NORMAL, "vNormal");
+	glBindAttribLocation(s.program, INSTANCE_MODEL, "iModel");
+	glBindAttribLocation(s.program, INSTANCE_COLOR, "iColor");
+
+	glLinkProgram(s.program);
+	printProgramInfoLog(s.program);
+
+	GLint	linked = GL_FALSE;
+	glGetProgramiv(s.program, GL_LINK_STATUS, &linked);
+	if (linked != GL_TRUE)	return	false;
+
+	// The mesh is uploaded only once.
+	createVBO(s.vao, s.indexId, s.vertexId, s.normalId);
+	s.numTris = uploadMesh2VBO(face, vertex, normal, s.vao, s.indexId, s.vertexId, s.normalId);
+
+	glGenBuffers(1, &s.instanceId);
+
+	glBindVertexArray(s.vao);
+	setupInstanceAttributes(s, 0);
+	glBindVertexArray(0);
+
+	return	isOK("createInstancedMesh()", __FILE__, __LINE__, false);
+}
+
+void
+uploadMeshInstances(InstancedMesh& s, int n, const Matrix4f* model, const Vector4f* color)
+{
+	vector<GLfloat>	data(size_t(n) * INSTANCE_FLOATS);
+	for (int i = 0; i < n; i++)
+	{
+		GLfloat*	p = &data[size_t(i) * INSTANCE_FLOATS];
+		for (int k = 0; k < 16; k++) p[k] = model[i].data()[k];
+		for (int k = 0; k < 4; k++) p[16 + k] = color[i][k];
+	}
+
+	// glBufferData() orphans the previous storage, so that it never waits for the GPU.
+	glBindBuffer(GL_ARRAY_BUFFER, s.instanceId);
+	glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(GLfloat), data.data(), GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	s.numInstances = n;
+
+	isOK("uploadMeshInstances()", __FILE__, __LINE__);
+}
+
+void
+drawInstancedMesh(const InstancedMesh& s, int first, int count)
+{
+	if (count < 0)	count = s.numInstances - first;
+	if (count <= 0 || first < 0 || first + count > s.numInstances)	return;
+
+	glUseProgram(s.program);
+	glBindVertexArray(s.vao);
+	if (first > 0)	setupInstanceAttributes(s, first);
+
+	glDrawElementsInstanced(GL_TRIANGLES, s.numTris * 3, GL_UNSIGNED_INT, NULL, count);
+
+	if (first > 0)	setupInstanceAttributes(s, 0);
+	glBindVertexArray(0);
+	glUseProgram(0);
+
+	isOK("drawInstancedMesh()", __FILE__, __LINE__);
+}
+
+void
+deleteInstancedMesh(InstancedMesh& s)
+{
+	if (s.instanceId != 0)
+	{
+		glDeleteBuffers(1, &s.instanceId);
+		s.instanceId = 0;
+	}
+
+	deleteVBO(s.vao, s.indexId, s.vertexId, s.normalId);
+	deleteShaders(s.program, s.vertexShader, s.fragmentShader);
+
+	s.program = s.vertexShader = s.fragmentShader = 0;
+	s.numTris = s.numInstances = 0;
+}
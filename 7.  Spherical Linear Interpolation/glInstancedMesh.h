@@ -0,0 +1,46 @@
+#pragma once
+
+#ifndef __GL_INSTANCED_MESH_H_
+#define __GL_INSTANCED_MESH_H_
+
+#include "glShader.h"
+
+// Instanced mesh
+//
+// The mesh is uploaded to the VBOs once, and any number of its copies, e.g., the poses of
+// a trail, are drawn with a single glDrawElementsInstanced() call reading a per-instance
+// 4x4 model matrix and RGBA diffuse color from one interleaved buffer. The shaders read the
+// fixed-function matrices and GL_LIGHT0/material states as the immediate mode does, and the
+// polygon mode applies to the instances as well.
+struct InstancedMesh
+{
+	GLuint	program, vertexShader, fragmentShader;
+
+	GLuint	vao;			// Vertex array object
+	GLuint	indexId;		// Buffer for triangle indices
+	GLuint	vertexId;		// Buffer for vertex positions
+	GLuint	normalId;		// Buffer for normal vectors
+	GLuint	instanceId;		// Per-instance model matrices (16 floats) and colors (4 floats)
+
+	int		numTris;		// # of triangles in the mesh
+	int		numInstances;	// # of instances uploaded
+
+	InstancedMesh()
+	{
+		program = vertexShader = fragmentShader = 0;
+		vao = indexId = vertexId = normalId = instanceId = 0;
+		numTris = numInstances = 0;
+	}
+};
+
+bool	createInstancedMesh(InstancedMesh& s, ArrayXXi& face, MatrixXf& vertex, MatrixXf& normal,
+	const char* vertexShaderFile, const char* fragmentShaderFile);
+
+// Upload n instances, a column-major 4x4 matrix and an RGBA color each
+void	uploadMeshInstances(InstancedMesh& s, int n, const Matrix4f* model, const Vector4f* color);
+
+// Instances [first, first + count), all of them for count < 0
+void	drawInstancedMesh(const InstancedMesh& s, int first = 0, int count = -1);
+void	deleteInstancedMesh(InstancedMesh& s);
+
+#endif	// __GL_INSTANCED_MESH_H_
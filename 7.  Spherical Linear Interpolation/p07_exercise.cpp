@@ -1,10 +1,15 @@
 #include "glSetup.h"
+#include "glInstancedMesh.h"
 #include "mesh.h"
+#include "animationTrack.h"
+#include "quaternionBatch.h"
 
 #include <Eigen/Dense>
 using namespace Eigen;
 
 #include <iostream>
+#include <random>
+#include <vector>
 using namespace std;
 
 #ifdef _WIN32
@@ -12,15 +17,22 @@ using namespace std;
 #endif
 
 #include <math.h>
+#include <string.h>
+#include <stdlib.h>
 
 void init(const char* filename);
 void setupLight();
 
-//void update(float elapsed);
+void update(float elapsed);
 void render(GLFWwindow* window);
 void reshape(GLFWwindow* window, int w, int h);
 void keyboard(GLFWwindow* window, int key, int scancode, int action, int mods);
 void getTimeperT();
+void initTrack();
+void benchmarkTracks();
+void benchmarkInterpolation(int n = 1 << 20);
+void initTrail();
+void uploadTrail();
 // Play configuration
 bool pause = false;
 
@@ -66,8 +78,19 @@ Quaternionf Q_q1, Q_q2; // Two key orientations
 Vector3f Q_p1, Q_p2;	// Two key positions
 
 
-Matrix4f Ts[11] = {};
-Matrix4f Q_Ts[11] = {};
+// Trail of the poses interpolated at trailLength evenly spaced t in [0, 1]
+int					trailLength = 11;
+vector<Matrix4f>	Ts;
+vector<Matrix4f>	Q_Ts;
+
+// Both the trails drawn from the VBOs with an instanced call each, or in the immediate mode
+InstancedMesh	trail;
+bool			instancedTrail = true;
+
+// Animation track through the two keys and back
+AnimationTrack	track;
+Interpolation	trackInterpolation = INTERPOLATION_SQUAD;
+Matrix4f		trackT = Matrix4f::Identity();	// Current transformation of the track
 
 // Interpolation duration
 float interval = 3; // Seconds. 3ʿ ѹ ̼ǵ.
@@ -87,9 +110,14 @@ int main(int argc, char* argv[])
 	vsync = 0;
 
 	// Filename for deformable body configuration
-	const char* filename;
-	if (argc >= 2) filename = argv[1];
-	else           filename = defaultMeshFileName;
+	const char* filename = defaultMeshFileName;
+	if (argc >= 2 && argv[1][0] != '-') filename = argv[1];
+
+	// Poses in the trails
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--trail") == 0 && i + 1 < argc) trailLength = max(atoi(argv[++i]), 2);
+	}
 
 	// Field of view of 85mm lens in degree
 	fovy = 16.1;
@@ -120,17 +148,26 @@ int main(int argc, char* argv[])
 	cout << endl;
 	for (int i = 0; i < 2; i++)
 		cout << "Keyboard Input: " << (i + 1) << " for" << methodString[i] << endl;
+	cout << "Keyboard Input: l for the interpolation of the animation track" << endl;
+	cout << "Keyboard Input: b for the benchmark of 10K animation tracks" << endl;
+	cout << "Keyboard Input: v for the benchmark of the batch interpolation" << endl;
+	cout << "Keyboard Input: -/= for halving/doubling the trail" << endl;
+	cout << "Keyboard Input: i for instanced/immediate trail" << endl;
+	cout << "Keyboard Input: space for play/pause" << endl;
 	cout << endl;
 
 	// Initialization - Main loop - Finalization
 	init(filename);
 	getTimeperT();
+	initTrail();
+	initTrack();
 
 	// Main loop
 	float previous = (float)glfwGetTime();
 	float elapsed = 0;
 	while (!glfwWindowShouldClose(window))
 	{
+		beginTiming(TIMING_UPDATE);
 		// Time passed during a single loop
 		float now = (float)glfwGetTime();
 		float delta = now - previous;
@@ -138,22 +175,31 @@ int main(int argc, char* argv[])
 
 		// Time passed after the previous frame
 		elapsed += delta;
+		endTiming(TIMING_UPDATE);
 
+		beginTiming(TIMING_SIMULATE);
 		// Deal with the current frame
 		if (elapsed > timeStep)
 		{
-			//// Animate 1 frame
-			//if (!pause) update(elapsed);
-			//else        update(0);	// To compare interpolation methods
+			// Animate 1 frame
+			if (!pause) update(elapsed);
+			else        update(0);	// To compare interpolation methods
 
 			elapsed = 0; // Reset the elapsed time
 		}
+		endTiming(TIMING_SIMULATE);
 
+		beginTiming(TIMING_RENDER);
 		render(window);			 // Draw one frame
-		glfwSwapBuffers(window); // Swap buffers
+		endTiming(TIMING_RENDER);
+		swapBuffers(window); // Swap buffers
+		beginTiming(TIMING_UPDATE);
 		glfwPollEvents();		 // Events
+		endTiming(TIMING_UPDATE);
 	}
 
+	deleteInstancedMesh(trail);
+
 	// Terminate the glfw system
 	glfwDestroyWindow(window);
 	glfwTerminate();
@@ -250,9 +296,11 @@ void getTimeperT()
 	TTrans.setIdentity();
 	QTrans.setIdentity();
 
-	for (int i = 0; i <11; i++) {
+	Ts.resize(trailLength);
+	Q_Ts.resize(trailLength);
+	for (int i = 0; i < trailLength; i++) {
 		
-		float t = 0.1 * i;
+		float t = float(i) / (trailLength - 1);
 		Vector3f p = (1 - t) * p1 + t * p2;
 		TTrans.block<3, 1>(0, 3) = p;
 
@@ -277,9 +325,186 @@ void getTimeperT()
 	}
 }
 
+// Mesh uploaded once for both the trails
+void initTrail()
+{
+	if (!createInstancedMesh(trail, face1, vertex1, normal1,
+		"sv07_instanced_mesh.glsl", "sf07_instanced_mesh.glsl"))
+	{
+		cerr << "Instanced trails fall back to the immediate mode" << endl;
+		deleteInstancedMesh(trail);
+		instancedTrail = false;
+		return;
+	}
+
+	uploadTrail();
+}
+
+// Ts followed by Q_Ts, the former fading in from the start to the end
+void uploadTrail()
+{
+	if (trail.program == 0) return;
+
+	vector<Matrix4f>	model(Ts);
+	vector<Vector4f>	color(2 * trailLength);
+	model.insert(model.end(), Q_Ts.begin(), Q_Ts.end());
+	for (int i = 0; i < trailLength; i++)
+	{
+		color[i] = Vector4f(0.85f, 0.35f, 0.7f, 0.25f + 0.75f * i / (trailLength - 1));
+		color[trailLength + i] = Vector4f(0.15f, 0.85f, 0.15f, 1);
+	}
+
+	uploadMeshInstances(trail, 2 * trailLength, model.data(), color.data());
+	cout << "Trail: " << trailLength << " poses, " << (instancedTrail ? "instanced" : "immediate") << endl;
+}
+
+// Keys of the two key poses, a detour and the start again, spaced unevenly in time
+void initTrack()
+{
+	Quaternionf	q3 = Quaternionf(AngleAxisf(float(M_PI) / 2, Vector3f(0, 1, 0))) * q2;
+
+	addPositionKey(track, 0, p1);
+	addPositionKey(track, interval, p2);
+	addPositionKey(track, 1.5f * interval, Vector3f(1.5f, 1.5f, 1.5f));
+	addPositionKey(track, 2 * interval, p1);
+
+	addRotationKey(track, 0, q1);
+	addRotationKey(track, interval, q2);
+	addRotationKey(track, 1.5f * interval, q3);
+	addRotationKey(track, 2 * interval, q1);
+
+	addScaleKey(track, 0, Vector3f(1, 1, 1));
+	addScaleKey(track, interval, Vector3f(1.2f, 1.2f, 1.2f));
+	addScaleKey(track, 2 * interval, Vector3f(1, 1, 1));
+
+	cout << "Track: " << interpolationName[trackInterpolation] << endl;
+}
+
+void update(float elapsed)
+{
+	currTime += elapsed;
+
+	// Looping over the track
+	float	duration = trackDuration(track);
+	trackT = sampleTrack(track, (duration > 0) ? fmod(currTime, duration) : 0, trackInterpolation);
+}
+
+// Sampling of 10K tracks of 32 random keys a frame, played at 120 fps and at random times
+void benchmarkTracks()
+{
+	const int	numTracks = 10000;
+	const int	numKeys = 32;
+	const int	numFrames = 600;
+	const float	keyInterval = 0.25f;
+
+	mt19937								random(4500);
+	uniform_real_distribution<float>	uniform(-1, 1);
+
+	vector<AnimationTrack>	tracks(numTracks);
+	for (int i = 0; i < numTracks; i++)
+	{
+		for (int k = 0; k < numKeys; k++)
+		{
+			float	time = keyInterval * (k + 0.4f * uniform(random));
+			addPositionKey(tracks[i], time, 3 * Vector3f(uniform(random), uniform(random), uniform(random)));
+			addRotationKey(tracks[i], time,
+				Quaternionf(uniform(random), uniform(random), uniform(random), uniform(random)));
+			addScaleKey(tracks[i], time, Vector3f::Ones() * (1 + 0.2f * uniform(random)));
+		}
+	}
+
+	// Random times of the seeks, the same for all the methods
+	vector<float>	randomTime(numFrames);
+	for (int f = 0; f < numFrames; f++) randomTime[f] = keyInterval * numKeys * (0.5f + 0.5f * uniform(random));
+
+	cout << "Track: " << numTracks << " tracks of " << numKeys << " keys, " << numFrames << " frames" << endl;
+	for (int m = 0; m < NUM_INTERPOLATIONS; m++)
+	{
+		Vector3f	p, s;
+		Quaternionf	q;
+
+		for (int pass = 0; pass < 2; pass++)
+		{
+			long long	seeks = trackSeeks();
+			double		start = glfwGetTime();
+			for (int f = 0; f < numFrames; f++)
+			{
+				float	t = (pass == 0) ? f * timeStep : randomTime[f];
+				for (int i = 0; i < numTracks; i++) sampleTrack(tracks[i], t, Interpolation(m), p, q, s);
+			}
+			double	seconds = glfwGetTime() - start;
+
+			cout << "  " << interpolationName[m] << ((pass == 0) ? ", sequential: " : ", random: ")
+				<< seconds * 1000 / numFrames << " ms/frame, "
+				<< seconds * 1.0e9 / (double(numFrames) * numTracks) << " ns/track, "
+				<< trackSeeks() - seeks << " seeks" << endl;
+		}
+	}
+}
+
+// Throughput of the batch interpolation and its max error from the slerp in double, against
+// Eigen's slerp a pair at a time, with every 16th pair nearly antipodal as q2 and q3 in init()
+void benchmarkInterpolation(int n)
+{
+	const int	runs = 10;
+
+	mt19937								random(4600);
+	uniform_real_distribution<float>	uniform(-1, 1);
+
+	vector<Quaternionf>	qa(n), qb(n), qo(n);
+	vector<float>		t(n);
+	QuaternionArray		a, b, out;
+	a.resize(n);
+	b.resize(n);
+	for (int i = 0; i < n; i++)
+	{
+		qa[i] = Quaternionf(uniform(random), uniform(random), uniform(random), uniform(random)).normalized();
+		qb[i] = Quaternionf(uniform(random), uniform(random), uniform(random), uniform(random)).normalized();
+		if (i % 16 == 0)
+		{
+			qb[i] = qa[i] * Quaternionf(AngleAxisf(float(M_PI) / 180, Vector3f(1, 1, 1).normalized()));
+			qb[i].coeffs() = -qb[i].coeffs();
+		}
+		t[i] = 0.5f + 0.5f * uniform(random);
+
+		a.x[i] = qa[i].x(); a.y[i] = qa[i].y(); a.z[i] = qa[i].z(); a.w[i] = qa[i].w();
+		b.x[i] = qb[i].x(); b.y[i] = qb[i].y(); b.z[i] = qb[i].z(); b.w[i] = qb[i].w();
+	}
+
+	// Angle of the rotation between q and the slerp in double
+	auto error = [&](int i, const Quaternionf& q)
+	{
+		Quaterniond	d = qa[i].cast<double>().slerp(t[i], qb[i].cast<double>()).conjugate() * q.cast<double>();
+		return 2 * atan2(d.vec().norm(), fabs(d.w()));
+	};
 
-// Draw a sphere after setting up its material
-void drawMesh(MatrixXf vertex,MatrixXf normal,ArrayXXi face, bool alpha )
+	cout << endl << "Interpolation: " << n << " pairs, " << (interpolationSIMD() ? "AVX2" : "no SIMD") << endl;
+
+	double start = glfwGetTime();
+	for (int r = 0; r < runs; r++)
+		for (int i = 0; i < n; i++) qo[i] = qa[i].slerp(t[i], qb[i]);
+	double seconds = (glfwGetTime() - start) / runs;
+
+	double maxError = 0;
+	for (int i = 0; i < n; i++) maxError = max(maxError, error(i, qo[i]));
+	cout << "  Eigen's slerp: " << n / seconds * 1.0e-6 << " M pairs/s, max error " << maxError << " rad" << endl;
+
+	for (int m = 0; m < NUM_BATCH_INTERPOLATIONS; m++)
+	{
+		start = glfwGetTime();
+		for (int r = 0; r < runs; r++) interpolateBatch(a, b, t.data(), out, BatchInterpolation(m));
+		seconds = (glfwGetTime() - start) / runs;
+
+		maxError = 0;
+		for (int i = 0; i < n; i++)
+			maxError = max(maxError, error(i, Quaternionf(out.w[i], out.x[i], out.y[i], out.z[i])));
+		cout << "  Batch " << batchInterpolationName[m] << ": " << n / seconds * 1.0e-6
+			<< " M pairs/s, max error " << maxError << " rad" << endl;
+	}
+}
+
+// Material of the dinosaur
+void setupMaterial(bool alpha)
 {
 	int a = 1;
 	GLfloat mat_diffuse[4]= { 0.15f, 0.85f, 0.15f, 1 };
@@ -300,6 +525,12 @@ void drawMesh(MatrixXf vertex,MatrixXf normal,ArrayXXi face, bool alpha )
 	glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, mat_diffuse );
 	glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, mat_specular);
 	glMaterialf(GL_FRONT_AND_BACK, GL_SHININESS, mat_shininess);
+}
+
+// Draw a mesh after setting up its material
+void drawMesh(const MatrixXf& vertex, const MatrixXf& normal, const ArrayXXi& face, bool alpha)
+{
+	setupMaterial(alpha);
 
 	// Mesh
 	glBegin(GL_TRIANGLES);
@@ -337,8 +568,26 @@ void render(GLFWwindow* window)
 	// Lighting
 	setupLight();
 	
+	// Both the trails in an instanced call each. The material is for the ambient and specular
+	// terms, while the diffuse colors come from the instances.
+	if (instancedTrail)
+	{
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+		setupMaterial(true);
+		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+		drawInstancedMesh(trail, 0, trailLength);
+
+		setupMaterial(false);
+		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+		drawInstancedMesh(trail, trailLength, trailLength);
+
+		glDisable(GL_BLEND);
+	}
+
 	//  ׸.
-	for (int i = 0; i < 11; i++)
+	for (int i = 0; !instancedTrail && i < trailLength; i++)
 	{
 		glPushMatrix();
 		glMultMatrixf(Ts[i].data());
@@ -353,6 +602,13 @@ void render(GLFWwindow* window)
 		glPopMatrix();
 
 	}
+
+	// Animation track
+	glPushMatrix();
+	glMultMatrixf(trackT.data());
+	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+	drawMesh(vertex2, normal2, face2, true);
+	glPopMatrix();
 }
 
 // Light
@@ -385,6 +641,32 @@ void keyboard(GLFWwindow* window, int key, int scancode, int action, int mods)
 		case GLFW_KEY_1:	method = 1; cout << methodString[method - 1] << endl; break;
 		case GLFW_KEY_2:	method = 2; cout << methodString[method - 1] << endl; break;
 
+			// Interpolation of the animation track
+		case GLFW_KEY_L:
+			trackInterpolation = Interpolation((trackInterpolation + 1) % NUM_INTERPOLATIONS);
+			cout << "Track: " << interpolationName[trackInterpolation] << endl;
+			break;
+
+			// Benchmark of the animation tracks
+		case GLFW_KEY_B:	benchmarkTracks(); break;
+
+			// Trail length
+		case GLFW_KEY_MINUS:
+		case GLFW_KEY_EQUAL:
+			trailLength = (key == GLFW_KEY_EQUAL) ? min(2 * trailLength, 4096) : max(trailLength / 2, 2);
+			getTimeperT();
+			uploadTrail();
+			break;
+
+			// Instanced or immediate trail
+		case GLFW_KEY_I:
+			instancedTrail = !instancedTrail && trail.program != 0;
+			cout << "Trail: " << (instancedTrail ? "instanced" : "immediate") << endl;
+			break;
+
+			// Benchmark of the batch interpolation
+		case GLFW_KEY_V:	benchmarkInterpolation(); break;
+
 			// Play/pause toggle
 		case GLFW_KEY_SPACE: pause = !pause; break;
 		}
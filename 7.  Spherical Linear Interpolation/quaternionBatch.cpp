@@ -0,0 +1,150 @@
+#include "quaternionBatch.h"
+
+#include <math.h>
+
+#include <algorithm>
+using namespace std;
+
+#ifdef __AVX2__
+#define QUATERNION_BATCH_AVX2
+#include <immintrin.h>
+#endif
+
+const char*	batchInterpolationName[NUM_BATCH_INTERPOLATIONS] =
+{
+	"nlerp", "Corrected nlerp", "slerp"
+};
+
+// Weights of a and b, with the sign of b for the shorter arc
+static inline void
+weightsScalar(float d, float t, BatchInterpolation method, float& wa, float& wb)
+{
+	float	c = fabs(d);
+
+	if (method == BATCH_NLERP_CORRECTED)
+	{
+		float	A = 1.0904f + c * (-3.2452f + c * (3.55645f - c * 1.43519f));
+		float	B = 0.848013f + c * (-1.06021f + c * 0.215638f);
+		float	k = A * (t - 0.5f) * (t - 0.5f) + B;
+		t = t + t * (t - 0.5f) * (t - 1) * k;
+	}
+
+	wa = 1 - t;
+	wb = t;
+
+	// Nearly the same: sin(theta) ~ 0, and the nlerp is exact enough
+	if (method == BATCH_SLERP && c < 0.9995f)
+	{
+		float	theta = acos(c);
+		float	s = 1 / sin(theta);
+		wa = sin(wa * theta) * s;
+		wb = sin(wb * theta) * s;
+	}
+
+	if (d < 0) wb = -wb;
+}
+
+static void
+interpolateScalar(const QuaternionArray& a, const QuaternionArray& b, const float* t,
+	QuaternionArray& out, BatchInterpolation method, int begin, int end)
+{
+	for (int i = begin; i < end; i++)
+	{
+		float	d = a.x[i] * b.x[i] + a.y[i] * b.y[i] + a.z[i] * b.z[i] + a.w[i] * b.w[i];
+		float	wa, wb;
+		weightsScalar(d, t[i], method, wa, wb);
+
+		float	x = wa * a.x[i] + wb * b.x[i];
+		float	y = wa * a.y[i] + wb * b.y[i];
+		float	z = wa * a.z[i] + wb * b.z[i];
+		float	w = wa * a.w[i] + wb * b.w[i];
+		float	s = 1 / sqrt(x * x + y * y + z * z + w * w);
+
+		out.x[i] = x * s;
+		out.y[i] = y * s;
+		out.z[i] = z * s;
+		out.w[i] = w * s;
+	}
+}
+
+#ifdef QUATERNION_BATCH_AVX2
+static inline __m256
+madd(__m256 a, __m256 b, __m256 c)
+{
+	return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+}
+
+// 8 pairs from i, the scalar weights above in registers
+static inline void
+interpolate8(const QuaternionArray& a, const QuaternionArray& b, const float* t,
+	QuaternionArray& out, bool corrected, int i)
+{
+	const __m256	one = _mm256_set1_ps(1), half = _mm256_set1_ps(0.5f);
+	const __m256	signBit = _mm256_set1_ps(-0.0f);
+
+	__m256	ax = _mm256_loadu_ps(&a.x[i]), ay = _mm256_loadu_ps(&a.y[i]);
+	__m256	az = _mm256_loadu_ps(&a.z[i]), aw = _mm256_loadu_ps(&a.w[i]);
+	__m256	bx = _mm256_loadu_ps(&b.x[i]), by = _mm256_loadu_ps(&b.y[i]);
+	__m256	bz = _mm256_loadu_ps(&b.z[i]), bw = _mm256_loadu_ps(&b.w[i]);
+	__m256	u = _mm256_loadu_ps(t + i);
+
+	__m256	d = madd(ax, bx, madd(ay, by, madd(az, bz, _mm256_mul_ps(aw, bw))));
+	__m256	sign = _mm256_and_ps(d, signBit);
+
+	if (corrected)
+	{
+		__m256	c = _mm256_andnot_ps(signBit, d);
+		__m256	A = madd(c, madd(c, madd(c, _mm256_set1_ps(-1.43519f), _mm256_set1_ps(3.55645f)),
+			_mm256_set1_ps(-3.2452f)), _mm256_set1_ps(1.0904f));
+		__m256	B = madd(c, madd(c, _mm256_set1_ps(0.215638f), _mm256_set1_ps(-1.06021f)),
+			_mm256_set1_ps(0.848013f));
+
+		__m256	h = _mm256_sub_ps(u, half);
+		__m256	k = madd(_mm256_mul_ps(A, h), h, B);
+		u = madd(_mm256_mul_ps(_mm256_mul_ps(u, h), _mm256_sub_ps(u, one)), k, u);
+	}
+
+	__m256	wa = _mm256_sub_ps(one, u);
+	__m256	wb = _mm256_xor_ps(u, sign);
+
+	__m256	x = madd(wa, ax, _mm256_mul_ps(wb, bx));
+	__m256	y = madd(wa, ay, _mm256_mul_ps(wb, by));
+	__m256	z = madd(wa, az, _mm256_mul_ps(wb, bz));
+	__m256	w = madd(wa, aw, _mm256_mul_ps(wb, bw));
+
+	// 1 / |q| by the estimate and a Newton step, s (3 - n s^2) / 2
+	__m256	n = madd(x, x, madd(y, y, madd(z, z, _mm256_mul_ps(w, w))));
+	__m256	s = _mm256_rsqrt_ps(n);
+	s = _mm256_mul_ps(_mm256_mul_ps(half, s), _mm256_sub_ps(_mm256_set1_ps(3), _mm256_mul_ps(n, _mm256_mul_ps(s, s))));
+
+	_mm256_storeu_ps(&out.x[i], _mm256_mul_ps(x, s));
+	_mm256_storeu_ps(&out.y[i], _mm256_mul_ps(y, s));
+	_mm256_storeu_ps(&out.z[i], _mm256_mul_ps(z, s));
+	_mm256_storeu_ps(&out.w[i], _mm256_mul_ps(w, s));
+}
+#endif
+
+void
+interpolateBatch(const QuaternionArray& a, const QuaternionArray& b, const float* t,
+	QuaternionArray& out, BatchInterpolation method)
+{
+	int	n = a.size();
+	out.resize(n);
+
+	int	i = 0;
+#ifdef QUATERNION_BATCH_AVX2
+	if (method != BATCH_SLERP)
+		for (; i + 8 <= n; i += 8) interpolate8(a, b, t, out, method == BATCH_NLERP_CORRECTED, i);
+#endif
+	interpolateScalar(a, b, t, out, method, i, n);
+}
+
+bool
+interpolationSIMD()
+{
+#ifdef QUATERNION_BATCH_AVX2
+	return true;
+#else
+	return false;
+#endif
+}
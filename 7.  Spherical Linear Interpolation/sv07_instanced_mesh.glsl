@@ -0,0 +1,51 @@
+#version 120
+
+// Mesh shared by all the instances
+attribute vec3	vPosition;
+attribute vec3	vNormal;
+
+// Per-instance attributes: glVertexAttribDivisor(location, 1)
+attribute mat4	iModel;
+attribute vec4	iColor;
+
+varying vec4	color;
+
+// Same as the fixed-function lighting with GL_LIGHT0 and the front material,
+// except that the diffuse reflectivity and the alpha come from the instance.
+vec4
+lighting(vec3 P, vec3 N, vec4 Kd)
+{
+	vec4	c = gl_FrontMaterial.ambient * (gl_LightModel.ambient + gl_LightSource[0].ambient);
+
+	// Positional or directional light in the eye coordinate system
+	vec4	lp = gl_LightSource[0].position;
+	vec3	L = normalize(lp.xyz - P * lp.w);
+
+	float	lambertian = max(dot(N, L), 0.0);
+	c.rgb += lambertian * Kd.rgb * gl_LightSource[0].diffuse.rgb;
+
+	// Specular term with the non-local viewer
+	if (lambertian > 0.0)
+	{
+		vec3	H = normalize(L + vec3(0, 0, 1));
+		float	specular = pow(max(dot(N, H), 0.0), gl_FrontMaterial.shininess);
+		c.rgb += specular * gl_FrontMaterial.specular.rgb * gl_LightSource[0].specular.rgb;
+	}
+
+	c.a = Kd.a;
+	return c;
+}
+
+void
+main(void)
+{
+	vec4	P = gl_ModelViewMatrix * (iModel * vec4(vPosition, 1.0));
+
+	// Normalized after the transformation as GL_NORMALIZE does. The normals of a model
+	// matrix that is not a rotation, e.g., of the lerp of rotation matrices, are approximate.
+	vec3	N = normalize(gl_NormalMatrix * (mat3(iModel) * vNormal));
+
+	color = lighting(P.xyz, N, iColor);
+
+	gl_Position = gl_ProjectionMatrix * P;
+}
@@ -0,0 +1,116 @@
+#include "curveTessellation.h"
+
+#include <algorithm>
+using namespace std;
+
+// Distance from p to the line segment from a to b
+static float
+distanceToChord(const Vector3f& p, const Vector3f& a, const Vector3f& b)
+{
+	Vector3f	ab = b - a;
+	float		l2 = ab.squaredNorm();
+	float		t = (l2 > 0) ? min(max((p - a).dot(ab) / l2, 0.0f), 1.0f) : 0;
+
+	return (p - (a + t * ab)).norm();
+}
+
+// Bezier control points b0 to b3, b0 being already in the polyline
+static void
+subdivide(const Vector3f& b0, const Vector3f& b1, const Vector3f& b2, const Vector3f& b3,
+	float tolerance, int depth, vector<Vector3f>& polyline)
+{
+	// Max distance of the convex hull from the chord, at one of the inner control points
+	if (depth == 0 || max(distanceToChord(b1, b0, b3), distanceToChord(b2, b0, b3)) <= tolerance)
+	{
+		polyline.push_back(b3);
+		return;
+	}
+
+	// de Casteljau at t = 1/2
+	Vector3f	b01 = (b0 + b1) / 2, b12 = (b1 + b2) / 2, b23 = (b2 + b3) / 2;
+	Vector3f	b012 = (b01 + b12) / 2, b123 = (b12 + b23) / 2;
+	Vector3f	mid = (b012 + b123) / 2;
+
+	subdivide(b0, b01, b012, mid, tolerance, depth - 1, polyline);
+	subdivide(mid, b123, b23, b3, tolerance, depth - 1, polyline);
+}
+
+void
+tessellateCubic(const CubicCoefficients& c, float tolerance, vector<Vector3f>& polyline, int maxDepth)
+{
+	// Power basis to the Bezier control points
+	Vector3f	c0 = c.row(0).transpose(), c1 = c.row(1).transpose();
+	Vector3f	c2 = c.row(2).transpose(), c3 = c.row(3).transpose();
+
+	Vector3f	b0 = c0;
+	Vector3f	b1 = c0 + c1 / 3;
+	Vector3f	b2 = c0 + (2 * c1 + c2) / 3;
+	Vector3f	b3 = c0 + c1 + c2 + c3;
+
+	polyline.push_back(b0);
+	subdivide(b0, b1, b2, b3, tolerance, maxDepth, polyline);
+}
+
+void
+setTessellationTolerance(CurveTessellation& s, float tolerance)
+{
+	if (s.tolerance == tolerance) return;
+
+	s.tolerance = tolerance;
+	fill(s.valid.begin(), s.valid.end(), false);
+}
+
+void
+resizeTessellation(CurveTessellation& s, int numSegments)
+{
+	for (int i = numSegments; i < int(s.polyline.size()); i++)
+		s.numVertices -= int(s.polyline[i].size());
+
+	s.coefficient.resize(numSegments);
+	s.polyline.resize(numSegments);
+	s.valid.resize(numSegments, false);
+}
+
+void
+shiftTessellation(CurveTessellation& s, int i, int count)
+{
+	int	n = int(s.polyline.size());
+	i = min(max(i, 0), n);
+
+	if (count > 0)
+	{
+		s.coefficient.insert(s.coefficient.begin() + i, count, CubicCoefficients::Zero());
+		s.polyline.insert(s.polyline.begin() + i, count, vector<Vector3f>());
+		s.valid.insert(s.valid.begin() + i, count, false);
+	}
+	else if (count < 0)
+	{
+		int	last = min(i - count, n);
+		for (int k = i; k < last; k++) s.numVertices -= int(s.polyline[k].size());
+
+		s.coefficient.erase(s.coefficient.begin() + i, s.coefficient.begin() + last);
+		s.polyline.erase(s.polyline.begin() + i, s.polyline.begin() + last);
+		s.valid.erase(s.valid.begin() + i, s.valid.begin() + last);
+	}
+}
+
+const vector<Vector3f>&
+tessellateSegment(CurveTessellation& s, int i, const CubicCoefficients& c)
+{
+	if (i >= int(s.polyline.size())) resizeTessellation(s, i + 1);
+
+	vector<Vector3f>&	polyline = s.polyline[i];
+	if (s.valid[i] && s.coefficient[i] == c) return polyline;
+
+	// The capacity of the previous polyline is reused.
+	s.numVertices -= int(polyline.size());
+	polyline.clear();
+	tessellateCubic(c, s.tolerance, polyline);
+	s.numVertices += int(polyline.size());
+
+	s.coefficient[i] = c;
+	s.valid[i] = true;
+	s.numTessellated++;
+
+	return polyline;
+}
@@ -1,6 +1,9 @@
 // ̿   ޸ ϴ  exercise
 
 #include "glSetup.h"
+#include "glBatch.h"
+#include "naturalCubicSpline.h"
+#include "curveTessellation.h"
 
 #include <Eigen/Dense>
 using namespace Eigen;
@@ -11,13 +14,21 @@ using namespace std;
 void init();
 void render(GLFWwindow* window);
 void reshape(GLFWwindow* window, int w, int h);
+void reshapeModernOpenGL(GLFWwindow* window, int w, int h);
 void keyboard(GLFWwindow* window, int key, int scancode, int action, int mods);
+void benchmarkSpline(int n = 1000000);
+void printTessellation();
 
 // Colors
 GLfloat bgColor[4] = { 1,1,1,1 };
 
+// Projection matrix for the batched lines and points
+Matrix4f ProjectionMatrix;
+
 // Controls
 bool sampledPointsEnabled = true;
+bool adaptiveEnabled = true;	// Adaptive tessellation instead of N_SUB_SEGMENTS
+float tolerancePixels = 0.5f;	// Max distance of the tessellation from the curve
 int N_SUB_SEGMENTS = 10; //  Ŀ ׸Ʈ  ø  ?
 
 int main(int argc, char* argv[])
@@ -25,28 +36,44 @@ int main(int argc, char* argv[])
 	// Orthographics viewing
 	perspectiveView = false;
 
-	// Initialize the OpenGL system
-	GLFWwindow* window = initializeOpenGL(argc, argv, bgColor);
+	// Initialize the OpenGL system: true for modern OpenGL
+	GLFWwindow* window = initializeOpenGL(argc, argv, bgColor, true);
 	if (window == NULL) return -1;
 
 	// Callbacks
+	glfwSetFramebufferSizeCallback(window, reshapeModernOpenGL);
 	glfwSetKeyCallback(window, keyboard);
 
 	// Depth Test
 	glDisable(GL_DEPTH_TEST);
 
 	// Viewport and perspective setting
-	reshape(window, windowW, windowH);
+	reshapeModernOpenGL(window, windowW, windowH);
+
+	// Batched lines and points instead of glBegin()/glEnd() in the core profile
+	if (!createBatch("sv08_batch.glsl", "sg08_batch_line.glsl", "sf08_batch.glsl"))
+	{
+		cerr << "ERROR: Failed in createBatch()" << endl;
+		return -1;
+	}
 
 	// Initialization - Main loop - Fianlization
 	init(); //  Ǭ
 
 	while (!glfwWindowShouldClose(window))
 	{
+		beginTiming(TIMING_RENDER);
 		render(window);
-		glfwSwapBuffers(window);
+		endTiming(TIMING_RENDER);
+		swapBuffers(window);
+		beginTiming(TIMING_UPDATE);
 		glfwPollEvents();
+		endTiming(TIMING_UPDATE);
 	}
+
+	// Finalization
+	deleteBatch();
+
 	// Terminate the glfw system
 	glfwDestroyWindow(window);
 	glfwTerminate();
@@ -54,6 +81,26 @@ int main(int argc, char* argv[])
 	return 0;
 }
 
+void reshapeModernOpenGL(GLFWwindow* window, int w, int h)
+{
+	// Window configuration
+	aspect = (float)w / h;
+	windowW = w;
+	windowH = h;
+
+	// Viewport
+	glViewport(0, 0, w, h);
+
+	// Same orthographic projection as setupProjectionMatrix()
+	ProjectionMatrix = orthographic<float>(-1.0 * aspect, 1.0 * aspect, -1.0, 1.0,
+		-nearDist, farDist);
+
+	// The Screen size is required for mouse interaction.
+	glfwGetWindowSize(window, &screenW, &screenH);
+	cerr << "reshape(" << w << "," << h << ")";
+	cerr << " with screen " << screenW << " x " << screenH << endl;
+}
+
 //(x,y,z) of data points
 const int N = 4; // curve segement -> 4
 const float p[N + 1][3] = { // 5  Ʈ
@@ -64,98 +111,35 @@ const float p[N + 1][3] = { // 5
 	{1.2f,0.6f,0}
 };
 
-// Linear system : Ac=b
-//	from n equations of the form:
+// Natural cubic spline of n segments of the form:
 //	p_i(t) = c_0^i + (c_1^i * t^1) + (c_2^i * t^2) + (c_3^i * t^3)
+//	from the tridiagonal system of the second derivatives at the data points
+//	instead of the 4n x 4n system of the coefficients
 //
-MatrixXf A; // 4n x 4n matrix
-MatrixXf b; // 4n x 3 to solve the 3 linear systems at once
-MatrixXf c; // 4n x 3 to solve the 3 linear systems at once
-
-void buildLinearSystem()
-{
-	// Build A and b for N segments. A is independent of the locations of the points.
-	A.resize(4 * N, 4 * N);
-	A.setZero();
-
-	b.resize(4 * N, 3);
-
-	// Equation number
-	int row = 0;
-
-	// 2n equations for the end point interpolation
-	for (int i = 0; i < N; i++, row += 2)
-	{
-		// p_i(0) = c_0^i
-		A(row, 4 * i + 0) = 1;
-
-		b(row, 0) = p[i][0];
-		b(row, 1) = p[i][1];
-		b(row, 2) = p[i][2];
-
-		// p_i(1) = c_0^i + c_1^i + c_2^i + c_3^i
-		A(row + 1, 4 * i + 0) = 1;
-		A(row + 1, 4 * i + 1) = 1;
-		A(row + 1, 4 * i + 2) = 1;
-		A(row + 1, 4 * i + 3) = 1;
-
-		b(row + 1, 0) = p[i + 1][0];
-		b(row + 1, 1) = p[i + 1][1];
-		b(row + 1, 2) = p[i + 1][2];
-	}
-
-	// (n-1) equations for the tangential con
-	for (int i = 0; i < N - 1; i++, row++)
-	{
-		A(row, 4 * i + 1) = 1;
-		A(row, 4 * i + 2) = 2;
-		A(row, 4 * i + 3) = 3;
-		A(row, 4 * i + 5) = -1;
-
-		b(row, 0) = 0;
-		b(row, 1) = 0;
-		b(row, 2) = 0;
-	}
+MatrixXf b; // (n+1) x 3 data points to solve the 3 coordinates at once
+MatrixXf c; // 4n x 3 coefficients, 4(n+1) x 3 for the closed curve
 
-	// (n-1) equations for the second - derivative continuity
-	for (int i = 0; i < N - 1; i++, row++)
-	{
-		A(row, 4 * i + 2) = 2;
-		A(row, 4 * i + 3) = 6;
-		A(row, 4 * i + 6) = -2;
+bool closedCurve = false;
+int numSegments = N;
 
-		b(row, 0) = 0;
-		b(row, 1) = 0;
-		b(row, 2) = 0;
-	}
+// Polylines of the segments, kept until their coefficients change
+CurveTessellation tessellation;
 
-	// 2 equations for the natural boundary condition
+void buildLinearSystem()
+{
+	// The system depends only on the number of the data points.
+	b.resize(N + 1, 3);
+	for (int i = 0; i <= N; i++)
 	{
-		A(row, 2) = 0;
-
-		b(row, 0) = 0;
-		b(row, 1) = 0;
-		b(row, 2) = 0;
-
-		row++;
-
-		// p''_(n-1)(1) = 2*c_2^(n-1) + 6*c_3^(n-1) = 0
-		A(row, 4 * (N - 1) + 2) = 2;
-		A(row, 4 * (N - 1) + 3) = 6;
-
-		b(row, 0) = 0;
-		b(row, 1) = 0;
-		b(row, 2) = 0;
-
-		row++;
+		b(i, 0) = p[i][0];
+		b(i, 1) = p[i][1];
+		b(i, 2) = p[i][2];
 	}
-
 }
 
-
 void solveLinearSystem()
 {
-	c = A.colPivHouseholderQr().solve(b);
+	numSegments = solveNaturalCubicSpline(b, c, closedCurve);
 }
 
 void init()
@@ -167,7 +151,10 @@ void init()
 	// Usage
 	cout << endl;
 	cout << "Keyboard Input: s for sampled points on/off" << endl;
-	cout << "Keyboard Input: up/down to increase/decrease the number of samples" << endl;
+	cout << "Keyboard Input: t for adaptive/uniform tessellation" << endl;
+	cout << "Keyboard Input: up/down to increase/decrease the number of samples or the tolerance" << endl;
+	cout << "Keyboard Input: c for open/closed curve" << endl;
+	cout << "Keyboard Input: b for the benchmark of 10^6 data points" << endl;
 	cout << "Keyboard Input: q/esc for quit" << endl;
 
 }
@@ -181,64 +168,111 @@ Vector3f pointOnNaturalCubicSplineCurve(int i, float t)
 	return Vector3f(x, y, z);
 }
 
+// Polyline of the segment i, adaptive within tolerancePixels or of N_SUB_SEGMENTS lines
+const vector<Vector3f>& segmentPolyline(int i)
+{
+	if (adaptiveEnabled)
+	{
+		CubicCoefficients coefficient = c.block<4, 3>(4 * i, 0);
+		return tessellateSegment(tessellation, i, coefficient);
+	}
+
+	static vector<Vector3f> uniform;
+	uniform.clear();
+	for (int j = 0; j <= N_SUB_SEGMENTS; j++)
+	{
+		float t = (float)j / N_SUB_SEGMENTS; //[0,1]
+		uniform.push_back(pointOnNaturalCubicSplineCurve(i, t));
+	}
+	return uniform;
+}
+
 // Draw the natural cubic spline
 void drawNaturalCubicSpline()
 {
+	// 2 / windowH per pixel in the orthographic view
+	setTessellationTolerance(tessellation, tolerancePixels * 2 / windowH);
+	resizeTessellation(tessellation, numSegments);
 
-	for (int i = 0; i < N; i++)
+	for (int i = 0; i < numSegments; i++)
 	{
-		// N_SUB_SEGMENTS for each curve segment
-		
-		// ̺ :
-		// midpoint rule : ( 0+1 )/2 = 1/2, 1-0 = 1
-		// t = 1/2   . c = 4n x 3 ̴.
-	
-		float x = c(4 * i + 1, 0) + (2*c(4 * i + 2, 0) + 3*c(4 * i + 3, 0) * 0.5)  * 0.5;
-		float y = c(4 * i + 1, 1) + (2*c(4 * i + 2, 1) + 3*c(4 * i + 3, 1) * 0.5)  * 0.5;
-		float z = c(4 * i + 1, 2) +  (2*c(4 * i + 2, 2) + 3*c(4 * i + 3, 2) * 0.5)  * 0.5;
-		
-		Vector3f vec(x,y,z);
-
-		float L =sqrt(vec.dot(vec)); // L Ŀ .
-
-		N_SUB_SEGMENTS =int(L *5 );
-		
+		const vector<Vector3f>& polyline = segmentPolyline(i);
+
 		// Curve
-		glLineWidth(1.5f * dpiScaling);
-		glColor3f(0, 0, 0);
-		glBegin(GL_LINE_STRIP);
+		batchLineWidth(1.5f * dpiScaling);
+		batchColor(0, 0, 0);
+		batchBegin(GL_LINE_STRIP);
+		for (int j = 0; j < int(polyline.size()); j++)
+			batchVertex(polyline[j].data());
+		batchEnd();
+
+		// Sample points at the curve
+		if (!sampledPointsEnabled) continue;
+
+		batchPointSize(5 * dpiScaling);
+		batchColor(0, 0, 0);
+		batchBegin(GL_POINTS);
+		for (int j = 1; j + 1 < int(polyline.size()); j++)
+			batchVertex(polyline[j].data());
+		batchEnd();
+	}
 
-		for (int j = 0; j <= N_SUB_SEGMENTS; j++)
-		{
-			float t = (float)j / N_SUB_SEGMENTS; //[0,1]
-			Vector3f p = pointOnNaturalCubicSplineCurve(i, t);
+	// dATA POINTS
+	batchPointSize(10 * dpiScaling);
+	batchColor(1, 0, 0);
+	batchBegin(GL_POINTS);
+	for (int i = 0; i < N + 1; i++)
+		batchVertex(p[i]);
+	batchEnd();
+}
 
-			glVertex3fv(p.data());
-		}
-		glEnd();
-
-		glPointSize(5 * dpiScaling);
-		glColor3f(0, 0, 0);
-		glBegin(GL_POINTS);
-		
-		// N_SUB_SEGMENTS for each curve segment
-		for (int j = 1; j < N_SUB_SEGMENTS; j++)
-		{
-			float		t = (float)j / N_SUB_SEGMENTS;
-			Vector3f	p = pointOnNaturalCubicSplineCurve(i, t);
+// Open and closed splines through n random points, and the max jumps of the position and
+// the first and second derivatives at the joints of the segments
+void benchmarkSpline(int n)
+{
+	const int	runs = 5;
+
+	MatrixXf	point = MatrixXf::Random(n, 3), coefficient;
 
-			glVertex3fv(p.data());
+	cout << endl << "Spline: " << n << " data points" << endl;
+	for (int closed = 0; closed < 2; closed++)
+	{
+		int		segments = 0;
+		double	start = glfwGetTime();
+		for (int r = 0; r < runs; r++) segments = solveNaturalCubicSpline(point, coefficient, closed != 0);
+		double	seconds = (glfwGetTime() - start) / runs;
+
+		float	jump = 0;
+		for (int i = 0; i < segments; i++)
+		{
+			int	j = i + 1;
+			if (j == segments)
+			{
+				if (!closed) break;
+				j = 0;
+			}
+
+			RowVectorXf	c0 = coefficient.row(4 * i), c1 = coefficient.row(4 * i + 1);
+			RowVectorXf	c2 = coefficient.row(4 * i + 2), c3 = coefficient.row(4 * i + 3);
+
+			jump = max(jump, (c0 + c1 + c2 + c3 - coefficient.row(4 * j)).cwiseAbs().maxCoeff());
+			jump = max(jump, (c1 + 2 * c2 + 3 * c3 - coefficient.row(4 * j + 1)).cwiseAbs().maxCoeff());
+			jump = max(jump, (2 * c2 + 6 * c3 - 2 * coefficient.row(4 * j + 2)).cwiseAbs().maxCoeff());
 		}
-		glEnd();
+
+		cout << "  " << (closed ? "Closed" : "Open") << ": " << seconds * 1000.0 << " ms, "
+			<< segments << " segments, max jump at the joints " << jump << endl;
 	}
+}
 
-	// dATA POINTS
-	glPointSize(10 * dpiScaling);
-	glColor3f(1, 0, 0);
-	glBegin(GL_POINTS);
-	for (int i = 0; i < N + 1; i++)
-		glVertex3f(p[i][0], p[i][1], p[i][2]);
-	glEnd();
+void printTessellation()
+{
+	if (adaptiveEnabled)
+		cout << "Tessellation: adaptive within " << tolerancePixels << " pixels, "
+			<< tessellation.numVertices << " vertices for " << numSegments
+			<< " segments in the last frame" << endl;
+	else
+		cout << "Tessellation: uniform, " << N_SUB_SEGMENTS << " lines per segment" << endl;
 }
 
 void render(GLFWwindow* window)
@@ -247,12 +281,11 @@ void render(GLFWwindow* window)
 	glClearColor(bgColor[0], bgColor[1], bgColor[2], bgColor[3]);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	// Modelview matrix
-	glMatrixMode(GL_MODELVIEW);
-	glLoadIdentity();
-
 	// Draw the natural cubic spline curve
 	drawNaturalCubicSpline();
+
+	// All the lines and points with one upload
+	batchFlush(ProjectionMatrix.data());
 }
 
 void keyboard(GLFWwindow* window, int key, int scancode, int action, int mods)
@@ -265,8 +298,25 @@ void keyboard(GLFWwindow* window, int key, int scancode, int action, int mods)
 		case GLFW_KEY_S: sampledPointsEnabled = !sampledPointsEnabled; break;
 
 			// Number of samples
-		case GLFW_KEY_UP: N_SUB_SEGMENTS++; break;
-		case GLFW_KEY_DOWN: N_SUB_SEGMENTS = max(N_SUB_SEGMENTS - 1, 1); break;
+		case GLFW_KEY_UP:
+			if (adaptiveEnabled) tolerancePixels = max(tolerancePixels / 2, 1.0f / 64);
+			else N_SUB_SEGMENTS++;
+			printTessellation();
+			break;
+		case GLFW_KEY_DOWN:
+			if (adaptiveEnabled) tolerancePixels = min(tolerancePixels * 2, 64.0f);
+			else N_SUB_SEGMENTS = max(N_SUB_SEGMENTS - 1, 1);
+			printTessellation();
+			break;
+
+			// Adaptive/uniform tessellation
+		case GLFW_KEY_T: adaptiveEnabled = !adaptiveEnabled; printTessellation(); break;
+
+			// Open/closed curve
+		case GLFW_KEY_C: closedCurve = !closedCurve; solveLinearSystem(); break;
+
+			// Benchmark
+		case GLFW_KEY_B: benchmarkSpline(); break;
 
 			// Quit
 		case GLFW_KEY_Q:
@@ -0,0 +1,163 @@
+#include "naturalCubicSpline.h"
+
+#include <algorithm>
+#include <vector>
+using namespace std;
+
+void
+solveTridiagonal(const VectorXf& lower, const VectorXf& diag, const VectorXf& upper, MatrixXf& d)
+{
+	int	n = int(diag.size());
+	if (n == 0) return;
+
+	// Forward elimination with the modified super-diagonal, every column in the same pass
+	vector<float>	u(n);
+	float*			x = d.data();
+	int				m = int(d.cols()), ld = int(d.rows());
+
+	float	s = 1 / diag[0];
+	u[0] = upper[0] * s;
+	for (int k = 0; k < m; k++) x[k * ld] *= s;
+
+	for (int i = 1; i < n; i++)
+	{
+		s = 1 / (diag[i] - lower[i] * u[i - 1]);
+		u[i] = upper[i] * s;
+		for (int k = 0; k < m; k++) x[i + k * ld] = (x[i + k * ld] - lower[i] * x[i - 1 + k * ld]) * s;
+	}
+
+	// Back substitution
+	for (int i = n - 2; i >= 0; i--)
+	{
+		for (int k = 0; k < m; k++) x[i + k * ld] -= u[i] * x[i + 1 + k * ld];
+	}
+}
+
+void
+solveTridiagonal(float lower, float diag, float upper, MatrixXf& d)
+{
+	int	n = int(d.rows());
+	if (n == 0) return;
+
+	// The modified super-diagonal u_i = upper / (diag - lower u_i-1) converges to a constant
+	// in a few rows, after which it is not stored.
+	vector<float>	u;
+	float*			x = d.data();
+	int				m = int(d.cols()), ld = n;
+
+	float	ui = upper / diag, s = 1 / diag;
+	u.push_back(ui);
+	for (int k = 0; k < m; k++) x[k * ld] *= s;
+
+	bool	converged = false;
+	for (int i = 1; i < n; i++)
+	{
+		if (!converged)
+		{
+			s = 1 / (diag - lower * ui);
+			float	next = upper * s;
+			converged = (next == ui);
+			ui = next;
+			u.push_back(ui);
+		}
+		for (int k = 0; k < m; k++) x[i + k * ld] = (x[i + k * ld] - lower * x[i - 1 + k * ld]) * s;
+	}
+
+	int	last = int(u.size()) - 1;
+	for (int i = n - 2; i >= 0; i--)
+	{
+		float	w = u[min(i, last)];
+		for (int k = 0; k < m; k++) x[i + k * ld] -= w * x[i + 1 + k * ld];
+	}
+}
+
+void
+solveCyclicTridiagonal(const VectorXf& lower, const VectorXf& diag, const VectorXf& upper, MatrixXf& d)
+{
+	int	n = int(diag.size());
+
+	// A = B + u v^T with u = (gamma, 0, ..., 0, alpha) and v = (1, 0, ..., 0, beta / gamma)
+	float	alpha = upper[n - 1], beta = lower[0], gamma = -diag[0];
+
+	VectorXf	b = diag;
+	b[0] -= gamma;
+	b[n - 1] -= alpha * beta / gamma;
+
+	MatrixXf	z = MatrixXf::Zero(n, 1);
+	z(0, 0) = gamma;
+	z(n - 1, 0) = alpha;
+
+	solveTridiagonal(lower, b, upper, d);
+	solveTridiagonal(lower, b, upper, z);
+
+	// x = y - z (v . y) / (1 + v . z)
+	float	vz = 1 + z(0, 0) + beta * z(n - 1, 0) / gamma;
+	for (int k = 0; k < d.cols(); k++)
+	{
+		float	f = (d(0, k) + beta * d(n - 1, k) / gamma) / vz;
+		d.col(k) -= f * z.col(0);
+	}
+}
+
+int
+solveNaturalCubicSpline(const MatrixXf& point, MatrixXf& c, bool closed)
+{
+	int	n = int(point.rows());
+	int	dim = int(point.cols());
+	if (n < 3) closed = false;
+
+	int	numSegments = closed ? n : n - 1;
+	if (numSegments < 1)
+	{
+		c.resize(0, dim);
+		return 0;
+	}
+
+	// Second derivatives of all the points, zero at the ends of an open curve. The right-hand
+	// sides of an open curve are those of the interior points only.
+	int			numUnknowns = closed ? n : max(n - 2, 0);
+	int			first = closed ? 0 : 1;
+	MatrixXf	M(numUnknowns, dim);
+	for (int k = 0; k < dim; k++)
+	{
+		const float*	p = point.col(k).data();
+		float*			r = M.col(k).data();
+		for (int i = 0; i < numUnknowns; i++)
+		{
+			int	j = first + i;
+			int	previous = (j > 0) ? j - 1 : n - 1, next = (j + 1 < n) ? j + 1 : 0;
+			r[i] = 6 * (p[previous] - 2 * p[j] + p[next]);
+		}
+	}
+
+	if (closed)
+	{
+		VectorXf	one = VectorXf::Ones(n);
+		solveCyclicTridiagonal(one, VectorXf::Constant(n, 4), one, M);
+	}
+	else
+	{
+		solveTridiagonal(1, 4, 1, M);
+	}
+
+	c.resize(4 * numSegments, dim);
+	for (int k = 0; k < dim; k++)
+	{
+		const float*	p = point.col(k).data();
+		const float*	m = M.col(k).data();
+		float*			q = c.col(k).data();
+		for (int i = 0; i < numSegments; i++)
+		{
+			int		j = (i + 1 < n) ? i + 1 : 0;
+			float	mi = (i >= first && i - first < numUnknowns) ? m[i - first] : 0;
+			float	mj = (j >= first && j - first < numUnknowns) ? m[j - first] : 0;
+
+			q[4 * i + 0] = p[i];
+			q[4 * i + 1] = p[j] - p[i] - (2 * mi + mj) / 6;
+			q[4 * i + 2] = mi / 2;
+			q[4 * i + 3] = (mj - mi) / 6;
+		}
+	}
+
+	return numSegments;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#ifndef __NATURAL_CUBIC_SPLINE_H_
+#define __NATURAL_CUBIC_SPLINE_H_
+
+#include <Eigen/Dense>
+using namespace Eigen;
+
+// Natural cubic splines by the second derivatives
+//
+// With the unit parameter interval of every segment, as in the 4n x 4n system of the
+// coefficients, the second derivatives M_i at the data points p_i satisfy
+//   M_i-1 + 4 M_i + M_i+1 = 6 (p_i-1 - 2 p_i + p_i+1)
+// with M_0 = M_n = 0 for an open curve, and the indices wrapping around for a closed one.
+// The tridiagonal system takes O(n) time and memory, and each segment is then
+//   c_0 = p_i,	c_1 = p_i+1 - p_i - (2 M_i + M_i+1) / 6,	c_2 = M_i / 2,	c_3 = (M_i+1 - M_i) / 6
+// in the same 4n x 3 layout as the solution of the dense system.
+
+// Thomas algorithm for the tridiagonal A of the sub-, main and super-diagonals, solving
+// A x = d for all the columns of d at once in place. lower[0] and upper[n-1] are not used.
+// There is no pivoting, which is stable for a diagonally dominant A as of the splines.
+void	solveTridiagonal(const VectorXf& lower, const VectorXf& diag, const VectorXf& upper,
+	MatrixXf& d);
+
+// Constant diagonals, e.g., of the splines, in O(1) extra memory
+void	solveTridiagonal(float lower, float diag, float upper, MatrixXf& d);
+
+// Cyclic tridiagonal A with the corners A(0, n-1) = lower[0] and A(n-1, 0) = upper[n-1],
+// by the Sherman-Morrison formula on top of two Thomas solves. n >= 3.
+void	solveCyclicTridiagonal(const VectorXf& lower, const VectorXf& diag, const VectorXf& upper,
+	MatrixXf& d);
+
+// Coefficients c of the segments through the data points, a row each, with the rows 4i to
+// 4i+3 for p_i(t) = c_0 + c_1 t + c_2 t^2 + c_3 t^3 and t in [0, 1]. A closed curve has a
+// segment from the last point back to the first as well. Returns the # of the segments.
+int		solveNaturalCubicSpline(const MatrixXf& point, MatrixXf& c, bool closed = false);
+
+#endif	// __NATURAL_CUBIC_SPLINE_H_
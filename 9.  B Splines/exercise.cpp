@@ -1,4 +1,5 @@
 #include "glSetup.h"
+#include "glBatch.h"
 #include "hsv2rgb.h"
 
 #include <Eigen/Dense>
@@ -11,6 +12,7 @@ using namespace std;
 void init();
 void render(GLFWwindow* window);
 void reshape(GLFWwindow* window, int w, int h);
+void reshapeModernOpenGL(GLFWwindow* window, int w, int h);
 void keyboard(GLFWwindow* window, int key, int scancode, int action, int mods);
 
 // Endpoint interpolation
@@ -23,6 +25,9 @@ void drawControlPolygon();
 // Colors
 GLfloat bgColor[4] = { 1,1,1,1 };
 
+// Projection matrix for the batched lines and points
+Matrix4f ProjectionMatrix;
+
 // Controls
 bool samplePointDrawingEnabled = false;
 int N_SUB_SEGMENTS = 10;
@@ -35,39 +40,49 @@ int main(int argc, char* argv[])
 	// Orthographics viewing
 	perspectiveView = false;
 
-	// Initialize the OpenGL system
-	GLFWwindow* window = initializeOpenGL(argc, argv, bgColor);
+	// Initialize the OpenGL system: true for modern OpenGL
+	GLFWwindow* window = initializeOpenGL(argc, argv, bgColor, true);
 	if (window == NULL) return -1;
 
 	// Callbacks
+	glfwSetFramebufferSizeCallback(window, reshapeModernOpenGL);
 	glfwSetKeyCallback(window, keyboard);
 
 	// Depth Test
 	glDisable(GL_DEPTH_TEST);
 
-	// Normal vectors are normalized after transformation
-	glEnable(GL_NORMALIZE);
-
 	// Back face culling
 	glEnable(GL_CULL_FACE);
 	glCullFace(GL_BACK);
 	glFrontFace(GL_CCW);
 
 	// Viewport and perspective setting
-	reshape(window, windowW, windowH);
+	reshapeModernOpenGL(window, windowW, windowH);
+
+	// Batched lines and points instead of glBegin()/glEnd() in the core profile
+	if (!createBatch("sv09_batch.glsl", "sg09_batch_line.glsl", "sf09_batch.glsl"))
+	{
+		cerr << "ERROR: Failed in createBatch()" << endl;
+		return -1;
+	}
 
 	// Initialization - Main loop - Fianlization
 	init(); //  Ǭ
 
 	while (!glfwWindowShouldClose(window))
 	{
+		beginTiming(TIMING_RENDER);
 		render(window);
-		glfwSwapBuffers(window);
+		endTiming(TIMING_RENDER);
+		swapBuffers(window);
+		beginTiming(TIMING_UPDATE);
 		glfwPollEvents();
+		endTiming(TIMING_UPDATE);
 	}
 
 	// Finalization
 	deleteRepeatedControlPoints();
+	deleteBatch();
 
 	// Terminate the glfw system
 	glfwDestroyWindow(window);
@@ -76,6 +91,26 @@ int main(int argc, char* argv[])
 	return 0;
 }
 
+void reshapeModernOpenGL(GLFWwindow* window, int w, int h)
+{
+	// Window configuration
+	aspect = (float)w / h;
+	windowW = w;
+	windowH = h;
+
+	// Viewport
+	glViewport(0, 0, w, h);
+
+	// Same orthographic projection as setupProjectionMatrix()
+	ProjectionMatrix = orthographic<float>(-1.0 * aspect, 1.0 * aspect, -1.0, 1.0,
+		-nearDist, farDist);
+
+	// The Screen size is required for mouse interaction.
+	glfwGetWindowSize(window, &screenW, &screenH);
+	cerr << "reshape(" << w << "," << h << ")";
+	cerr << " with screen " << screenW << " x " << screenH << endl;
+}
+
 //(x,y,z) of data points
 const int N = 8; // curve segement -> 4
 const float p[N][3] = { // 5  Ʈ
@@ -161,58 +196,58 @@ void drawBSpline()
 		// To make an alternating complementary color
 		hsv[0] = 180.0f * i / (nControlPoints - 3) + ((i % 2) ? 180.0f : 0);
 		HSV2RGB(hsv, rgb);
-		glColor3f(rgb[0], rgb[1], rgb[2]);
+		batchColor(rgb);
 
 		if (ctrlPolygonDrawingEnabled && i == iSegment)
-			glLineWidth(3 * dpiScaling); // ctrl polygon ׸  β
-		else  glLineWidth(1.5f * dpiScaling);
+			batchLineWidth(3 * dpiScaling); // ctrl polygon ׸  β
+		else  batchLineWidth(1.5f * dpiScaling);
 
 		for (int j = 0; j < 4; j++)
 			b[j] = controlPoints[i + j];
 
-		glBegin(GL_LINE_STRIP);
+		batchBegin(GL_LINE_STRIP);
 		for (int j = 0; j <= N_SUB_SEGMENTS; j++)
 		{
 			float t = (float)j / N_SUB_SEGMENTS;
 			Vector3f pt = pointOnBspline(b, t);
 
-			glVertex3fv(pt.data());
+			batchVertex(pt.data());
 		}
-		glEnd();
+		batchEnd();
 	}
 
 	// Sample points at the curve
 	if (samplePointDrawingEnabled)
 	{
-		glPointSize(5 * dpiScaling);
+		batchPointSize(5 * dpiScaling);
 		for (int i = 0; i < nControlPoints - 3; i++)
 		{
 			hsv[0] = 180.0f * i / (nControlPoints - 3) + ((i % 2) ? 180.0f : 0);
 			HSV2RGB(hsv, rgb);
-			glColor3f(rgb[0], rgb[1], rgb[2]);
+			batchColor(rgb);
 
 			for (int j = 0; j < 4; j++)
 				b[j] = controlPoints[i + j];
 
-			glBegin(GL_POINTS);
+			batchBegin(GL_POINTS);
 			for (int j = 0; j <= N_SUB_SEGMENTS; j++)
 			{
 				float t = (float)j / N_SUB_SEGMENTS;
 				Vector3f pt = pointOnBspline(b, t);
 
-				glVertex3fv(pt.data());
+				batchVertex(pt.data());
 			}
-			glEnd();
+			batchEnd();
 		}
 	}
 
 	// Control points
-	glPointSize(10 * dpiScaling);
-	glColor3f(1, 0, 0);
-	glBegin(GL_POINTS);
+	batchPointSize(10 * dpiScaling);
+	batchColor(1, 0, 0);
+	batchBegin(GL_POINTS);
 	for (int i = 0; i < N + 1; i++)
-		glVertex3f(p[i][0], p[i][1], p[i][2]);
-	glEnd();
+		batchVertex(p[i]);
+	batchEnd();
 
 	// Control polygon => exercise
 	
@@ -221,22 +256,21 @@ void drawBSpline()
 
 void drawControlPolygon()
 {
-	glPointSize(5 * dpiScaling);
+	batchPointSize(5 * dpiScaling);
 	// Colors
 	float hsv[3] = { 0,1,1 };// [0,360] (degree), [0,1], [0,1]
 	float rgb[3];
-	glEnable(GL_LINE_STIPPLE);
 	hsv[0] = 180.0f * iSegment / (nControlPoints - 3) + ((iSegment % 2) ? 180.0f : 0);
 	HSV2RGB(hsv, rgb);
-	glColor3f(rgb[0], rgb[1], rgb[2]);
+	batchColor(rgb);
 
-	glLineStipple(2,0x00FF);
-	glBegin(GL_LINE_STRIP);
+	batchLineStipple(2,0x00FF);
+	batchBegin(GL_LINE_STRIP);
 	for (int j = 0; j < 4; j++)
-		glVertex3fv(controlPoints[iSegment + j].data());
-	glEnd();
+		batchVertex(controlPoints[iSegment + j].data());
+	batchEnd();
 
-	glDisable(GL_LINE_STIPPLE);
+	batchLineStipple(1, 0xFFFF);
 }
 
 void render(GLFWwindow* window)
@@ -245,11 +279,10 @@ void render(GLFWwindow* window)
 	glClearColor(bgColor[0], bgColor[1], bgColor[2], bgColor[3]);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	// Modelview matrix
-	glMatrixMode(GL_MODELVIEW);
-	glLoadIdentity();
-
 	drawBSpline();
+
+	// All the lines and points with one upload
+	batchFlush(ProjectionMatrix.data());
 }
 
 void keyboard(GLFWwindow* window, int key, int scancode, int action, int mods)
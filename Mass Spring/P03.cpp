@@ -1,4 +1,6 @@
 #include "glSetup.h"
+#include "glSphere.h"
+#include "glBatch.h"
 
 #include <Eigen/Dense>
 
@@ -185,6 +187,20 @@ GLfloat bgColor[4] = { 1,1,1,1 };
 // Sphere
 GLUquadricObj* sphere = NULL;
 
+// Sphere rendering: one draw call for all the particles except for the quadrics
+enum SphereRendering
+{
+	QUADRIC_SPHERES = 0,
+	INSTANCED_MESH,
+	IMPOSTORS,			// Ray-cast billboards of 4 vertices
+};
+SphereRendering sphereRendering = INSTANCED_MESH;	// Toggled with v
+const char*	sphereRenderingName[3] = { "quadric", "instanced mesh", "impostor" };
+InstancedSpheres	spheres;
+vector<Vector3f>	instancePos;		// Positions gathered from the particles
+vector<Vector3f>	instanceColor;		// Colors uploaded last
+vector<float>		instanceRadius;
+
 bool usePointDamping = true; 
 bool useSpringDamping = false;
 float damping = 0.01f;
@@ -255,6 +271,7 @@ int main(int argc, char* argv[])
 	float elapsed = 0;
 	while (!glfwWindowShouldClose(window))
 	{
+		beginTiming(TIMING_UPDATE);
 		glfwPollEvents(); // Events
 
 		// Time passed during a single loop
@@ -264,7 +281,9 @@ int main(int argc, char* argv[])
 
 		// Time passed after the previous frame
 		elapsed += delta;
+		endTiming(TIMING_UPDATE);
 
+		beginTiming(TIMING_SIMULATE);
 		// Deal with the current frame
 		if (elapsed > timeStep)
 		{
@@ -272,9 +291,12 @@ int main(int argc, char* argv[])
 
 			elapsed = 0; // Rest the elapsed time
 		}
+		endTiming(TIMING_SIMULATE);
 
+		beginTiming(TIMING_RENDER);
 		render(window);
-		glfwSwapBuffers(window);
+		endTiming(TIMING_RENDER);
+		swapBuffers(window);
 	}
 
 	//Finalization
@@ -341,6 +363,12 @@ void quit()
 {
 	// Delete quadric shapes
 	gluDeleteQuadric(sphere);
+
+	// Delete the instanced spheres
+	deleteInstancedSpheres(spheres);
+
+	// Delete the batched lines
+	deleteBatch();
 }
 
 void update(float delta_t)
@@ -470,27 +498,59 @@ void render(GLFWwindow* window)
 	setupMaterial();
 
 	// Particles
-	for (int i = 0; i < nParticles; i++)
+	if (sphereRendering != QUADRIC_SPHERES && nParticles > 0)
 	{
-		glPushMatrix();
-		glTranslatef(particles[i].pos[0], particles[i].pos[1], 0);
-		if (particles[i].constrained) drawSphere(radius, Vector3f(1, 1, 0), 20);
-		else                drawSphere(radius, Vector3f(0, 1, 0), 20);
-		glPopMatrix();
+		// The radii and colors only when the # of the particles or a constraint has changed
+		bool	resized = (spheres.numInstances != nParticles);
+		bool	recolored = resized;
+
+		instancePos.resize(nParticles);
+		instanceColor.resize(nParticles);
+		if (resized) instanceRadius.assign(nParticles, radius);
+		for (int i = 0; i < nParticles; i++)
+		{
+			instancePos[i] = Vector3f(particles[i].pos[0], particles[i].pos[1], 0);
+
+			Vector3f	color = particles[i].constrained ? Vector3f(1, 1, 0) : Vector3f(0, 1, 0);
+			if (resized || color != instanceColor[i])
+			{
+				instanceColor[i] = color;
+				recolored = true;
+			}
+		}
+
+		uploadInstances(spheres, nParticles, instancePos[0].data(),
+			resized ? instanceRadius.data() : NULL, recolored ? instanceColor[0].data() : NULL);
+
+		if (sphereRendering == INSTANCED_MESH)	drawInstancedSpheres(spheres);
+		else									drawSphereImpostors(spheres);
+	}
+	else if (sphereRendering == QUADRIC_SPHERES)
+	{
+		for (int i = 0; i < nParticles; i++)
+		{
+			glPushMatrix();
+			glTranslatef(particles[i].pos[0], particles[i].pos[1], 0);
+			if (particles[i].constrained) drawSphere(radius, Vector3f(1, 1, 0), 20);
+			else                drawSphere(radius, Vector3f(0, 1, 0), 20);
+			glPopMatrix();
+		}
 	}
 
-	// Edges
+	// Edges with one upload and one draw call
 	if (nEdges > 0) {
-		glLineWidth(7 * dpiScaling);
-		glColor3f(0, 0, 1);
-		glBegin(GL_LINES);
+		batchLineWidth(7 * dpiScaling);
+		batchColor(0, 0, 1);
+		batchBegin(GL_LINES);
 		for (int i = 0; i < nEdges; i++)
 		{
-			glVertex3fv(particles[e1[i]].pos.data());
-			glVertex3fv(particles[e2[i]].pos.data());
+			batchVertex(particles[e1[i]].pos.data());
+			batchVertex(particles[e2[i]].pos.data());
 		}
-		glEnd();
+		batchEnd();
 	}
+
+	batchFlush(NULL);
 }
 
 void keyboard(GLFWwindow* window, int key, int scancode, int action, int mods)
@@ -542,6 +602,12 @@ void keyboard(GLFWwindow* window, int key, int scancode, int action, int mods)
 		case GLFW_KEY_N: interactMode = NAIL; cout << "Mode is Nail\n";  break;
 		case GLFW_KEY_R: interactMode = DRAG; cout << "Mode is Drag\n";  break;
 
+			// Rendering
+		case GLFW_KEY_V:
+			if (spheres.program) sphereRendering = SphereRendering((sphereRendering + 1) % 3);
+			cout << "Sphere rendering: " << sphereRenderingName[sphereRendering] << endl;
+			break;
+
 			// Constraints
 		case GLFW_KEY_1:  N_SUBSTEPS = 1; break;
 		case GLFW_KEY_2:  N_SUBSTEPS = 2; break;
@@ -567,6 +633,20 @@ init()
 	gluQuadricOrientation(sphere, GLU_OUTSIDE);
 	gluQuadricTexture(sphere, GL_FALSE);
 
+	// Instanced spheres and impostors falling back to the quadrics when unsupported
+	if (!createInstancedSpheres(spheres, 20, "sv11_instanced_sphere.glsl",
+		"sf11_instanced_sphere.glsl") ||
+		!createSphereImpostors(spheres, "sv11_sphere_impostor.glsl", "sf11_sphere_impostor.glsl"))
+	{
+		cerr << "Instanced spheres are not available" << endl;
+		deleteInstancedSpheres(spheres);
+		sphereRendering = QUADRIC_SPHERES;
+	}
+
+	// Batched edges drawn in the immediate mode when the shaders are unsupported
+	if (!createBatch("sv11_batch.glsl", "sg11_batch_line.glsl", "sf11_batch.glsl"))
+		cerr << "Batched lines fall back to the immediate mode" << endl;
+
 	// Keyboard and mouse
 	cout << "Keyboard input: space for play/pause" << endl;
 	cout << "Keyboard Input: g for gravity on/off" << endl;
@@ -579,6 +659,7 @@ init()
 	cout << "Keyboard Input: [1:4] for constraint specification" << endl;
 	cout << "Keyboard Input: up/down to increase/decrease the spring constant" << endl;
 	cout << "Keyboard Input: left/right to increase/decrease the damping constant" << endl;
+	cout << "Keyboard Input: v for quadric/instanced mesh/impostor spheres" << endl;
 }
 
 // Light
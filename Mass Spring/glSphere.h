@@ -0,0 +1,66 @@
+#pragma once
+
+#ifndef __GL_SPHERE_H_
+#define __GL_SPHERE_H_
+
+#include "glShader.h"
+
+// Instanced spheres
+//
+// One unit sphere mesh is uploaded once, and all the spheres are drawn with a single
+// glDrawElementsInstanced() call reading per-instance position, radius and color buffers.
+// The shaders read the fixed-function matrices and GL_LIGHT0/material states, so that
+// setupLight() and setupMaterial() keep working in the compatibility profile.
+//
+// The same instances can be drawn as ray-cast impostors instead: a 4-vertex billboard
+// per sphere whose fragment shader intersects the sphere and writes its depth and normal.
+struct InstancedSpheres
+{
+	GLuint	program, vertexShader, fragmentShader;
+	GLuint	impostorProgram, impostorVS, impostorFS;
+
+	GLuint	vao;			// Vertex array object
+	GLuint	indexId;		// Buffer for triangle indices
+	GLuint	vertexId;		// Buffer for vertex positions of the unit sphere
+	GLuint	normalId;		// Buffer for normal vectors of the unit sphere
+
+	GLuint	impostorVao;	// Vertex array object for the impostors
+	GLuint	cornerId;		// Buffer for the 4 billboard corners
+
+	GLuint	positionId;		// Per-instance center positions (3 floats)
+	GLuint	radiusId;		// Per-instance radii (1 float)
+	GLuint	colorId;		// Per-instance diffuse colors (3 floats)
+
+	int		numTris;		// # of triangles in the unit sphere
+	int		numInstances;	// # of spheres uploaded
+
+	InstancedSpheres()
+	{
+		program = vertexShader = fragmentShader = 0;
+		impostorProgram = impostorVS = impostorFS = 0;
+		vao = indexId = vertexId = normalId = 0;
+		impostorVao = cornerId = 0;
+		positionId = radiusId = colorId = 0;
+		numTris = numInstances = 0;
+	}
+};
+
+// N slices and N stacks as in gluSphere(sphere, radius, N, N)
+bool	createInstancedSpheres(InstancedSpheres& s, int N,
+	const char* vertexShaderFile, const char* fragmentShaderFile);
+
+// Billboard impostors sharing the per-instance buffers with the mesh spheres.
+// It can be used alone without createInstancedSpheres().
+bool	createSphereImpostors(InstancedSpheres& s,
+	const char* vertexShaderFile, const char* fragmentShaderFile);
+
+// Upload n instances. The radius or color may be NULL to keep the previous contents,
+// which is valid only when n does not change.
+void	uploadInstances(InstancedSpheres& s, int n, const float* position,
+	const float* radius, const float* color);
+
+void	drawInstancedSpheres(const InstancedSpheres& s);
+void	drawSphereImpostors(const InstancedSpheres& s);
+void	deleteInstancedSpheres(InstancedSpheres& s);
+
+#endif	// __GL_SPHERE_H_
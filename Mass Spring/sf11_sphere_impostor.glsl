@@ -0,0 +1,62 @@
+#version 120
+
+varying vec3	position;
+varying vec3	center;
+varying float	radius;
+varying vec3	color;
+
+// Same as the fixed-function lighting with GL_LIGHT0 and the front material,
+// except that the diffuse reflectivity comes from the instance.
+vec4
+lighting(vec3 P, vec3 N, vec3 Kd)
+{
+	vec4	c = gl_FrontMaterial.ambient * (gl_LightModel.ambient + gl_LightSource[0].ambient);
+
+	// Positional or directional light in the eye coordinate system
+	vec4	lp = gl_LightSource[0].position;
+	vec3	L = normalize(lp.xyz - P * lp.w);
+
+	float	lambertian = max(dot(N, L), 0.0);
+	c.rgb += lambertian * Kd * gl_LightSource[0].diffuse.rgb;
+
+	// Specular term with the non-local viewer
+	if (lambertian > 0.0)
+	{
+		vec3	H = normalize(L + vec3(0, 0, 1));
+		float	specular = pow(max(dot(N, H), 0.0), gl_FrontMaterial.shininess);
+		c.rgb += specular * gl_FrontMaterial.specular.rgb * gl_LightSource[0].specular.rgb;
+	}
+
+	c.a = 1.0;
+	return c;
+}
+
+void
+main(void)
+{
+	// Ray through this fragment: from the eye, or along -z in the orthographic viewing
+	vec3	o = vec3(0, 0, 0);
+	vec3	d = normalize(position);
+	if (gl_ProjectionMatrix[2][3] == 0.0)
+	{
+		o = position;
+		d = vec3(0, 0, -1);
+	}
+
+	// |o + t d - center| = radius
+	vec3	oc = o - center;
+	float	b = dot(d, oc);
+	float	disc = b * b - (dot(oc, oc) - radius * radius);
+	if (disc < 0.0) discard;
+
+	// Front intersection
+	vec3	P = o + (-b - sqrt(disc)) * d;
+	vec3	N = (P - center) / radius;
+
+	// Depth of the intersection instead of the billboard
+	vec4	clip = gl_ProjectionMatrix * vec4(P, 1.0);
+	float	ndcDepth = clip.z / clip.w;
+	gl_FragDepth = 0.5 * (gl_DepthRange.diff * ndcDepth + gl_DepthRange.near + gl_DepthRange.far);
+
+	gl_FragColor = lighting(P, N, color);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#ifndef __CURVE_TESSELLATION_H_
+#define __CURVE_TESSELLATION_H_
+
+#include <Eigen/Dense>
+using namespace Eigen;
+
+#include <vector>
+
+// Adaptive tessellation of cubic segments
+//
+// A segment c_0 + c_1 t + c_2 t^2 + c_3 t^3 is subdivided at t = 1/2 by de Casteljau on its
+// Bezier control points until the two inner ones are within the tolerance of the chord.
+// The curve lies in the convex hull of its control points, so that every line of the
+// polyline is within the tolerance of its piece of the curve: a flat stretch takes a single
+// line, and a tight bend as many as it needs. With the orthographic view of glOrtho() over
+// [-1, 1] in y, a tolerance of k pixels is 2 k / windowH in the world.
+//
+// The polylines are cached per segment with the coefficients they were made from, and a
+// segment is tessellated again only when its coefficients or the tolerance change. An edit
+// of a natural spline changes the second derivatives by a factor of 2 - sqrt(3) ~ 0.27 per
+// segment away from it, so that in float only the ~30 segments around the edit differ.
+typedef Matrix<float, 4, 3>	CubicCoefficients;	// c_0 to c_3, a row each
+
+struct CurveTessellation
+{
+	std::vector<CubicCoefficients>		coefficient;	// Of the cached polylines
+	std::vector<std::vector<Vector3f>>	polyline;		// From t = 0 to 1, both ends included
+	std::vector<bool>					valid;
+
+	float	tolerance;		// Max distance from the curve in the world
+	int		numVertices;	// # of the vertices of all the polylines
+	int		numTessellated;	// # of the segments tessellated since the last reset
+
+	CurveTessellation() : tolerance(0), numVertices(0), numTessellated(0) {}
+};
+
+// Appends the vertices of the segment within the tolerance to polyline, from t = 0 to 1.
+// The recursion stops at the depth anyway, i.e., 2^maxDepth lines at most.
+void	tessellateCubic(const CubicCoefficients& c, float tolerance, std::vector<Vector3f>& polyline,
+	int maxDepth = 12);
+
+void	setTessellationTolerance(CurveTessellation& s, float tolerance);	// Invalidates all
+void	resizeTessellation(CurveTessellation& s, int numSegments);
+
+// Inserts count invalid segments before the segment i, or erases -count of them from i for
+// count < 0, to keep the cache of the rest when a data point is inserted or erased. The
+// coefficients are checked anyway, so that this is only to save the tessellation.
+void	shiftTessellation(CurveTessellation& s, int i, int count);
+
+// Polyline of the segment i, tessellated again if its coefficients have changed
+const std::vector<Vector3f>&	tessellateSegment(CurveTessellation& s, int i, const CubicCoefficients& c);
+
+#endif	// __CURVE_TESSELLATION_H_
@@ -0,0 +1,373 @@
+#include "naturalCubicSpline.h"
+
+#include <algorithm>
+#include <vector>
+using namespace std;
+
+void
+solveTridiagonal(const VectorXf& lower, const VectorXf& diag, const VectorXf& upper, MatrixXf& d)
+{
+	int	n = int(diag.size());
+	if (n == 0) return;
+
+	// Forward elimination with the modified super-diagonal, every column in the same pass
+	vector<float>	u(n);
+	float*			x = d.data();
+	int				m = int(d.cols()), ld = int(d.rows());
+
+	float	s = 1 / diag[0];
+	u[0] = upper[0] * s;
+	for (int k = 0; k < m; k++) x[k * ld] *= s;
+
+	for (int i = 1; i < n; i++)
+	{
+		s = 1 / (diag[i] - lower[i] * u[i - 1]);
+		u[i] = upper[i] * s;
+		for (int k = 0; k < m; k++) x[i + k * ld] = (x[i + k * ld] - lower[i] * x[i - 1 + k * ld]) * s;
+	}
+
+	// Back substitution
+	for (int i = n - 2; i >= 0; i--)
+	{
+		for (int k = 0; k < m; k++) x[i + k * ld] -= u[i] * x[i + 1 + k * ld];
+	}
+}
+
+void
+solveTridiagonal(float lower, float diag, float upper, MatrixXf& d)
+{
+	int	n = int(d.rows());
+	if (n == 0) return;
+
+	// The modified super-diagonal u_i = upper / (diag - lower u_i-1) converges to a constant
+	// in a few rows, after which it is not stored.
+	vector<float>	u;
+	float*			x = d.data();
+	int				m = int(d.cols()), ld = n;
+
+	float	ui = upper / diag, s = 1 / diag;
+	u.push_back(ui);
+	for (int k = 0; k < m; k++) x[k * ld] *= s;
+
+	bool	converged = false;
+	for (int i = 1; i < n; i++)
+	{
+		if (!converged)
+		{
+			s = 1 / (diag - lower * ui);
+			float	next = upper * s;
+			converged = (next == ui);
+			ui = next;
+			u.push_back(ui);
+		}
+		for (int k = 0; k < m; k++) x[i + k * ld] = (x[i + k * ld] - lower * x[i - 1 + k * ld]) * s;
+	}
+
+	int	last = int(u.size()) - 1;
+	for (int i = n - 2; i >= 0; i--)
+	{
+		float	w = u[min(i, last)];
+		for (int k = 0; k < m; k++) x[i + k * ld] -= w * x[i + 1 + k * ld];
+	}
+}
+
+void
+solveCyclicTridiagonal(const VectorXf& lower, const VectorXf& diag, const VectorXf& upper, MatrixXf& d)
+{
+	int	n = int(diag.size());
+
+	// A = B + u v^T with u = (gamma, 0, ..., 0, alpha) and v = (1, 0, ..., 0, beta / gamma)
+	float	alpha = upper[n - 1], beta = lower[0], gamma = -diag[0];
+
+	VectorXf	b = diag;
+	b[0] -= gamma;
+	b[n - 1] -= alpha * beta / gamma;
+
+	MatrixXf	z = MatrixXf::Zero(n, 1);
+	z(0, 0) = gamma;
+	z(n - 1, 0) = alpha;
+
+	solveTridiagonal(lower, b, upper, d);
+	solveTridiagonal(lower, b, upper, z);
+
+	// x = y - z (v . y) / (1 + v . z)
+	float	vz = 1 + z(0, 0) + beta * z(n - 1, 0) / gamma;
+	for (int k = 0; k < d.cols(); k++)
+	{
+		float	f = (d(0, k) + beta * d(n - 1, k) / gamma) / vz;
+		d.col(k) -= f * z.col(0);
+	}
+}
+
+int
+solveNaturalCubicSpline(const MatrixXf& point, MatrixXf& c, bool closed)
+{
+	int	n = int(point.rows());
+	int	dim = int(point.cols());
+	if (n < 3) closed = false;
+
+	int	numSegments = closed ? n : n - 1;
+	if (numSegments < 1)
+	{
+		c.resize(0, dim);
+		return 0;
+	}
+
+	// Second derivatives of all the points, zero at the ends of an open curve. The right-hand
+	// sides of an open curve are those of the interior points only.
+	int			numUnknowns = closed ? n : max(n - 2, 0);
+	int			first = closed ? 0 : 1;
+	MatrixXf	M(numUnknowns, dim);
+	for (int k = 0; k < dim; k++)
+	{
+		const float*	p = point.col(k).data();
+		float*			r = M.col(k).data();
+		for (int i = 0; i < numUnknowns; i++)
+		{
+			int	j = first + i;
+			int	previous = (j > 0) ? j - 1 : n - 1, next = (j + 1 < n) ? j + 1 : 0;
+			r[i] = 6 * (p[previous] - 2 * p[j] + p[next]);
+		}
+	}
+
+	if (closed)
+	{
+		VectorXf	one = VectorXf::Ones(n);
+		solveCyclicTridiagonal(one, VectorXf::Constant(n, 4), one, M);
+	}
+	else
+	{
+		solveTridiagonal(1, 4, 1, M);
+	}
+
+	c.resize(4 * numSegments, dim);
+	for (int k = 0; k < dim; k++)
+	{
+		const float*	p = point.col(k).data();
+		const float*	m = M.col(k).data();
+		float*			q = c.col(k).data();
+		for (int i = 0; i < numSegments; i++)
+		{
+			int		j = (i + 1 < n) ? i + 1 : 0;
+			float	mi = (i >= first && i - first < numUnknowns) ? m[i - first] : 0;
+			float	mj = (j >= first && j - first < numUnknowns) ? m[j - first] : 0;
+
+			q[4 * i + 0] = p[i];
+			q[4 * i + 1] = p[j] - p[i] - (2 * mi + mj) / 6;
+			q[4 * i + 2] = mi / 2;
+			q[4 * i + 3] = (mj - mi) / 6;
+		}
+	}
+
+	return numSegments;
+}
+
+//
+// Incremental spline
+//
+
+// Closed curves of 3 or more points
+static inline bool
+isClosed(const NaturalCubicSpline& s)
+{
+	return s.closed && s.point.size() >= 3;
+}
+
+static inline void
+updateRHS(NaturalCubicSpline& s, int i)
+{
+	int	n = int(s.point.size());
+	if (i < 0 || i >= n) return;
+
+	int	previous = (i > 0) ? i - 1 : n - 1, next = (i + 1 < n) ? i + 1 : 0;
+	s.rhs[i] = 6 * (s.point[previous] - 2 * s.point[i] + s.point[next]);
+}
+
+// 1 / pivots of the rows of diagonal 4 after the first of the given diagonal, up to n rows
+static void
+extendFactors(vector<float>& factor, float firstDiag, int n)
+{
+	if (factor.empty() && n > 0) factor.push_back(1 / firstDiag);
+	while (int(factor.size()) < n) factor.push_back(1 / (4 - factor.back()));
+}
+
+// x = B^-1 x in place for the rows [first, first + m) of the tridiagonal B of ones off the
+// diagonal, with the factors of its rows and the last one given separately
+static void
+substitute(Vector3f* x, int m, const float* factor, float lastFactor)
+{
+	if (m <= 0) return;
+
+	x[0] *= factor[0];
+	for (int i = 1; i < m; i++) x[i] = (x[i] - x[i - 1]) * ((i == m - 1) ? lastFactor : factor[i]);
+	for (int i = m - 2; i >= 0; i--) x[i] -= factor[i] * x[i + 1];
+}
+
+// Sherman-Morrison with A = B + u v^T, u = (gamma, 0, ..., 0, 1), v = (1, 0, ..., 0, 1 / gamma)
+static const float	CYCLIC_GAMMA = -4;
+
+static inline float
+cyclicLastFactor(const NaturalCubicSpline& s, int n)
+{
+	return 1 / (4 - 1 / CYCLIC_GAMMA - s.cyclicFactor[n - 2]);
+}
+
+// z = B^-1 u of the closed curve, which depends only on the # of the points
+static void
+updateCyclicZ(NaturalCubicSpline& s)
+{
+	int	n = int(s.point.size());
+	if (n < 3) return;
+
+	extendFactors(s.cyclicFactor, 4 - CYCLIC_GAMMA, n);
+
+	s.cyclicZ.assign(n, Vector3f::Zero());
+	s.cyclicZ[0].setConstant(CYCLIC_GAMMA);
+	s.cyclicZ[n - 1].setConstant(1);
+	substitute(s.cyclicZ.data(), n, s.cyclicFactor.data(), cyclicLastFactor(s, n));
+}
+
+// Second derivatives from the right-hand side
+static void
+solve(NaturalCubicSpline& s)
+{
+	int	n = int(s.point.size());
+	s.M.resize(n);
+	if (n == 0) return;
+
+	if (isClosed(s))
+	{
+		copy(s.rhs.begin(), s.rhs.end(), s.M.begin());
+		substitute(s.M.data(), n, s.cyclicFactor.data(), cyclicLastFactor(s, n));
+
+		const vector<Vector3f>&	z = s.cyclicZ;
+		for (int k = 0; k < 3; k++)
+		{
+			float	f = (s.M[0][k] + s.M[n - 1][k] / CYCLIC_GAMMA) / (1 + z[0][k] + z[n - 1][k] / CYCLIC_GAMMA);
+			for (int i = 0; i < n; i++) s.M[i][k] -= f * z[i][k];
+		}
+	}
+	else
+	{
+		// Interior points only
+		s.M[0].setZero();
+		s.M[n - 1].setZero();
+		if (n > 2)
+		{
+			extendFactors(s.openFactor, 4, n - 2);
+			copy(s.rhs.begin() + 1, s.rhs.end() - 1, s.M.begin() + 1);
+			substitute(s.M.data() + 1, n - 2, s.openFactor.data(), s.openFactor[n - 3]);
+		}
+	}
+}
+
+void
+setSplinePoints(NaturalCubicSpline& s, const MatrixXf& point)
+{
+	int	n = int(point.rows());
+
+	s.point.resize(n);
+	s.rhs.resize(n);
+	for (int i = 0; i < n; i++) s.point[i] = point.row(i).transpose().head<3>();
+	for (int i = 0; i < n; i++) updateRHS(s, i);
+
+	updateCyclicZ(s);
+	solve(s);
+}
+
+void
+setSplineClosed(NaturalCubicSpline& s, bool closed)
+{
+	if (s.closed == closed) return;
+
+	s.closed = closed;
+	updateCyclicZ(s);
+	solve(s);
+}
+
+void
+moveSplinePoint(NaturalCubicSpline& s, int i, const Vector3f& p)
+{
+	int	n = int(s.point.size());
+	if (i < 0 || i >= n) return;
+
+	s.point[i] = p;
+	updateRHS(s, (i > 0) ? i - 1 : n - 1);
+	updateRHS(s, i);
+	updateRHS(s, (i + 1 < n) ? i + 1 : 0);
+
+	solve(s);
+}
+
+void
+insertSplinePoint(NaturalCubicSpline& s, int i, const Vector3f& p)
+{
+	int	n = int(s.point.size());
+	i = min(max(i, 0), n);
+
+	s.point.insert(s.point.begin() + i, p);
+	s.rhs.insert(s.rhs.begin() + i, Vector3f::Zero());
+	n++;
+
+	// The neighbors, and the ends which see each other across a closed curve
+	updateRHS(s, (i > 0) ? i - 1 : n - 1);
+	updateRHS(s, i);
+	updateRHS(s, (i + 1 < n) ? i + 1 : 0);
+	updateRHS(s, 0);
+	updateRHS(s, n - 1);
+
+	updateCyclicZ(s);
+	solve(s);
+}
+
+void
+eraseSplinePoint(NaturalCubicSpline& s, int i)
+{
+	int	n = int(s.point.size());
+	if (i < 0 || i >= n) return;
+
+	s.point.erase(s.point.begin() + i);
+	s.rhs.erase(s.rhs.begin() + i);
+	n--;
+
+	if (n > 0)
+	{
+		updateRHS(s, (i > 0) ? i - 1 : n - 1);
+		updateRHS(s, (i < n) ? i : 0);
+		updateRHS(s, 0);
+		updateRHS(s, n - 1);
+	}
+
+	updateCyclicZ(s);
+	solve(s);
+}
+
+int
+splineSegments(const NaturalCubicSpline& s)
+{
+	int	n = int(s.point.size());
+	return isClosed(s) ? n : max(n - 1, 0);
+}
+
+Matrix<float, 4, 3>
+splineCoefficients(const NaturalCubicSpline& s, int segment)
+{
+	int	i = segment, j = (i + 1 < int(s.point.size())) ? i + 1 : 0;
+
+	// The coefficients of the segment from the points and the second derivatives
+	Matrix<float, 4, 3>	c;
+	c.row(0) = s.point[i].transpose();
+	c.row(1) = (s.point[j] - s.point[i] - (2 * s.M[i] + s.M[j]) / 6).transpose();
+	c.row(2) = (s.M[i] / 2).transpose();
+	c.row(3) = ((s.M[j] - s.M[i]) / 6).transpose();
+
+	return c;
+}
+
+Vector3f
+pointOnSpline(const NaturalCubicSpline& s, int segment, float t)
+{
+	Matrix<float, 4, 3>	c = splineCoefficients(s, segment);
+
+	return (c.row(0) + (c.row(1) + (c.row(2) + c.row(3) * t) * t) * t).transpose();
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#ifndef __NATURAL_CUBIC_SPLINE_H_
+#define __NATURAL_CUBIC_SPLINE_H_
+
+#include <Eigen/Dense>
+using namespace Eigen;
+
+#include <vector>
+
+// Natural cubic splines by the second derivatives
+//
+// With the unit parameter interval of every segment, as in the 4n x 4n system of the
+// coefficients, the second derivatives M_i at the data points p_i satisfy
+//   M_i-1 + 4 M_i + M_i+1 = 6 (p_i-1 - 2 p_i + p_i+1)
+// with M_0 = M_n = 0 for an open curve, and the indices wrapping around for a closed one.
+// The tridiagonal system takes O(n) time and memory, and each segment is then
+//   c_0 = p_i,	c_1 = p_i+1 - p_i - (2 M_i + M_i+1) / 6,	c_2 = M_i / 2,	c_3 = (M_i+1 - M_i) / 6
+// in the same 4n x 3 layout as the solution of the dense system.
+
+// Thomas algorithm for the tridiagonal A of the sub-, main and super-diagonals, solving
+// A x = d for all the columns of d at once in place. lower[0] and upper[n-1] are not used.
+// There is no pivoting, which is stable for a diagonally dominant A as of the splines.
+void	solveTridiagonal(const VectorXf& lower, const VectorXf& diag, const VectorXf& upper,
+	MatrixXf& d);
+
+// Constant diagonals, e.g., of the splines, in O(1) extra memory
+void	solveTridiagonal(float lower, float diag, float upper, MatrixXf& d);
+
+// Cyclic tridiagonal A with the corners A(0, n-1) = lower[0] and A(n-1, 0) = upper[n-1],
+// by the Sherman-Morrison formula on top of two Thomas solves. n >= 3.
+void	solveCyclicTridiagonal(const VectorXf& lower, const VectorXf& diag, const VectorXf& upper,
+	MatrixXf& d);
+
+// Coefficients c of the segments through the data points, a row each, with the rows 4i to
+// 4i+3 for p_i(t) = c_0 + c_1 t + c_2 t^2 + c_3 t^3 and t in [0, 1]. A closed curve has a
+// segment from the last point back to the first as well. Returns the # of the segments.
+int		solveNaturalCubicSpline(const MatrixXf& point, MatrixXf& c, bool closed = false);
+
+// Natural cubic spline kept up to date under the edits of its data points
+//
+// The diagonals of the system are constant, so that the factors of its forward elimination
+// depend only on the row, not on the points or their number. They are computed once for
+// the longest curve so far and kept through all the edits, the only exception being the
+// last row of a closed curve. Moving a point changes 3 entries of the right-hand side, and
+// only the forward and back substitutions run again, in O(n). Inserting or erasing a point
+// shifts the arrays after it and updates the right-hand side around it. The arrays grow
+// geometrically, so that the edits of a large curve rarely allocate.
+struct NaturalCubicSpline
+{
+	std::vector<Vector3f>	point;			// Data points
+	std::vector<Vector3f>	rhs;			// 6 (p_i-1 - 2 p_i + p_i+1) of every point
+	std::vector<Vector3f>	M;				// Second derivatives at the points
+	std::vector<float>		openFactor;		// 1 / pivots of the forward elimination
+	std::vector<float>		cyclicFactor;	// Same with the corner correction of a closed curve
+	std::vector<Vector3f>	cyclicZ;		// Sherman-Morrison vector of the current # of points
+	bool					closed;
+
+	NaturalCubicSpline() : closed(false) {}
+};
+
+void	setSplinePoints(NaturalCubicSpline& s, const MatrixXf& point);	// n x 3
+void	setSplineClosed(NaturalCubicSpline& s, bool closed);
+void	moveSplinePoint(NaturalCubicSpline& s, int i, const Vector3f& p);
+void	insertSplinePoint(NaturalCubicSpline& s, int i, const Vector3f& p);	// Before i, n to append
+void	eraseSplinePoint(NaturalCubicSpline& s, int i);
+
+int			splineSegments(const NaturalCubicSpline& s);
+Vector3f	pointOnSpline(const NaturalCubicSpline& s, int segment, float t);	// t in [0, 1]
+
+// c_0 to c_3 of the segment, a row each, as the rows 4i to 4i+3 of solveNaturalCubicSpline()
+Matrix<float, 4, 3>	splineCoefficients(const NaturalCubicSpline& s, int segment);
+
+#endif	// __NATURAL_CUBIC_SPLINE_H_
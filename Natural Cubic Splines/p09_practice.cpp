@@ -1,6 +1,9 @@
 // ̿   ޸ ϴ  exercise
 
 #include "glSetup.h"
+#include "glBatch.h"
+#include "naturalCubicSpline.h"
+#include "curveTessellation.h"
 
 #include <Eigen/Dense>
 using namespace Eigen;
@@ -13,6 +16,7 @@ using namespace std;
 void init();
 void render(GLFWwindow* window);
 void reshape(GLFWwindow* window, int w, int h);
+void reshapeModernOpenGL(GLFWwindow* window, int w, int h);
 void keyboard(GLFWwindow* window, int key, int scancode, int action, int mods);
 void mouseButton(GLFWwindow* window, int button, int action, int mods);
 void mouseMove(GLFWwindow* window, double xs, double ys);
@@ -24,13 +28,21 @@ void addDataPoint(GLdouble x_ws, GLdouble y_ws);
 void eraseDataPoint(GLdouble x_ws, GLdouble y_ws);
 void dragDataPoint(GLdouble x_ws, GLdouble y_ws);
 void insertDataPoint(GLdouble x_ws, GLdouble y_ws);
+void benchmarkSplineEdits(int n = 1000000);
+void printTessellation();
 
 
 // Colors
 GLfloat bgColor[4] = { 1,1,1,1 };
 
+// Projection matrix for the batched lines and points
+Matrix4f ProjectionMatrix;
+
 // Controls
 bool sampledPointsEnabled = false;
+bool closedCurve = false;
+bool adaptiveEnabled = true;	// Adaptive tessellation instead of N_SUB_SEGMENTS
+float tolerancePixels = 0.5f;	// Max distance of the tessellation from the curve
 int N_SUB_SEGMENTS = 5; //  Ŀ ׸Ʈ  ø  ?
 
 // Picking
@@ -45,8 +57,13 @@ list<vector<GLdouble>>::iterator _iter = p.begin(); // dataPoint list iter
 int N = -1;											// curve segement -> 4
 int dataPointIdx = -1;
 
+// Spline through the data points, updated by every edit of them rather than every frame
+NaturalCubicSpline spline;
+CurveTessellation tessellation;
+
 // Samples
 vector<vector<float>> samples;
+vector<int> sampleSegment;	// Segment of the line from the previous sample to each
 int selectedEdgeIndex = -1;
 Vector3f dataPointInserted;
 
@@ -114,11 +131,10 @@ void mouseButton(GLFWwindow* window, int button, int action, int mods)
 
 void unProject(double sx, double sy, GLdouble* wx, GLdouble* wy, GLdouble* wz)
 {
-	GLdouble projection[16];
-	GLdouble modelView[16];
+	// No matrix stack in the core profile: the modelview matrix is the identity.
+	Matrix4d projection = ProjectionMatrix.cast<double>();
+	Matrix4d modelView = Matrix4d::Identity();
 	GLint viewPort[4];
-	glGetDoublev(GL_PROJECTION_MATRIX, projection);
-	glGetDoublev(GL_MODELVIEW_MATRIX, modelView);
 	glGetIntegerv(GL_VIEWPORT, viewPort);
 
 	GLfloat zCursor, winX, winY;
@@ -126,7 +142,7 @@ void unProject(double sx, double sy, GLdouble* wx, GLdouble* wy, GLdouble* wz)
 	winX = (float)sx;
 	winY = (float)viewPort[3] - (float)sy;
 
-	if (gluUnProject(winX, winY, 0, modelView, projection, viewPort, wx, wy, wz) == GLU_FALSE) {
+	if (gluUnProject(winX, winY, 0, modelView.data(), projection.data(), viewPort, wx, wy, wz) == GLU_FALSE) {
 		printf("failed to unproject\n");
 	}
 }
@@ -136,12 +152,18 @@ void addDataPoint(GLdouble x_ws, GLdouble y_ws)
 	vector<GLdouble> v = { x_ws, y_ws, 0 };
 	p.push_back(v);
 	N += 1;
+
+	insertSplinePoint(spline, N, Vector3f(float(x_ws), float(y_ws), 0));
+	shiftTessellation(tessellation, N, 1);
 }
 
 void eraseDataPoint(GLdouble x_ws, GLdouble y_ws)
 {
 	if (selectedDataPoint(x_ws, y_ws))
 	{
+		int i = int(distance(p.begin(), selectIter));
+		eraseSplinePoint(spline, i);
+		shiftTessellation(tessellation, i, -1);
 		p.erase(selectIter); //   .
 		N -= 1;
 	}
@@ -151,6 +173,8 @@ void dragDataPoint(GLdouble x_ws, GLdouble y_ws)
 {
 	(*selectIter)[0] = x_ws;
 	(*selectIter)[1] = y_ws;
+
+	moveSplinePoint(spline, int(distance(p.begin(), selectIter)), Vector3f(float(x_ws), float(y_ws), 0));
 }
 
 void insertDataPoint(GLdouble x_ws, GLdouble y_ws)
@@ -160,7 +184,7 @@ void insertDataPoint(GLdouble x_ws, GLdouble y_ws)
 		list<vector<GLdouble>>::iterator iter = p.begin();
 
 		//  egde   ° datapoint edge ˱ ؼ iter Ų.
-		for (int i = 0; i < int(selectedEdgeIndex / (N_SUB_SEGMENTS - 1))+1; i++, iter++) {}
+		for (int i = 0; i < sampleSegment[selectedEdgeIndex + 1] + 1; i++, iter++) {}
 
 		//0°  , 0~1̿  ־Ѵ. ̷ iter++ؼ  ȴ.
 		
@@ -170,8 +194,11 @@ void insertDataPoint(GLdouble x_ws, GLdouble y_ws)
 		v.push_back(0);
 
 		// iter  ̶,  տ ߰ؾϱ 
-		if (iter == p.end()) p.insert(--iter, v);
-		else p.insert(iter,v);
+		if (iter == p.end() && !closedCurve) iter--;
+		int i = int(distance(p.begin(), iter));
+		insertSplinePoint(spline, i, Vector3f(v[0], v[1], v[2]));
+		shiftTessellation(tessellation, i, 1);
+		p.insert(iter, v);
 		N += 1;
 
 	}
@@ -215,7 +242,7 @@ bool selectedEdge(GLdouble x_ws, GLdouble y_ws)
 	int minIndex;
 
 	//sample point  ȸ...
-	for (int i = 0; i < samples.size()-1; i++)
+	for (int i = 0; i + 1 < int(samples.size()); i++)
 	{
 		// samples[i] samples[i+1]   Ѵ.
 		// 
@@ -294,11 +321,12 @@ int main(int argc, char* argv[])
 	// Orthographics viewing
 	perspectiveView = false;
 
-	// Initialize the OpenGL system
-	GLFWwindow* window = initializeOpenGL(argc, argv, bgColor);
+	// Initialize the OpenGL system: true for modern OpenGL
+	GLFWwindow* window = initializeOpenGL(argc, argv, bgColor, true);
 	if (window == NULL) return -1;
 
 	// Callbacks
+	glfwSetFramebufferSizeCallback(window, reshapeModernOpenGL);
 	glfwSetKeyCallback(window, keyboard);
 	glfwSetMouseButtonCallback(window, mouseButton);
 	glfwSetCursorPosCallback(window, mouseMove);
@@ -307,17 +335,32 @@ int main(int argc, char* argv[])
 	glDisable(GL_DEPTH_TEST);
 
 	// Viewport and perspective setting
-	reshape(window, windowW, windowH);
+	reshapeModernOpenGL(window, windowW, windowH);
+
+	// Batched lines and points instead of glBegin()/glEnd() in the core profile
+	if (!createBatch("sv08_batch.glsl", "sg08_batch_line.glsl", "sf08_batch.glsl"))
+	{
+		cerr << "ERROR: Failed in createBatch()" << endl;
+		return -1;
+	}
 
 	// Initialization - Main loop - Fianlization
 	init(); //  Ǭ
 
 	while (!glfwWindowShouldClose(window))
 	{
+		beginTiming(TIMING_RENDER);
 		render(window);
-		glfwSwapBuffers(window);
+		endTiming(TIMING_RENDER);
+		swapBuffers(window);
+		beginTiming(TIMING_UPDATE);
 		glfwPollEvents();
+		endTiming(TIMING_UPDATE);
 	}
+
+	// Finalization
+	deleteBatch();
+
 	// Terminate the glfw system
 	glfwDestroyWindow(window);
 	glfwTerminate();
@@ -325,106 +368,27 @@ int main(int argc, char* argv[])
 	return 0;
 }
 
-
-
-// Linear system : Ac=b
-//	from n equations of the form:
-//	p_i(t) = c_0^i + (c_1^i * t^1) + (c_2^i * t^2) + (c_3^i * t^3)
-//
-MatrixXf A; // 4n x 4n matrix
-MatrixXf b; // 4n x 3 to solve the 3 linear systems at once
-MatrixXf c; // 4n x 3 to solve the 3 linear systems at once
-
-
-void buildLinearSystem()
+void reshapeModernOpenGL(GLFWwindow* window, int w, int h)
 {
-	// Build A and b for N segments. A is independent of the locations of the points.
-	A.resize(4 * N, 4 * N);
-	A.setZero();
-
-	b.resize(4 * N, 3);
-
-	// Equation number
-	int row = 0;
-
-	// 2n equations for the end point interpolation
-	int i = 0;
-	for (list<vector<GLdouble>>::iterator iter = p.begin(); i<N; iter++,i++,row+=2)
-	{
-		// p_i(0) = c_0^i
-		A(row, 4 * i + 0) = 1;
-
-		b(row, 0) = (*iter)[0];
-		b(row, 1) = (*iter)[1];
-		b(row, 2) = (*iter)[2];
-
-		// p_i(1) = c_0^i + c_1^i + c_2^i + c_3^i
-		A(row + 1, 4 * i + 0) = 1;
-		A(row + 1, 4 * i + 1) = 1;
-		A(row + 1, 4 * i + 2) = 1;
-		A(row + 1, 4 * i + 3) = 1;
-
-		iter++;
-		b(row + 1, 0) = (*iter)[0];
-		b(row + 1, 1) = (*iter)[1];
-		b(row + 1, 2) = (*iter)[2];
-		iter--;
-	}
-	
-
-	// (n-1) equations for the tangential con
-	for (int i = 0; i < N - 1; i++, row++)
-	{
-		A(row, 4 * i + 1) = 1;
-		A(row, 4 * i + 2) = 2;
-		A(row, 4 * i + 3) = 3;
-		A(row, 4 * i + 5) = -1;
-		
-		b(row, 0) = 0;
-		b(row, 1) = 0;
-		b(row, 2) = 0;
-	}
-
-	// (n-1) equations for the second - derivative continuity
-	for (int i = 0; i < N - 1; i++, row++)
-	{
-		A(row, 4 * i + 2) = 2;
-		A(row, 4 * i + 3) = 6;
-		A(row, 4 * i + 6) = -2;
-
-		b(row, 0) = 0;
-		b(row, 1) = 0;
-		b(row, 2) = 0;
-	}
-
-	// 2 equations for the natural boundary condition
-	{
-		A(row, 2) = 0;
-
-		b(row, 0) = 0;
-		b(row, 1) = 0;
-		b(row, 2) = 0;
-
-		row++;
-
-		// p''_(n-1)(1) = 2*c_2^(n-1) + 6*c_3^(n-1) = 0
-		A(row, 4 * (N - 1) + 2) = 2;
-		A(row, 4 * (N - 1) + 3) = 6;
-
-		b(row, 0) = 0;
-		b(row, 1) = 0;
-		b(row, 2) = 0;
-
-		row++;
-	}
-
+	// Window configuration
+	aspect = (float)w / h;
+	windowW = w;
+	windowH = h;
+
+	// Viewport
+	glViewport(0, 0, w, h);
+
+	// Same orthographic projection as setupProjectionMatrix()
+	ProjectionMatrix = orthographic<float>(-1.0 * aspect, 1.0 * aspect, -1.0, 1.0,
+		-nearDist, farDist);
+
+	// The Screen size is required for mouse interaction.
+	glfwGetWindowSize(window, &screenW, &screenH);
+	cerr << "reshape(" << w << "," << h << ")";
+	cerr << " with screen " << screenW << " x " << screenH << endl;
 }
 
 
-void solveLinearSystem()
-{
-	c = A.colPivHouseholderQr().solve(b);
-}
 
 void init()
 {
@@ -432,99 +396,154 @@ void init()
 	// Usage
 	cout << endl;
 	cout << "Keyboard Input: s for sampled points on/off" << endl;
-	cout << "Keyboard Input: up/down to increase/decrease the number of samples" << endl;
+	cout << "Keyboard Input: t for adaptive/uniform tessellation" << endl;
+	cout << "Keyboard Input: up/down to increase/decrease the number of samples or the tolerance" << endl;
+	cout << "Keyboard Input: c for open/closed curve" << endl;
+	cout << "Keyboard Input: b for the benchmark of the edits of 10^6 data points" << endl;
 	cout << "Keyboard Input: q/esc for quit" << endl;
 
 }
 
 Vector3f pointOnNaturalCubicSplineCurve(int i, float t)
 {
-	float x = c(4 * i + 0, 0) + (c(4 * i + 1, 0) + (c(4 * i + 2, 0) + c(4 * i + 3, 0) * t) * t) * t;
-	float y = c(4 * i + 0, 1) + (c(4 * i + 1, 1) + (c(4 * i + 2, 1) + c(4 * i + 3, 1) * t) * t) * t;
-	float z = c(4 * i + 0, 2) + (c(4 * i + 1, 2) + (c(4 * i + 2, 2) + c(4 * i + 3, 2) * t) * t) * t;
-	
-	return Vector3f(x, y, z);
+	return pointOnSpline(spline, i, t);
+}
+
+// Polyline of the segment i, adaptive within tolerancePixels or of N_SUB_SEGMENTS lines
+const vector<Vector3f>& segmentPolyline(int i)
+{
+	if (adaptiveEnabled) return tessellateSegment(tessellation, i, splineCoefficients(spline, i));
+
+	static vector<Vector3f> uniform;
+	uniform.clear();
+	for (int j = 0; j <= N_SUB_SEGMENTS; j++)
+	{
+		float t = (float)j / N_SUB_SEGMENTS; //[0,1]
+		uniform.push_back(pointOnNaturalCubicSplineCurve(i, t));
+	}
+	return uniform;
 }
 
 // Draw the natural cubic spline
 void drawNaturalCubicSpline()
 {
-	// Curve
-	glLineWidth(1.5f * dpiScaling);
-	glColor3f(0, 0, 0);
-	for (int i = 0; i < N; i++)
+	// 2 / windowH per pixel in the orthographic view
+	setTessellationTolerance(tessellation, tolerancePixels * 2 / windowH);
+	resizeTessellation(tessellation, splineSegments(spline));
+
+	// Curve, and the samples on it for the picking of the edges
+	batchLineWidth(1.5f * dpiScaling);
+	batchColor(0, 0, 0);
+
+	samples.clear();
+	sampleSegment.clear();
+	for (int i = 0; i < splineSegments(spline); i++)
 	{
-		// N_SUB_SEGMENTS for each curve segment
-		glBegin(GL_LINE_STRIP);
-		for (int j = 0; j <= N_SUB_SEGMENTS; j++)
+		const vector<Vector3f>& polyline = segmentPolyline(i);
+
+		batchBegin(GL_LINE_STRIP);
+		for (int j = 0; j < int(polyline.size()); j++)
 		{
-			float t = (float)j / N_SUB_SEGMENTS; //[0,1]
-			Vector3f p = pointOnNaturalCubicSplineCurve(i, t);
+			batchVertex(polyline[j].data());
 
-			glVertex3fv(p.data());
+			// The first sample of a segment is the last of the previous one.
+			if (j == 0 && i > 0) continue;
+			samples.push_back(vector<float>(polyline[j].data(), polyline[j].data() + 3));
+			sampleSegment.push_back(i);
 		}
-		glEnd();
+		batchEnd();
 	}
 
 	// Sample points at the curve
 	if (sampledPointsEnabled)
 	{
-		glPointSize(5 * dpiScaling);
-		glColor3f(0, 0, 0);
-		glBegin(GL_POINTS);
-
-		vector<vector<float>> samples_;
-		for (int i = 0; i < N; i++)
-		{	
-			// N_SUB_SEGMENTS for each curve segment
-			for (int j=1; j < N_SUB_SEGMENTS; j++)
-			{
-				vector<float> points(3);
-
-				float		t = (float)j / N_SUB_SEGMENTS;
-				Vector3f	p = pointOnNaturalCubicSplineCurve(i, t);
-				glVertex3fv(p.data());
-				points[0]=p[0];
-				points[1]=p[1];
-				points[2]=p[2];
-				samples_.push_back(points);
-			}
+		batchPointSize(5 * dpiScaling);
+		batchColor(0, 0, 0);
+		batchBegin(GL_POINTS);
+		for (int i = 0; i < splineSegments(spline); i++)
+		{
+			const vector<Vector3f>& polyline = segmentPolyline(i);
+			for (int j = 1; j + 1 < int(polyline.size()); j++)
+				batchVertex(polyline[j].data());
 		}
-		samples = samples_;
-		glEnd();
+		batchEnd();
 	}
 }
 
+// Moves, insertions and erasures of random points of a spline through n random points,
+// against solving it from scratch
+void benchmarkSplineEdits(int n)
+{
+	const int	runs = 20;
+
+	MatrixXf			point = MatrixXf::Random(n, 3), coefficient;
+	NaturalCubicSpline	s;
+	Vector3f			q(0.5f, 0.5f, 0);
+
+	cout << endl << "Spline: " << n << " data points" << endl;
+	for (int closed = 0; closed < 2; closed++)
+	{
+		setSplineClosed(s, closed != 0);
+		setSplinePoints(s, point);
+
+		double	start = glfwGetTime();
+		for (int r = 0; r < runs; r++) solveNaturalCubicSpline(point, coefficient, closed != 0);
+		double	full = (glfwGetTime() - start) / runs;
+
+		start = glfwGetTime();
+		for (int r = 0; r < runs; r++) moveSplinePoint(s, rand() % n, q);
+		double	move = (glfwGetTime() - start) / runs;
+
+		start = glfwGetTime();
+		for (int r = 0; r < runs; r++) insertSplinePoint(s, rand() % n, q);
+		double	insert = (glfwGetTime() - start) / runs;
+
+		start = glfwGetTime();
+		for (int r = 0; r < runs; r++) eraseSplinePoint(s, rand() % n);
+		double	erase = (glfwGetTime() - start) / runs;
+
+		cout << "  " << (closed ? "Closed" : "Open") << ": solve " << full * 1000.0 << " ms, move "
+			<< move * 1000.0 << " ms, insert " << insert * 1000.0 << " ms, erase "
+			<< erase * 1000.0 << " ms" << endl;
+	}
+}
+
+void printTessellation()
+{
+	if (adaptiveEnabled)
+		cout << "Tessellation: adaptive within " << tolerancePixels << " pixels, "
+			<< tessellation.numVertices << " vertices for " << splineSegments(spline)
+			<< " segments in the last frame" << endl;
+	else
+		cout << "Tessellation: uniform, " << N_SUB_SEGMENTS << " lines per segment" << endl;
+}
+
 void render(GLFWwindow* window)
 {
 	// Background color
 	glClearColor(bgColor[0], bgColor[1], bgColor[2], bgColor[3]);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	// Modelview matrix
-	glMatrixMode(GL_MODELVIEW);
-	glLoadIdentity();
-
-
 	// DATA POINTS
-	glPointSize(10 * dpiScaling);
-	glColor3f(1, 0, 0);
-	glBegin(GL_POINTS);
+	batchPointSize(10 * dpiScaling);
+	batchColor(1, 0, 0);
+	batchBegin(GL_POINTS);
 	
 	//  Ŭ dataPointIdx ׷־Ѵ.
 	for (list<vector<GLdouble>>::iterator iter = p.begin(); iter != p.end(); iter++)
 	{		
-		glVertex3f((*iter)[0], (*iter)[1], (*iter)[2]);
+		batchVertex(float((*iter)[0]), float((*iter)[1]), float((*iter)[2]));
 	}
-	glEnd();
+	batchEnd();
 	
 	
 	//   Ʈ 2 ̸̻  ׸.
 	if (N >=1) {
-		buildLinearSystem();
-		solveLinearSystem();
 		drawNaturalCubicSpline(); // Draw the natural cubic spline curve
 	}
+
+	// All the lines and points with one upload
+	batchFlush(ProjectionMatrix.data());
 }
 
 void keyboard(GLFWwindow* window, int key, int scancode, int action, int mods)
@@ -537,8 +556,19 @@ void keyboard(GLFWwindow* window, int key, int scancode, int action, int mods)
 		case GLFW_KEY_S: sampledPointsEnabled = !sampledPointsEnabled; break;
 			
 			// Number of samples
-		case GLFW_KEY_UP: N_SUB_SEGMENTS++; break;
-		case GLFW_KEY_DOWN: N_SUB_SEGMENTS = max(N_SUB_SEGMENTS - 1, 1); break;
+		case GLFW_KEY_UP:
+			if (adaptiveEnabled) tolerancePixels = max(tolerancePixels / 2, 1.0f / 64);
+			else N_SUB_SEGMENTS++;
+			printTessellation();
+			break;
+		case GLFW_KEY_DOWN:
+			if (adaptiveEnabled) tolerancePixels = min(tolerancePixels * 2, 64.0f);
+			else N_SUB_SEGMENTS = max(N_SUB_SEGMENTS - 1, 1);
+			printTessellation();
+			break;
+
+			// Adaptive/uniform tessellation
+		case GLFW_KEY_T: adaptiveEnabled = !adaptiveEnabled; printTessellation(); break;
 
 			// Add 
 		case GLFW_KEY_A: interactMode = ADD; break;
@@ -551,6 +581,12 @@ void keyboard(GLFWwindow* window, int key, int scancode, int action, int mods)
 			
 			// Insert
 		case GLFW_KEY_I: interactMode = INSERT; break;
+
+			// Open/closed curve
+		case GLFW_KEY_C: closedCurve = !closedCurve; setSplineClosed(spline, closedCurve); break;
+
+			// Benchmark
+		case GLFW_KEY_B: benchmarkSplineEdits(); break;
 			// Quit
 		case GLFW_KEY_Q:
 		case GLFW_KEY_ESCAPE: glfwSetWindowShouldClose(window, GL_TRUE); break;
@@ -0,0 +1,51 @@
+
+#version 400
+
+// Wide lines: each segment is expanded into a screen-space quad of LineWidth pixels.
+layout (lines) in;
+layout (triangle_strip, max_vertices = 4) out;
+
+in VertexData
+{
+	vec4	color;
+	float	lineDistance;
+} inData[];
+
+out VertexData
+{
+	vec4	color;
+	float	lineDistance;		// Distance from the first end point in pixels
+} outData;
+
+uniform vec2	Viewport;			// Framebuffer size in pixels
+uniform float	LineWidth = 1.0;	// In pixels
+
+void
+main(void)
+{
+	vec4	p0 = gl_in[0].gl_Position;
+	vec4	p1 = gl_in[1].gl_Position;
+
+	// End points in pixels
+	vec2	s0 = 0.5 * Viewport * p0.xy / p0.w;
+	vec2	s1 = 0.5 * Viewport * p1.xy / p1.w;
+
+	float	len = length(s1 - s0);
+	vec2	dir = (len > 0.0) ? (s1 - s0) / len : vec2(1.0, 0.0);
+
+	// Half of the width to the left of the segment, back in the normalized device coordinates
+	vec2	offset = vec2(-dir.y, dir.x) * LineWidth / Viewport;
+
+	// CCW when seen from the front so that the back face culling keeps the line
+	outData.color = inData[0].color;
+	outData.lineDistance = 0.0;
+	gl_Position = p0 + vec4(offset * p0.w, 0.0, 0.0);	EmitVertex();
+	gl_Position = p0 - vec4(offset * p0.w, 0.0, 0.0);	EmitVertex();
+
+	outData.color = inData[1].color;
+	outData.lineDistance = len;
+	gl_Position = p1 + vec4(offset * p1.w, 0.0, 0.0);	EmitVertex();
+	gl_Position = p1 - vec4(offset * p1.w, 0.0, 0.0);	EmitVertex();
+
+	EndPrimitive();
+}
@@ -0,0 +1,25 @@
+
+#version 400
+
+// Batched lines and points: the positions are already in the view coordinate system.
+layout (location = 0) in vec3 VertexPosition;
+layout (location = 1) in vec4 VertexColor;
+
+out VertexData
+{
+	vec4	color;
+	float	lineDistance;		// Distance along the line segment in pixels
+} outData;
+
+uniform mat4	ProjectionMatrix;
+uniform float	PointSize = 1.0;
+
+void
+main(void)
+{
+	outData.color = VertexColor;
+	outData.lineDistance = 0.0;
+
+	gl_PointSize = PointSize;
+	gl_Position = ProjectionMatrix * vec4(VertexPosition, 1.0);
+}